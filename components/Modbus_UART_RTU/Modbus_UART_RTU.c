@@ -19,8 +19,14 @@
 -----------*/
 #include "Modbus_UART_RTU.h"  // For THIS component
 #include <stdio.h>            // For printf
+#include <string.h>           // For memcpy (batch decode)
+#if CONFIG_IDF_TARGET_LINUX
+#include "Modbus_UART_RTU_linux.h" // HOST stand-in: RTU master on a tty / pty instead of UART + esp-modbus master
+#else
 #include "driver/uart.h"      // UART driver needed for Serial MODBUS
+#endif
 #include "esp_err.h"          // For ESP error codes
+#include "esp_timer.h"        // For latency measurement of the requests
 /*------------------
   ESP Logging: TAG 
 ------------------*/
@@ -30,7 +36,8 @@ static const char *TAG = "UART-MoB"; // TAG for logging
 /*----------------------------
    VARIABLES: Whole Component 
 ------------------------------*/
-/*static*/ void *MB_master_handle = NULL;                   // Modbus handle for all Modbus communications
+/*static*/ void *MB_master_handle = NULL;                   // Modbus handle of the FIRST bus (used by the test & read-once functions)
+void *MB_master_handles[MB_NUM_BUSES] = { NULL };       // Modbus handle per bus, each bus has its own master (UART)
 mb_parameter_descriptor_t *MB_param_descriptors = NULL; // Pointer to the parameter descriptor table
 size_t MB_num_descriptors = 0;                          // Number of descriptors in the table
 /*----------------------------
@@ -44,6 +51,37 @@ size_t MB_num_descriptors = 0;                          // Number of descriptors
 // Timeout between polls
 #define POLL_TIMEOUT_MS                 (1)
 #define POLL_TIMEOUT_TICS               (POLL_TIMEOUT_MS / portTICK_PERIOD_MS)
+// Limits to join registers to ONE block read (FC04)
+#if CONFIG_MY_MB_BLOCK_READS
+#define BLOCK_MAX_REGS                  (CONFIG_MY_MB_BLOCK_MAX_REGS)     // Max. registers read with one request
+#define BLOCK_MAX_GAP_REGS              (CONFIG_MY_MB_BLOCK_MAX_GAP_REGS) // Max. unused registers between two CIDs of a block
+#else
+#define BLOCK_MAX_REGS                  (0)  // 0 = Every CID is read with its own request
+#define BLOCK_MAX_GAP_REGS              (0)
+#endif
+// Adaptive response timeout: latency histogram per slave
+#define LAT_BUCKET_MS                   (2)    // Width of one histogram bucket
+#define LAT_NUM_BUCKETS                 (128)  // Buckets 0..126 = 0..253 ms turn-around, last bucket = overflow / timeout
+#define LAT_MAX_SLAVES                  (8)    // Max. number of tracked slaves (all buses)
+#define LAT_DECAY_SAMPLES               (1000) // Histogram is halved when it holds this many samples >> follows slow changes
+#define LAT_TUNE_INTERVAL_MS            (60000)// Min. time between two re-tunings of a bus (unless timeouts occur)
+#define LAT_TUNE_MIN_SAMPLES            (50)   // Min. samples of a slave before its histogram is used
+#define LAT_TUNE_HYSTERESIS_PCT         (20)   // Re-tune only if the new timeout differs more than this
+/*----------------------------
+   VARIABLES: Adaptive response timeout
+------------------------------*/
+typedef struct {                                        // Latency histogram of ONE slave
+    bool     used;                                      // Entry in use
+    uint8_t  bus;                                       // Bus of the slave
+    uint8_t  slave_addr;                                // Modbus Slave address
+    uint16_t count;                                     // Number of samples in the histogram
+    uint16_t buckets[LAT_NUM_BUCKETS];                  // Turn-around time (measured minus transmission time) in LAT_BUCKET_MS steps
+} mb_latency_hist_t;
+static mb_latency_hist_t MB_latency[LAT_MAX_SLAVES];    // Histograms of all slaves
+static uint32_t MB_bus_timeout_ms[MB_NUM_BUSES];                   // Active response timeout per bus
+static int64_t  MB_bus_tuned_us[MB_NUM_BUSES];                     // Time of the last tuning per bus
+static bool     MB_bus_had_timeout[MB_NUM_BUSES];                  // A timeout occurred since the last tuning
+static portMUX_TYPE MB_latency_lock = portMUX_INITIALIZER_UNLOCKED; // Poll tasks of several buses may add slaves at the same time
 /*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
   Example Data (Object) Dictionary for Modbus parameters: 
   * The CID field:            in the table must be UNIQUE.
@@ -61,21 +99,43 @@ size_t MB_num_descriptors = 0;                          // Number of descriptors
 #define MB_DEVICE_ADDR1  1 // Modbus Slave address of the device
 input_reg_params_t input_reg_params = { 0 };
 /*--------------------------------------------------------------------------------------------------
-  Init of Modubus Controller for Serial RTU
+  Configuration of all buses (menuconfig), bus 0 = the 'classic' one
+----------------------------------------------------------------------------------------------------*/
+static const mb_bus_config_t MB_bus_config[MB_NUM_BUSES] = {
+  //  UART-Port,                       TXD-Pin,                RXD-Pin,                Baudrate,                     Poll-Task core
+    { CONFIG_MY_MB_UART_PORT_NUM,      CONFIG_MY_MB_UART_TXD,  CONFIG_MY_MB_UART_RXD,  CONFIG_MY_MB_UART_BAUD_RATE,  CONFIG_MY_MB_POLL_TASK_CORE },
+#if CONFIG_MY_MB_NUM_BUSES >= 2
+    { CONFIG_MY_MB_BUS2_UART_PORT_NUM, CONFIG_MY_MB_BUS2_TXD,  CONFIG_MY_MB_BUS2_RXD,  CONFIG_MY_MB_BUS2_BAUD_RATE,  CONFIG_MY_MB_BUS2_POLL_TASK_CORE },
+#endif
+#if CONFIG_MY_MB_NUM_BUSES >= 3
+    { CONFIG_MY_MB_BUS3_UART_PORT_NUM, CONFIG_MY_MB_BUS3_TXD,  CONFIG_MY_MB_BUS3_RXD,  CONFIG_MY_MB_BUS3_BAUD_RATE,  CONFIG_MY_MB_BUS3_POLL_TASK_CORE },
+#endif
+};
+/*--------------------------------------------------------------------------------------------------
+  Init of Modubus Controller for Serial RTU (one per bus)
     source: https://docs.espressif.com/projects/esp-modbus/en/stable/esp32/port_initialization.html
 ----------------------------------------------------------------------------------------------------*/
-static esp_err_t Init_MB_Controller_SerialRTU(void)
+#if CONFIG_IDF_TARGET_LINUX
+static esp_err_t Init_MB_Controller_SerialRTU(uint8_t bus)
+{ MB_master_handles[bus] = MB_Linux_Open(bus, MB_bus_config[bus].baudrate); // tty instead of UART, 'handle' = port of the bus
+  MB_RETURN_ON_FALSE((MB_master_handles[bus] != NULL), ESP_ERR_INVALID_STATE, TAG, "-- Bus %d: tty can't be opened!", bus);
+  ESP_LOGI(TAG, "--    * Response timeout: %d ms", (int)MB_bus_timeout_ms[bus]);
+  return ESP_OK;
+}
+#else
+static esp_err_t Init_MB_Controller_SerialRTU(uint8_t bus)
 { esp_err_t err= ESP_OK; // Set default error code
+  const mb_bus_config_t *cfg = &MB_bus_config[bus];
   // --------------------------------------------------------
   //  SETUP UART-Serial without RTS needed MODBUS Serial-Mode 
   // --------------------------------------------------------
-  ESP_LOGI(TAG, "--  Initialize UART Serial.... '");
+  ESP_LOGI(TAG, "--  Initialize UART Serial for bus %d.... '", bus);
   ESP_LOGI(TAG, "--    Uses this UART Pin numbers...");
   // Set UART pins: TX and RX only
-  ESP_LOGI(TAG, "--    * TXD         GPIO: %d", CONFIG_MY_MB_UART_TXD);
-  ESP_LOGI(TAG, "--    * RXD         GPIO: %d", CONFIG_MY_MB_UART_RXD);
-  err = uart_set_pin(CONFIG_MY_MB_UART_PORT_NUM, CONFIG_MY_MB_UART_TXD, CONFIG_MY_MB_UART_RXD, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
-  ESP_ERROR_CHECK(err); // Abort if error
+  ESP_LOGI(TAG, "--    * TXD         GPIO: %d", cfg->txd);
+  ESP_LOGI(TAG, "--    * RXD         GPIO: %d", cfg->rxd);
+  err = uart_set_pin(cfg->uart_port, cfg->txd, cfg->rxd, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+  MB_RETURN_ON_FALSE((err == ESP_OK), err, TAG, "-- UART set pin of bus %d failed: %s", bus, esp_err_to_name(err)); // Also called at runtime: NO abort
   ESP_LOGI(TAG, "--    UART set pin result: %s", esp_err_to_name(err));
   // --------------------------------------------------------
   //  INITIALIZE MODBUS CONTROLLER 
@@ -83,13 +143,13 @@ static esp_err_t Init_MB_Controller_SerialRTU(void)
   ESP_LOGI(TAG, "--  Initialize Modbus CONTROLLER...'");
   // Create and fill structure for Controller >> esp_modbus_common.h
   mb_communication_info_t mbc_config = {
-    .ser_opts.port = CONFIG_MY_MB_UART_PORT_NUM,      // Use this UART Communication port number
+    .ser_opts.port = cfg->uart_port,                  // Use this UART Communication port number
     .ser_opts.mode = MB_RTU,                          // Use this MODE of Communication (MB_RTU, MB_ASCII)
-    .ser_opts.baudrate = CONFIG_MY_MB_UART_BAUD_RATE, // Use thse BAUD RATE for communication
+    .ser_opts.baudrate = cfg->baudrate,               // Use thse BAUD RATE for communication
     .ser_opts.parity = UART_PARITY_DISABLE,           // parity option for the port
     .ser_opts.uid = 0,                                // Modbus Comm. SLAVE-ID >> Unused for Master-Mode
     .ser_opts.response_tout_ms =
-            CONFIG_MY_MB_REGISTER_REPONSE_TIMEOUT,    // slave response time-out 
+            MB_bus_timeout_ms[bus],                   // slave response time-out (adaptive, see Modbus_Tune_Response_Timeout)
     .ser_opts.data_bits = UART_DATA_8_BITS,           // number of data bits for communication port
     .ser_opts.stop_bits = UART_STOP_BITS_1,           // number of stop bits for the communication port
   };
@@ -129,25 +189,25 @@ static esp_err_t Init_MB_Controller_SerialRTU(void)
   ESP_LOGI(TAG, "--  Use this Controller parameters:");
   ESP_LOGI(TAG, "--    * Port:         UART%d", mbc_config.ser_opts.port);
   ESP_LOGI(TAG, "--    * Comm. Mode:       %s", commMode);
-  ESP_LOGI(TAG, "--    * Baudrate:         %d", CONFIG_MY_MB_UART_BAUD_RATE);
+  ESP_LOGI(TAG, "--    * Baudrate:         %d", cfg->baudrate);
   ESP_LOGI(TAG, "--    * Data bits:        %d", data_bits);
   ESP_LOGI(TAG, "--    * Stop bits:        %s", stop_bits);
   ESP_LOGI(TAG, "--    * Parity:           %s", parity);
   ESP_LOGI(TAG, "--    * Response timeout: %d ms", response_timeout);
   // Do the initialization
-  err = mbc_master_create_serial(&mbc_config, &MB_master_handle);
-  ESP_ERROR_CHECK(err); // Abort if error  
-      MB_RETURN_ON_FALSE((MB_master_handle != NULL), ESP_ERR_INVALID_STATE, TAG, "-- MB-Handler is NULL! > Controller initialization fail!");
-      MB_RETURN_ON_FALSE((err == ESP_OK), ESP_ERR_INVALID_STATE, TAG,            "-- MB-Controller initialization fail: Returns(0x%x).", (int)err);
+  err = mbc_master_create_serial(&mbc_config, &MB_master_handles[bus]);
+      MB_RETURN_ON_FALSE((err == ESP_OK), err, TAG,                              "-- MB-Controller initialization fail: Returns(0x%x).", (int)err);
+      MB_RETURN_ON_FALSE((MB_master_handles[bus] != NULL), ESP_ERR_INVALID_STATE, TAG, "-- MB-Handler is NULL! > Controller initialization fail!");
   return err;
 }
+#endif // CONFIG_IDF_TARGET_LINUX
 
 
 /*--------------------------------------------------------
   Read_Registers_Once:
   Request to read Modbus parameters from slave device
 ---------------------------------------------------------*/ 
-#if CONFIG_MY_MB_READ_REGS_ONCE_WHEN_DESC_SET // menu config option
+#if CONFIG_MY_MB_READ_REGS_ONCE_WHEN_DESC_SET && !CONFIG_IDF_TARGET_LINUX // menu config option
 static void Read_Registers_Once() { // Read_Registers_Once 
   // Set StartPoint for variable and constant
   esp_err_t err = ESP_OK;
@@ -204,6 +264,7 @@ static void Read_Registers_Once() { // Read_Registers_Once
 }
 #endif
 
+#if !CONFIG_IDF_TARGET_LINUX // UART tests need the real UART
 /*--------------------------------------------------------------------------------------------------
   Write_bytes_to_UART: Test Adapter to RS485 connected to UART
   Does the TX-Blink on the RS485-Adapter?
@@ -243,6 +304,7 @@ void Test_UART_withConfig(void)
     ESP_LOGI(TAG, "~~~ !!! KILLED UART used for test.");
     ESP_ERROR_CHECK(uart_driver_delete(CONFIG_MY_MB_UART_PORT_NUM)); // Uninstall the UART driver
 }
+#endif // !CONFIG_IDF_TARGET_LINUX
 
 /*------------------------------------------------------------
   Public FUNCTION of this component: Start_Modbus_RTU_Workers
@@ -272,28 +334,40 @@ esp_err_t Start_Modbus_RTU_Workers(void **mb_handle_out, mb_parameter_descriptor
     1. uart_set_pin
     2. mbc_master_create_serial
   *------------------------------*/
-  err = Init_MB_Controller_SerialRTU(); // Initialize Modbus controller
+  for (uint8_t bus = 1; bus < MB_NUM_BUSES; bus++) { // Each bus needs its OWN UART
+      for (uint8_t other = 0; other < bus; other++) {
+          MB_RETURN_ON_FALSE((MB_bus_config[bus].uart_port != MB_bus_config[other].uart_port), ESP_ERR_INVALID_ARG, TAG,
+                             "-- Bus %d and bus %d use the same UART%d!", other, bus, MB_bus_config[bus].uart_port); } }
+  for (uint8_t bus = 0; bus < MB_NUM_BUSES; bus++) { // Every bus gets its own Modbus master
+    MB_bus_timeout_ms[bus] = CONFIG_MY_MB_REGISTER_REPONSE_TIMEOUT; // Start with the configured (=max.) timeout
+    MB_bus_tuned_us[bus] = esp_timer_get_time();
+    err = Init_MB_Controller_SerialRTU(bus); // Initialize Modbus controller
+    MB_RETURN_ON_FALSE((err == ESP_OK), err, TAG, "-- Bus %d: Controller initialization fail!", bus);
+#if !CONFIG_IDF_TARGET_LINUX // Host stand-in: no descriptors, no controller to start
 //  Write_bytes_to_UART(); // un-comment for check if UART RS485 Interface TX LED is blinking? 
-  /*-----------------------------
-    3. mbc_master_set_descriptor
-  *------------------------------*/
-  ESP_LOGI(TAG, "--  Set Descriptors to MB-Controller:");
-  ESP_LOGI(TAG, "--    * How many?:     %d CIDs", MB_num_descriptors);
-  err= mbc_master_set_descriptor(MB_master_handle, &MB_param_descriptors[0], MB_num_descriptors ); // Use the Descriptors received from the caller of this function/component
-  ESP_ERROR_CHECK(err); // Abort if error
-  if (err != ESP_OK) {
-    ESP_LOGE(TAG, "--    * Set Descriptor failed: %d", err);
-    return err;
-  } else {  
-    ESP_LOGI(TAG, "--    * Set Descriptor accepted.");
-    ESP_LOGI(TAG, "--    * MB_master_handle: %p", MB_master_handle);
-  } 
-  /*-----------------------------
-    4. mbc_master_start
-  *------------------------------*/
-  err = mbc_master_start(MB_master_handle);
-  ESP_ERROR_CHECK(err); // Abort if error
-  // Hand over the handle to the caller
+    /*-----------------------------
+      3. mbc_master_set_descriptor
+    *------------------------------*/
+    ESP_LOGI(TAG, "--  Set Descriptors to MB-Controller of bus %d:", bus);
+    ESP_LOGI(TAG, "--    * How many?:     %d CIDs", MB_num_descriptors);
+    err= mbc_master_set_descriptor(MB_master_handles[bus], &MB_param_descriptors[0], MB_num_descriptors ); // Use the Descriptors received from the caller of this function/component
+    ESP_ERROR_CHECK(err); // Abort if error
+    if (err != ESP_OK) {
+      ESP_LOGE(TAG, "--    * Set Descriptor failed: %d", err);
+      return err;
+    } else {  
+      ESP_LOGI(TAG, "--    * Set Descriptor accepted.");
+      ESP_LOGI(TAG, "--    * MB_master_handle: %p", MB_master_handles[bus]);
+    } 
+    /*-----------------------------
+      4. mbc_master_start
+    *------------------------------*/
+    err = mbc_master_start(MB_master_handles[bus]);
+    ESP_ERROR_CHECK(err); // Abort if error
+#endif
+  }
+  MB_master_handle = MB_master_handles[0];
+  // Hand over the handle (of the first bus) to the caller
   if (mb_handle_out != NULL) { *mb_handle_out = MB_master_handle;} // Set the handle to the caller
   vTaskDelay(50);
   MB_RETURN_ON_FALSE((err == ESP_OK), ESP_ERR_INVALID_STATE, TAG, "!!  MB Cntroller start fail, returned (0x%x).", (int)err);
@@ -301,7 +375,7 @@ esp_err_t Start_Modbus_RTU_Workers(void **mb_handle_out, mb_parameter_descriptor
   /*-----------------------------
     5. Read_Registers_Once (OWN)
   *------------------------------*/ 
-  #if CONFIG_MY_MB_READ_REGS_ONCE_WHEN_DESC_SET // menu config option
+  #if CONFIG_MY_MB_READ_REGS_ONCE_WHEN_DESC_SET && !CONFIG_IDF_TARGET_LINUX // menu config option
     // Read all Modbus registers once. The one defined in the descriptor table 'mb_descriptors_in'
     Read_Registers_Once(); // Read all Modbus registers once. The one defined in the descriptor table 'mb_descriptors_in'
   #endif
@@ -312,4 +386,265 @@ esp_err_t Start_Modbus_RTU_Workers(void **mb_handle_out, mb_parameter_descriptor
   return err;
 };
 
+/*--------------------------------
+  Holds [reg_from, reg_to) of the slave a register of a NOT readable CID? >> This gap must not be bridged
+  (Slave addresses of other buses are not told apart: costs only one more block read)
+----------------------------------*/
+static bool Gap_Has_Unreadable(uint8_t slave_addr, uint16_t reg_from, uint16_t reg_to)
+{ for (size_t c = 0; c < MB_num_descriptors && reg_from < reg_to; c++) {
+      const mb_parameter_descriptor_t *p = &MB_param_descriptors[c];
+      if (p->mb_slave_addr != slave_addr || (p->access & PAR_PERMS_READ)) { continue; }
+      if (p->mb_reg_start < reg_to && p->mb_reg_start + p->mb_size > reg_from) { return true; } }
+  return false;
+}
+
+/*------------------------------------------------------------
+  Public FUNCTION of this component: Modbus_Plan_Block_Reads
+-------------------------------------------------------------*/
+size_t Modbus_Plan_Block_Reads(uint8_t bus, uint16_t *cids_inout, size_t num_cids, mb_block_read_t *blocks_out, size_t max_blocks)
+{ size_t num_blocks = 0; // Number of planned blocks
+  if (cids_inout == NULL || blocks_out == NULL || MB_param_descriptors == NULL || bus >= MB_NUM_BUSES) { return 0; }
+  //-------------------------------------------------
+  // 1. Sort CIDs by Slave-Address and Register-Start
+  //    (Insertion-Sort: lists are short & mostly sorted)
+  //-------------------------------------------------
+  for (size_t i = 1; i < num_cids; i++) {
+      uint16_t cid = cids_inout[i];
+      const mb_parameter_descriptor_t *d = &MB_param_descriptors[cid];
+      size_t j = i;
+      while (j > 0) {
+          const mb_parameter_descriptor_t *p = &MB_param_descriptors[cids_inout[j-1]];
+          if (p->mb_slave_addr < d->mb_slave_addr ||
+             (p->mb_slave_addr == d->mb_slave_addr && p->mb_reg_start <= d->mb_reg_start)) { break; }
+          cids_inout[j] = cids_inout[j-1];
+          j--;
+      }
+      cids_inout[j] = cid;
+  }
+  //-------------------------------------------------
+  // 2. Join neighbouring registers to blocks
+  //-------------------------------------------------
+  mb_block_read_t *blk = NULL; // Block currently filled
+  for (size_t i = 0; i < num_cids; i++) {
+      const mb_parameter_descriptor_t *d = &MB_param_descriptors[cids_inout[i]];
+      if (blk != NULL && blk->slave_addr == d->mb_slave_addr) {
+          uint16_t blk_end = blk->reg_start + blk->reg_count;  // First register AFTER current block
+          uint16_t new_end = d->mb_reg_start + d->mb_size;     // First register AFTER this CID
+          if (new_end < blk_end) { new_end = blk_end; }        // CID lies completely within the block
+          if ((d->mb_reg_start <= blk_end + BLOCK_MAX_GAP_REGS) && // Gap small enough?
+              (new_end - blk->reg_start <= BLOCK_MAX_REGS) &&      // Block not too long?
+              !Gap_Has_Unreadable(d->mb_slave_addr, blk_end, d->mb_reg_start)) { // NO rejected register in the gap?
+              blk->reg_count = new_end - blk->reg_start;       // >> Extend the block
+              blk->num_cids++;
+              continue;
+          }
+      }
+      // Start a NEW block
+      if (num_blocks >= max_blocks) { ESP_LOGE(TAG, "!!  Read-Plan needs more than %d blocks!", (int)max_blocks); break; }
+      blk = &blocks_out[num_blocks++];
+      blk->bus        = bus;
+      blk->slave_addr = d->mb_slave_addr;
+      blk->reg_start  = d->mb_reg_start;
+      blk->reg_count  = d->mb_size;
+      blk->first      = i;
+      blk->num_cids   = 1;
+  }
+  return num_blocks;
+}
+
+/*--------------------------------------------------------------------------------------------------
+  Frame_Time_ms: Time to transmit request + response of a FC04 read on the wire
+    RTU: 1 start + 8 data + 1 stop = 10 bits per byte (no parity)
+    Request 8 bytes, Response 5 bytes + 2 per register
+----------------------------------------------------------------------------------------------------*/
+static uint32_t Frame_Time_ms(uint8_t bus, uint16_t reg_count)
+{ uint32_t bytes = 8 + 5 + 2 * reg_count;
+  return (bytes * 10 * 1000 + MB_bus_config[bus].baudrate - 1) / MB_bus_config[bus].baudrate;
+}
+
+/*--------------------------------------------------------------------------------------------------
+  Record_Latency: Add one measured request to the histogram of its slave
+    latency_ms = UINT32_MAX >> request timed out (counted in the overflow bucket)
+----------------------------------------------------------------------------------------------------*/
+static void Record_Latency(const mb_block_read_t *block, uint32_t latency_ms)
+{ mb_latency_hist_t *h = NULL;
+  for (int i = 0; i < LAT_MAX_SLAVES && h == NULL; i++) {  // Find the slave ...
+      if (MB_latency[i].used && MB_latency[i].bus == block->bus && MB_latency[i].slave_addr == block->slave_addr) { h = &MB_latency[i]; } }
+  portENTER_CRITICAL(&MB_latency_lock);
+  for (int i = 0; i < LAT_MAX_SLAVES && h == NULL; i++) {  // ... or a free entry for it
+      if (!MB_latency[i].used) { h = &MB_latency[i]; h->bus = block->bus; h->slave_addr = block->slave_addr; h->used = true; } }
+  portEXIT_CRITICAL(&MB_latency_lock);
+  if (h == NULL) { return; }                               // Table full >> slave not tracked
+  uint32_t bucket = LAT_NUM_BUCKETS - 1;                   // Overflow / timeout
+  if (latency_ms != UINT32_MAX) {
+      uint32_t frame_ms = Frame_Time_ms(block->bus, block->reg_count);
+      uint32_t turnaround_ms = (latency_ms > frame_ms) ? latency_ms - frame_ms : 0;
+      if (turnaround_ms / LAT_BUCKET_MS < LAT_NUM_BUCKETS - 1) { bucket = turnaround_ms / LAT_BUCKET_MS; }
+  } else {
+      MB_bus_had_timeout[block->bus] = true;
+  }
+  h->buckets[bucket]++;
+  if (++h->count >= LAT_DECAY_SAMPLES) {                   // Halve: old samples fade out
+      h->count = 0;
+      for (int b = 0; b < LAT_NUM_BUCKETS; b++) { h->buckets[b] /= 2; h->count += h->buckets[b]; } }
+}
+
+/*------------------------------------------------------------
+  Public FUNCTION of this component: Modbus_Get_Latency_Percentile
+-------------------------------------------------------------*/
+uint32_t Modbus_Get_Latency_Percentile(uint8_t bus, uint8_t slave_addr, uint8_t percentile)
+{ for (int i = 0; i < LAT_MAX_SLAVES; i++) {
+      const mb_latency_hist_t *h = &MB_latency[i];
+      if (!h->used || h->bus != bus || h->slave_addr != slave_addr || h->count == 0) { continue; }
+      uint32_t rank = ((uint32_t)h->count * percentile + 99) / 100;  // Samples at or below the percentile
+      uint32_t sum = 0;
+      for (int b = 0; b < LAT_NUM_BUCKETS; b++) {
+          sum += h->buckets[b];
+          if (sum >= rank) { return (b == LAT_NUM_BUCKETS - 1) ? UINT32_MAX : (uint32_t)(b + 1) * LAT_BUCKET_MS; } }
+  }
+  return 0; // No samples
+}
+
+/*------------------------------------------------------------
+  Public FUNCTION of this component: Modbus_Get_Response_Timeout
+-------------------------------------------------------------*/
+uint32_t Modbus_Get_Response_Timeout(uint8_t bus)
+{ return (bus < MB_NUM_BUSES) ? MB_bus_timeout_ms[bus] : 0;
+}
+
+#if CONFIG_MY_MB_ADAPTIVE_TIMEOUT && !CONFIG_IDF_TARGET_LINUX
+/*--------------------------------
+  (Re-)create, describe & start the master of a bus with the timeout MB_bus_timeout_ms[bus]
+  On error the half-made master is deleted again (handle NULL)
+----------------------------------*/
+static esp_err_t Create_MB_Master(uint8_t bus)
+{ esp_err_t err = Init_MB_Controller_SerialRTU(bus);
+  if (err == ESP_OK) { err = mbc_master_set_descriptor(MB_master_handles[bus], &MB_param_descriptors[0], MB_num_descriptors); }
+  if (err == ESP_OK) { err = mbc_master_start(MB_master_handles[bus]); }
+  if (err != ESP_OK && MB_master_handles[bus] != NULL) { mbc_master_delete(MB_master_handles[bus]); MB_master_handles[bus] = NULL; }
+  if (bus == 0) { MB_master_handle = MB_master_handles[0]; }
+  return err;
+}
+#endif
+
+/*------------------------------------------------------------
+  Public FUNCTION of this component: Modbus_Tune_Response_Timeout
+-------------------------------------------------------------*/
+esp_err_t Modbus_Tune_Response_Timeout(uint8_t bus)
+{
+#if CONFIG_MY_MB_ADAPTIVE_TIMEOUT
+  MB_RETURN_ON_FALSE((bus < MB_NUM_BUSES && MB_master_handles[bus] != NULL), ESP_ERR_INVALID_STATE, TAG, "-- Bus %d not started!", bus);
+  int64_t now_us = esp_timer_get_time();
+  if (!MB_bus_had_timeout[bus] && (now_us - MB_bus_tuned_us[bus]) < (int64_t)LAT_TUNE_INTERVAL_MS * 1000) { return ESP_OK; } // Not yet
+  MB_bus_tuned_us[bus] = now_us;
+  MB_bus_had_timeout[bus] = false;
+  //-------------------------------------------------
+  // 1. Target = slowest slave of the bus: percentile of its turn-around + margin + transmission of the longest block
+  //-------------------------------------------------
+  uint32_t turnaround_ms = 0;
+  bool enough_samples = false;
+  for (int i = 0; i < LAT_MAX_SLAVES; i++) {
+      if (!MB_latency[i].used || MB_latency[i].bus != bus) { continue; }
+      if (MB_latency[i].count < LAT_TUNE_MIN_SAMPLES) { return ESP_OK; } // A slave of the bus is not known well enough
+      uint32_t p = Modbus_Get_Latency_Percentile(bus, MB_latency[i].slave_addr, CONFIG_MY_MB_TIMEOUT_PERCENTILE);
+      if (p > turnaround_ms) { turnaround_ms = p; }
+      enough_samples = true;
+  }
+  if (!enough_samples) { return ESP_OK; }
+  uint32_t max_regs = (BLOCK_MAX_REGS > 2) ? BLOCK_MAX_REGS : 2;
+  uint32_t target_ms = (turnaround_ms == UINT32_MAX) ? CONFIG_MY_MB_REGISTER_REPONSE_TIMEOUT
+                     : turnaround_ms + CONFIG_MY_MB_TIMEOUT_MARGIN_MS + Frame_Time_ms(bus, max_regs);
+  if (target_ms < CONFIG_MY_MB_TIMEOUT_MIN_MS)          { target_ms = CONFIG_MY_MB_TIMEOUT_MIN_MS; }
+  if (target_ms > CONFIG_MY_MB_REGISTER_REPONSE_TIMEOUT) { target_ms = CONFIG_MY_MB_REGISTER_REPONSE_TIMEOUT; }
+  //-------------------------------------------------
+  // 2. Apply only if it differs enough (re-creating the master costs some ms)
+  //-------------------------------------------------
+  uint32_t active_ms = MB_bus_timeout_ms[bus];
+  uint32_t diff_ms = (target_ms > active_ms) ? target_ms - active_ms : active_ms - target_ms;
+  if (diff_ms * 100 <= active_ms * LAT_TUNE_HYSTERESIS_PCT) { return ESP_OK; }
+  ESP_LOGI(TAG, "--  Bus %d: response timeout %"PRIu32" ms >> %"PRIu32" ms (p%d turn-around %"PRIu32" ms)", 
+           bus, active_ms, target_ms, CONFIG_MY_MB_TIMEOUT_PERCENTILE, turnaround_ms);
+#if CONFIG_IDF_TARGET_LINUX
+  MB_bus_timeout_ms[bus] = target_ms;                 // Host stand-in takes the timeout with every request
+#else
+  // esp-modbus takes the timeout only when the master is created >> Re-create the master of this bus
+  esp_err_t err = mbc_master_delete(MB_master_handles[bus]);
+  MB_RETURN_ON_FALSE((err == ESP_OK), err, TAG, "-- Delete of master bus %d failed: %s", bus, esp_err_to_name(err));
+  MB_master_handles[bus] = NULL;
+  MB_bus_timeout_ms[bus] = target_ms;
+  err = Create_MB_Master(bus);
+  if (err != ESP_OK) {                                // Keep the bus alive: back to the timeout that worked
+      ESP_LOGE(TAG, "-- Re-start of master bus %d failed: %s >> back to %"PRIu32" ms", bus, esp_err_to_name(err), active_ms);
+      MB_bus_timeout_ms[bus] = active_ms;
+      esp_err_t err_old = Create_MB_Master(bus);
+      MB_RETURN_ON_FALSE((err_old == ESP_OK), err_old, TAG, "-- Bus %d is down: %s", bus, esp_err_to_name(err_old));
+      return err; }
+#endif
+#endif
+  return ESP_OK;
+}
 
+/*------------------------------------------------------------
+  Public FUNCTION of this component: Modbus_Read_Block
+-------------------------------------------------------------*/
+esp_err_t Modbus_Read_Block(const mb_block_read_t *block, uint16_t *regs_out)
+{ MB_RETURN_ON_FALSE((block != NULL && regs_out != NULL), ESP_ERR_INVALID_ARG, TAG, "-- Block or buffer is NULL!");
+  MB_RETURN_ON_FALSE((block->reg_count <= MB_FC04_MAX_REGS), ESP_ERR_INVALID_SIZE, TAG, "-- Block too long: %d regs", block->reg_count);
+  MB_RETURN_ON_FALSE((block->bus < MB_NUM_BUSES && MB_master_handles[block->bus] != NULL), ESP_ERR_INVALID_STATE, TAG, "-- Bus %d not started!", block->bus);
+  mb_param_request_t request = {
+    .slave_addr = block->slave_addr,                 // Slave to read from
+    .command    = MB_FC_READ_INPUT_REGISTERS,        // FC04
+    .reg_start  = block->reg_start,                  // First register
+    .reg_size   = block->reg_count                   // Number of registers
+  };
+  int64_t start_us = esp_timer_get_time();
+#if CONFIG_IDF_TARGET_LINUX
+  esp_err_t err = MB_Linux_Read_Input_Registers(MB_master_handles[block->bus], request.slave_addr, request.reg_start, request.reg_size,
+                                                regs_out, MB_bus_timeout_ms[block->bus]);
+#else
+  esp_err_t err = mbc_master_send_request(MB_master_handles[block->bus], &request, regs_out);
+#endif
+  #if CONFIG_MY_MB_ADAPTIVE_TIMEOUT
+  if (err == ESP_OK || err == ESP_ERR_TIMEOUT) { // Other errors say nothing about the latency
+      Record_Latency(block, (err == ESP_OK) ? (uint32_t)((esp_timer_get_time() - start_us) / 1000) : UINT32_MAX); }
+  #endif
+  (void)start_us;
+  return err;
+}
+
+/*------------------------------------------------------------
+  Public FUNCTION of this component: Modbus_Decode_Floats_CDAB
+  (runs for every block read: keep it tight)
+-------------------------------------------------------------*/
+void Modbus_Decode_Floats_CDAB(const uint16_t *regs, size_t num_floats, float *values_out)
+{ for (size_t k = 0; k < num_floats; k++) {
+      uint32_t w;
+      memcpy(&w, &regs[2 * k], sizeof(w));     // ONE 32-bit load of both registers (compiles to a plain load)
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+      w = (w << 16) | (w >> 16);                // Register with the LOWER address is the HIGH word (rotate)
+#endif
+      memcpy(&values_out[k], &w, sizeof(w)); }  // Bits of the IEEE-754 float
+}
+
+/*------------------------------------------------------------
+  Public FUNCTION of this component: Modbus_Get_Bus_Config
+-------------------------------------------------------------*/
+const mb_bus_config_t *Modbus_Get_Bus_Config(uint8_t bus)
+{ return (bus < MB_NUM_BUSES) ? &MB_bus_config[bus] : NULL;
+}
+
+/*------------------------------------------------------------
+  Public FUNCTION of this component: Modbus_Set_CID_Readable
+-------------------------------------------------------------*/
+void Modbus_Set_CID_Readable(uint16_t cid, bool readable)
+{ if (MB_param_descriptors == NULL || cid >= MB_num_descriptors) { return; }
+  mb_parameter_descriptor_t *d = &MB_param_descriptors[cid];
+  d->access = (mb_param_perms_t)(readable ? (d->access | PAR_PERMS_READ) : (d->access & ~PAR_PERMS_READ));
+}
+
+/*------------------------------------------------------------
+  Public FUNCTION of this component: Modbus_Get_CID_Offset
+-------------------------------------------------------------*/
+uint16_t Modbus_Get_CID_Offset(uint16_t cid, const mb_block_read_t *block)
+{ return MB_param_descriptors[cid].mb_reg_start - block->reg_start;
+}
@@ -0,0 +1,134 @@
+/*===========================================================================================
+ * @file        Modbus_UART_RTU_linux.c
+ * @brief       HOST stand-in of the serial Modbus master for the ESP-IDF linux target
+ *
+ * The linux target has no UART driver, so the Modbus master of this component
+ * talks RTU itself on a tty / pty:
+ *    * ONE request, ONE answer, no queueing (each bus has ONE poll task).
+ *    * The answer is complete when its expected length has arrived.
+ *    * CRC, slave address and function code of the answer are checked.
+ * Only what the poll tasks need is implemented: FC04 'Read Input Registers'.
+========================================================================================================*/
+/*----------
+   INCLUDES
+-----------*/
+#include "Modbus_UART_RTU_linux.h"  // For THIS file
+#include "Modbus_UART_RTU.h"        // For MB_ERR_EXCEPTION
+#include "sdkconfig.h"
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <termios.h>
+#include "esp_timer.h"
+/*------------------
+  ESP Logging: TAG
+------------------*/
+#include <esp_log.h>                 // For ESP-logging
+static const char *TAG = "UART-Lnx"; // TAG for logging
+/*                        12345678 */
+/*----------------------------
+   Constants via #define
+------------------------------*/
+#define MB_LINUX_MAX_BUSES      (3)    // Same as the max. of CONFIG_MY_MB_NUM_BUSES
+#define MB_LINUX_FC04           (0x04) // Read Input Registers
+/*----------------------------
+   VARIABLES
+------------------------------*/
+typedef struct {
+    int      fd;                // File descriptor of the tty
+    uint8_t  bus;               // Bus number (for logging)
+} mb_linux_port_t;
+static mb_linux_port_t MB_linux_ports[MB_LINUX_MAX_BUSES];
+
+/*--------------------------------------------------------------------------------------------------
+  CRC16: Modbus CRC (poly 0xA001, init 0xFFFF), sent LOW byte first
+----------------------------------------------------------------------------------------------------*/
+static uint16_t MB_Linux_CRC16(const uint8_t *buf, size_t len)
+{ uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < len; i++) {
+      crc ^= buf[i];
+      for (int b = 0; b < 8; b++) { crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1; } }
+  return crc;
+}
+
+/*--------------------------------------------------------------------------------------------------
+  Baudrate >> termios speed (a pty ignores it, a real USB-RS485 adapter needs it)
+----------------------------------------------------------------------------------------------------*/
+static speed_t MB_Linux_Speed(int baudrate)
+{ switch (baudrate) {
+      case 1200:   return B1200;   case 2400:   return B2400;   case 4800:  return B4800;
+      case 9600:   return B9600;   case 19200:  return B19200;  case 38400: return B38400;
+      case 57600:  return B57600;  default:     return B115200; }
+}
+
+/*------------------------------------------------------------
+  MB_Linux_Open: Open the tty of a bus
+-------------------------------------------------------------*/
+void *MB_Linux_Open(uint8_t bus, int baudrate)
+{ if (bus >= MB_LINUX_MAX_BUSES) { return NULL; }
+  char path[64];
+  snprintf(path, sizeof(path), CONFIG_MY_MB_LINUX_TTY, bus);
+  int fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (fd < 0) { ESP_LOGE(TAG, "--  ❌ Bus %d: Can't open '%s': %s (simulator running?)", bus, path, strerror(errno)); return NULL; }
+  struct termios tio;
+  if (tcgetattr(fd, &tio) == 0) {
+      cfmakeraw(&tio);                                 // 8N1, binary, no echo
+      cfsetspeed(&tio, MB_Linux_Speed(baudrate));
+      tio.c_cflag |= CLOCAL | CREAD;
+      tcsetattr(fd, TCSANOW, &tio); }
+  MB_linux_ports[bus].fd  = fd;
+  MB_linux_ports[bus].bus = bus;
+  ESP_LOGI(TAG, "--  ✅ Bus %d: Modbus RTU on '%s' (host stand-in of UART%d)", bus, path, bus);
+  return &MB_linux_ports[bus];
+}
+
+/*------------------------------------------------------------
+  MB_Linux_Read_Input_Registers: ONE FC04 request
+-------------------------------------------------------------*/
+esp_err_t MB_Linux_Read_Input_Registers(void *handle, uint8_t slave_addr, uint16_t reg_start, uint16_t count,
+                                        uint16_t *regs_out, uint32_t timeout_ms)
+{ mb_linux_port_t *port = (mb_linux_port_t *)handle;
+  if (port == NULL || port->fd < 0 || count == 0 || count > 125) { return ESP_ERR_INVALID_ARG; }
+  //-------------------------------------------------
+  // 1. Send the request (drop any late answer of an earlier one first)
+  //-------------------------------------------------
+  uint8_t frame[5 + 2 * 125];
+  uint8_t req[8] = { slave_addr, MB_LINUX_FC04, reg_start >> 8, reg_start & 0xFF, count >> 8, count & 0xFF };
+  uint16_t crc = MB_Linux_CRC16(req, 6);
+  req[6] = crc & 0xFF;
+  req[7] = crc >> 8;
+  tcflush(port->fd, TCIFLUSH);
+  if (write(port->fd, req, sizeof(req)) != (ssize_t)sizeof(req)) { return ESP_FAIL; }
+  //-------------------------------------------------
+  // 2. Receive until the answer is complete or the timeout is over
+  //-------------------------------------------------
+  size_t expected = 5 + 2 * count;                    // Addr, FC, byte count, data, CRC
+  size_t len = 0;
+  int64_t deadline_us = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+  while (len < expected) {
+      int wait_ms = (int)((deadline_us - esp_timer_get_time() + 999) / 1000);
+      if (wait_ms <= 0) { return ESP_ERR_TIMEOUT; }
+      struct pollfd pfd = { .fd = port->fd, .events = POLLIN };
+      int rc = poll(&pfd, 1, wait_ms);
+      if (rc < 0 && errno == EINTR) { continue; }
+      if (rc <= 0) { return ESP_ERR_TIMEOUT; }
+      ssize_t n = read(port->fd, frame + len, expected - len);
+      if (n > 0) { len += (size_t)n; }
+      if (len >= 2 && (frame[1] & 0x80)) { expected = 5; } // Exception answer is shorter
+  }
+  //-------------------------------------------------
+  // 3. Check & copy
+  //-------------------------------------------------
+  if (MB_Linux_CRC16(frame, len - 2) != (frame[len - 2] | (frame[len - 1] << 8))) { return ESP_ERR_INVALID_CRC; }
+  if (frame[0] != slave_addr)                                     { return ESP_FAIL; }
+  if (frame[1] == (MB_LINUX_FC04 | 0x80)) {
+      ESP_LOGD(TAG, "--  Bus %d: Slave %d answers with exception %d", port->bus, slave_addr, frame[2]);
+      return MB_ERR_EXCEPTION; }                                  // Same code as esp-modbus
+  if (frame[1] != MB_LINUX_FC04 || frame[2] != 2 * count)         { return ESP_FAIL; }
+  for (uint16_t r = 0; r < count; r++) { regs_out[r] = (frame[3 + 2 * r] << 8) | frame[4 + 2 * r]; } // Big endian on the wire
+  return ESP_OK;
+}
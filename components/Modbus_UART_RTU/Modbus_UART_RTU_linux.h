@@ -0,0 +1,28 @@
+/*===========================================================================================
+ * @brief  HOST stand-in of the serial Modbus master (ESP-IDF linux target ONLY)
+ *
+ * Replaces UART driver + esp-modbus master by a plain RTU master on a tty / pty,
+ * e.g. the one of the SDM630 simulator in 'tools/sdm_simulator'.
+ * Private to this component, used by 'Modbus_UART_RTU.c'.
+========================================================================================================*/
+#pragma once
+#include <stdint.h>
+#include "esp_err.h"
+
+/**
+ * @brief   Open the tty of a bus (`CONFIG_MY_MB_LINUX_TTY`, '%d' = bus), raw 8N1.
+ *
+ * @return  void*  Handle of the bus, NULL on error.
+ */
+void *MB_Linux_Open(uint8_t bus, int baudrate);
+
+/**
+ * @brief   Read input registers (FC04) with ONE request, like `mbc_master_send_request`.
+ *
+ * @param[out] regs_out  Receives `count` registers, native 16-bit order.
+ *
+ * @return  esp_err_t  `ESP_OK`, `ESP_ERR_TIMEOUT` (no / incomplete answer), `ESP_ERR_INVALID_CRC`,
+ *                     `MB_ERR_EXCEPTION` (exception of the slave), `ESP_FAIL` (answer of another slave / function).
+ */
+esp_err_t MB_Linux_Read_Input_Registers(void *handle, uint8_t slave_addr, uint16_t reg_start, uint16_t count,
+                                        uint16_t *regs_out, uint32_t timeout_ms);
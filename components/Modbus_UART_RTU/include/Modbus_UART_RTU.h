@@ -1,8 +1,20 @@
 /*----------
    INCLUDES
 ------------*/
+#include "sdkconfig.h"
+#if CONFIG_IDF_TARGET_LINUX
+#include "Modbus_UART_RTU_linux_types.h" // HOST: NO esp-modbus, its types only
+#else
 #include "esp_modbus_common.h"
 #include "esp_modbus_master.h"
+#endif
+/*----------
+   CONSTANTS
+------------*/
+#define MB_FC_READ_INPUT_REGISTERS  (0x04) // Modbus function code: Read Input Registers (FC04)
+#define MB_FC04_MAX_REGS            (125)  // Modbus spec: max. number of registers with ONE FC04 request
+#define MB_NUM_BUSES                (CONFIG_MY_MB_NUM_BUSES) // Number of independent RS485-buses (one UART & Modbus master each)
+#define MB_ERR_EXCEPTION            (ESP_ERR_INVALID_RESPONSE) // Modbus_Read_Block: the slave answered with an exception (e.g. illegal data address)
 /*----------
    STRUCTURES
 ------------*/
@@ -21,7 +33,133 @@ typedef struct
     uint16_t data_block1[150];
 } input_reg_params_t;
 #pragma pack(pop)
+
+typedef struct {                // Settings of ONE RS485-bus (from menuconfig)
+    int      uart_port;         // UART port number
+    int      txd;               // GPIO of TXD
+    int      rxd;               // GPIO of RXD
+    int      baudrate;          // Baudrate of the bus
+    int      core;              // Core the poll task of this bus should run on (-1 = no affinity)
+} mb_bus_config_t;
+
+typedef struct {                // ONE block read = ONE FC04 request covering several CIDs
+    uint8_t  bus;               // Bus (Modbus master) the block is read with
+    uint8_t  slave_addr;        // Modbus Slave address the block is read from
+    uint16_t reg_start;         // First register of the block
+    uint16_t reg_count;         // Number of 16-bit registers read with this block
+    uint16_t first;             // Index of the first CID of this block in the (sorted) CID-list handed to the planner
+    uint16_t num_cids;          // Number of CIDs covered by this block
+} mb_block_read_t;
 /*------------------
   Define FUNCTIONS
 -------------------*/
-esp_err_t Start_Modbus_RTU_Workers(void **mb_handle_out, mb_parameter_descriptor_t *mb_descriptors_in, size_t num_descriptors_in);
\ No newline at end of file
+/**
+ * @brief   Start one Modbus master per configured bus (`CONFIG_MY_MB_NUM_BUSES`), all with the same descriptor table.
+ *
+ * @param[out] mb_handle_out       Handle of the master of the FIRST bus (optional).
+ * @param[in]  mb_descriptors_in   Descriptor table, CIDs are unique over all buses.
+ * @param[in]  num_descriptors_in  Number of descriptors in the table.
+ */
+esp_err_t Start_Modbus_RTU_Workers(void **mb_handle_out, mb_parameter_descriptor_t *mb_descriptors_in, size_t num_descriptors_in);
+
+/**
+ * @brief   Get the settings of a bus, NULL if the bus does not exist.
+ */
+const mb_bus_config_t *Modbus_Get_Bus_Config(uint8_t bus);
+
+/**
+ * @brief   Group the given CIDs into as few FC04 block reads as possible.
+ *
+ * Sorts the CID-list by slave address and register, then joins neighbouring registers
+ * of the same slave into one block as long as the gap between them is not bigger than
+ * `CONFIG_MY_MB_BLOCK_MAX_GAP_REGS` and the block is not longer than `CONFIG_MY_MB_BLOCK_MAX_REGS`.
+ * A gap holding a register of a NOT readable CID (`Modbus_Set_CID_Readable`) is never bridged.
+ *
+ * @param[in]     bus          Bus the CIDs are connected to, stored in the planned blocks.
+ * @param[in,out] cids_inout   CIDs (of the descriptor table set with `Start_Modbus_RTU_Workers`) to read, sorted on return.
+ * @param[in]     num_cids     Number of CIDs in `cids_inout`.
+ * @param[out]    blocks_out   Array receiving the planned block reads.
+ * @param[in]     max_blocks   Size of `blocks_out`, `num_cids` is always enough.
+ *
+ * @return  size_t  Number of planned blocks, 0 if nothing to plan.
+ */
+size_t Modbus_Plan_Block_Reads(uint8_t bus, uint16_t *cids_inout, size_t num_cids, mb_block_read_t *blocks_out, size_t max_blocks);
+
+/**
+ * @brief   Read one planned block with a single FC04 request on the bus of the block.
+ *
+ * @param[in]  block     Block planned by `Modbus_Plan_Block_Reads`.
+ * @param[out] regs_out  Receives `block->reg_count` registers, native 16-bit order.
+ *
+ * @return  esp_err_t  `ESP_OK` on success, `ESP_ERR_TIMEOUT` if the slave does not answer,
+ *                     `MB_ERR_EXCEPTION` if it rejects the request, otherwise the error of the Modbus-Controller.
+ */
+esp_err_t Modbus_Read_Block(const mb_block_read_t *block, uint16_t *regs_out);
+
+/**
+ * @brief   Mark a CID (not) readable, e.g. while its circuit breaker is open.
+ *
+ * The planner never bridges the registers of a NOT readable CID with a block read,
+ * so a register the slave rejects does not fail the blocks around it.
+ * A NOT readable CID that is handed to the planner is still planned (retry).
+ */
+void Modbus_Set_CID_Readable(uint16_t cid, bool readable);
+
+/**
+ * @brief   Re-tune the response timeout of a bus from the measured latencies (`CONFIG_MY_MB_ADAPTIVE_TIMEOUT`).
+ *
+ * Cheap to call every poll cycle: works only every minute or after a timeout. The new timeout is the
+ * `CONFIG_MY_MB_TIMEOUT_PERCENTILE` of the turn-around time of the slowest slave on the bus, plus
+ * `CONFIG_MY_MB_TIMEOUT_MARGIN_MS` and the transmission time of the longest block, limited to
+ * `CONFIG_MY_MB_TIMEOUT_MIN_MS` .. `CONFIG_MY_MB_REGISTER_REPONSE_TIMEOUT`.
+ * Must be called by the (only) task using the bus, as the master of the bus is re-created.
+ *
+ * @param[in]  bus  Bus to tune.
+ *
+ * @return  esp_err_t  `ESP_OK` also if nothing had to be changed.
+ */
+esp_err_t Modbus_Tune_Response_Timeout(uint8_t bus);
+
+/**
+ * @brief   Get the active response timeout of a bus in ms.
+ */
+uint32_t Modbus_Get_Response_Timeout(uint8_t bus);
+
+/**
+ * @brief   Get a percentile of the turn-around time (answer time without transmission) of a slave in ms.
+ *
+ * @return  uint32_t  0 = no samples, UINT32_MAX = percentile lies in the timeouts.
+ */
+uint32_t Modbus_Get_Latency_Percentile(uint8_t bus, uint8_t slave_addr, uint8_t percentile);
+
+/**
+ * @brief   Get the register offset of a CID within a block read buffer.
+ *
+ * The CID has to lie within the block (not checked). Used to index the buffer of `Modbus_Read_Block`
+ * and, halved, the values of `Modbus_Decode_Floats_CDAB`.
+ */
+uint16_t Modbus_Get_CID_Offset(uint16_t cid, const mb_block_read_t *block);
+
+/**
+ * @brief   Decode a 32-bit float stored in two registers (what esp-modbus calls PARAM_TYPE_FLOAT_CDAB).
+ *
+ * The register with the LOWER address holds the high word, like all Eastron SDM devices send it.
+ *
+ * @param[in]  regs  Pointer to the first of the two registers (native 16-bit order).
+ */
+static inline float Modbus_Decode_Float_CDAB(const uint16_t *regs) {
+    union { uint32_t u; float f; } conv = { .u = ((uint32_t)regs[0] << 16) | regs[1] };
+    return conv.f;
+}
+
+/**
+ * @brief   Decode a whole block read buffer of CDAB floats in ONE pass (see `Modbus_Decode_Float_CDAB`).
+ *
+ * Float `k` is taken from the registers `2k` and `2k+1` of the buffer, with one 32-bit load and
+ * one rotate each. A value at an ODD register offset is not covered, decode it on its own.
+ *
+ * @param[in]  regs        Buffer of `Modbus_Read_Block` (native 16-bit order).
+ * @param[in]  num_floats  Number of floats to decode (= registers / 2).
+ * @param[out] values_out  Receives `num_floats` values.
+ */
+void Modbus_Decode_Floats_CDAB(const uint16_t *regs, size_t num_floats, float *values_out);
@@ -0,0 +1,85 @@
+/*===========================================================================================
+ * @brief  HOST stand-in of the esp-modbus types used by this component & its callers (ESP-IDF linux target ONLY)
+ *
+ * esp-modbus is NOT a dependency of the linux target (its serial port needs 'driver/uart'),
+ * see 'idf_component.yml'. Same names & members as esp-modbus, so the callers build unchanged.
+ * The requests go to the RTU master of 'Modbus_UART_RTU_linux.c'.
+========================================================================================================*/
+#pragma once
+#include <stdint.h>
+#include <inttypes.h>
+#include "esp_err.h"
+#include "esp_log.h"
+
+/*----------
+   MACROS
+------------*/
+#define MB_RETURN_ON_FALSE(a, err_code, tag, format, ...) do {                                  \
+        if (!(a)) {                                                                             \
+            ESP_LOGE(tag, "%s(%" PRIu32 "): " format, __FUNCTION__, (uint32_t)__LINE__, ##__VA_ARGS__); \
+            return err_code;                                                                    \
+        }                                                                                       \
+    } while (0)
+
+/*------------
+   STRUCTURES
+--------------*/
+typedef enum {                  // Kind of Modbus register
+    MB_PARAM_HOLDING = 0x00,
+    MB_PARAM_INPUT,
+    MB_PARAM_COIL,
+    MB_PARAM_DISCRETE,
+    MB_PARAM_COUNT,
+    MB_PARAM_UNKNOWN = 0xFF
+} mb_param_type_t;
+
+typedef enum {                  // Encoding of a parameter (ONLY the ones of this project)
+    PARAM_TYPE_U8 = 0x00,
+    PARAM_TYPE_U16 = 0x01,
+    PARAM_TYPE_U32 = 0x02,
+    PARAM_TYPE_FLOAT = 0x03,
+    PARAM_TYPE_ASCII = 0x04,
+    PARAM_TYPE_FLOAT_CDAB = 0x17,
+} mb_descr_type_t;
+
+typedef enum {                  // Size of a parameter in bytes
+    PARAM_SIZE_U8 = 0x01,
+    PARAM_SIZE_U16 = 0x02,
+    PARAM_SIZE_U32 = 0x04,
+    PARAM_SIZE_FLOAT = 0x04,
+} mb_descr_size_t;
+
+typedef enum {                  // Access permissions of a parameter
+    PAR_PERMS_READ = 1 << 0,
+    PAR_PERMS_WRITE = 1 << 1,
+    PAR_PERMS_TRIGGER = 1 << 2,
+    PAR_PERMS_READ_WRITE = PAR_PERMS_READ | PAR_PERMS_WRITE,
+} mb_param_perms_t;
+
+typedef struct {                // Value range of a parameter
+    int      min;
+    int      max;
+    int      step;
+} mb_parameter_opt_t;
+
+typedef struct {                // ONE parameter (CID) of the descriptor table
+    uint16_t            cid;
+    const char          *param_key;
+    const char          *param_units;
+    uint8_t             mb_slave_addr;
+    mb_param_type_t     mb_param_type;
+    uint16_t            mb_reg_start;
+    uint16_t            mb_size;
+    uint32_t            param_offset;
+    mb_descr_type_t     param_type;
+    mb_descr_size_t     param_size;
+    mb_parameter_opt_t  param_opts;
+    mb_param_perms_t    access;
+} mb_parameter_descriptor_t;
+
+typedef struct {                // ONE request to a slave
+    uint8_t  slave_addr;
+    uint8_t  command;
+    uint16_t reg_start;
+    uint16_t reg_size;
+} mb_param_request_t;
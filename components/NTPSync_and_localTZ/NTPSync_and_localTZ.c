@@ -2,7 +2,13 @@
 #include "NTPSync_and_localTZ.h"  // For THIS component
 
 #include "esp_event.h"
+#if !CONFIG_IDF_TARGET_LINUX
 #include "esp_netif_sntp.h"
+#endif
+#include "esp_timer.h"            // For esp_timer_get_time
+#include <sys/time.h>               // For gettimeofday
+
+#define EPOCH_VALID_AFTER_S  (1577836800) // 2020-01-01: Earlier wall-clock = not synchronized by NTP yet
 
 /*------------------
   ESP Logging: TAG 
@@ -87,6 +93,35 @@ void getShortTimesStamp(char *shortTime_out, size_t SST_len_out)
 };
 
 
+/*############################################################################
+  getEpochMs_of_Timer():
+      Convert an esp_timer time (µs since boot) into wall-clock epoch ms
+  used by: caller
+#############################################################################*/
+int64_t getEpochMs_of_Timer(int64_t timer_us)
+{   struct timeval tv;
+    gettimeofday(&tv, NULL);                                  // Wall-clock NOW ...
+    int64_t now_us = esp_timer_get_time();                    // ... and esp_timer NOW (taken right after)
+    if (tv.tv_sec < EPOCH_VALID_AFTER_S) { return 0; }        // Time not synchronized yet
+    int64_t epoch_now_ms = (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+    return epoch_now_ms - (now_us - timer_us) / 1000;         // Go back by the age of the timer value
+};
+
+/*############################################################################
+  getShortTimesStamp_ms():
+      Format epoch ms as short local time-stamp with milliseconds
+  used by: caller
+#############################################################################*/
+void getShortTimesStamp_ms(int64_t epoch_ms, char *shortTime_out, size_t SST_len_out)
+{   struct tm timeinfo;                                       // Struct to hold the time information
+    time_t secs = (time_t)(epoch_ms / 1000);
+    localtime_r(&secs, &timeinfo);                            // Convert the time to local time
+    //           Example :  "2025-05-16@10:15:05.123" = 23+1 chars
+    snprintf(shortTime_out, SST_len_out, "%4u-%02d-%02d@%02d:%02d:%02d.%03d",
+        timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday,
+        timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec, (int)(epoch_ms % 1000));
+};
+
 /*############################################################################
   SyncNTP_and_set_LocalTZ()
       Synchronize the time with NTP server and set the local timezone
@@ -103,6 +138,9 @@ esp_err_t SyncNTP_and_set_LocalTZ()
     /*--------------------------------
       1. Get the NTP-Time
     ---------------------------------*/
+#if CONFIG_IDF_TARGET_LINUX
+    ESP_LOGI(TAG, "--  * Host target: The clock of the host is used (synchronized by the OS)");
+#else
     ESP_LOGI(TAG, "--  Request the current time from: %s", CONFIG_MY_SNTP_TIME_SERVER);
     esp_sntp_config_t config = ESP_NETIF_SNTP_DEFAULT_CONFIG(CONFIG_MY_SNTP_TIME_SERVER);
     config.sync_cb = time_sync_notify_cb;     // Set callback (cb) funtion, when the time is synchronized is triggered
@@ -121,6 +159,7 @@ esp_err_t SyncNTP_and_set_LocalTZ()
     } else {
           ESP_LOGE(TAG, "-- !! Failed Failed to initialize SNTP: %s", esp_err_to_name(err));
     }
+#endif
     /*--------------------------------
       2. Set the local TimeZone
     ---------------------------------*/
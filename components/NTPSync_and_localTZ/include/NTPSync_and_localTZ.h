@@ -38,4 +38,25 @@ char* getShortTimestampString();
  *
  * @note  Receiving 'Target'-buffer must be large enough to hold the formatted string.
  */
-void getShortTimesStamp(char *shortTime_out, size_t SST_len_out);
\ No newline at end of file
+void getShortTimesStamp(char *shortTime_out, size_t SST_len_out);
+
+/**
+ * @brief   Convert an esp_timer time (µs since boot) into wall-clock time (ms since epoch, UTC).
+ *
+ * Uses the offset between the wall-clock and `esp_timer` at the time of the call,
+ * so a sample keeps its true acquisition time even if it is converted much later.
+ *
+ * @param[in]  timer_us   Time taken with `esp_timer_get_time()`.
+ *
+ * @return  int64_t  Epoch ms, 0 if the time is not synchronized yet (before 2020).
+ */
+int64_t getEpochMs_of_Timer(int64_t timer_us);
+
+/**
+ * @brief   Get a short timestamp string with milliseconds (YYYY-MM-DD@HH:MM:SS.mmm) of an epoch-ms time.
+ *
+ * @param[in]  epoch_ms        Time in ms since epoch, e.g. from `getEpochMs_of_Timer()`.
+ * @param[out] shortTime_out   Pointer to the output buffer for the timestamp string (24 chars).
+ * @param[in]  SST_len_out     Length of the output buffer.
+ */
+void getShortTimesStamp_ms(int64_t epoch_ms, char *shortTime_out, size_t SST_len_out);
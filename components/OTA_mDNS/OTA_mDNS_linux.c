@@ -0,0 +1,13 @@
+/*#################################################################################################################################
+   HOST stand-in of OTA_mDNS for the ESP-IDF linux target
+   ----------------------------------------------------------------------------------------------------------------------------
+   There is no flash to update on the host: a new build is just started again.
+   Same public functions as 'OTA_mDNS.c', selected by CMakeLists.txt.
+##################################################################################################################################*/
+#include "OTA_mDNS.h"           // for THIs (own component)
+#include <esp_log.h>            // For ESP-logging
+#define TAG_OTA "🚨OTA_Upd"     // TAG for logging
+
+const char *get_ota_url(void)         { return "-no OTA on host-"; }
+bool is_ota_update_in_progress(void)  { return false; }
+void start_ota_task(void)             { ESP_LOGW(TAG_OTA, "Host target: OTA not available, restart the new build instead."); }
@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+#-------------------------------------------------------------------------------------------------------
+# Generate 'prm_register_tables.h' from ONE register spec (run by CMakeLists.txt of this component)
+#
+#   register_spec.csv  >> which registers are read, how they are named, shown & published
+#   EASTRON_SDM.h      >> register addresses & which meter model has which register
+#
+# For EVERY model of EASTRON_SDM.h a table is generated, that holds only the registers the model has.
+# 'menuconfig: PRM_METER_MODEL' selects the table. Per register the table holds the pre-joined MQTT
+# topic and the constant fragment of the JSON payload, so nothing is assembled per message.
+# The list of ALL registers of the model is generated too: rows of the runtime register map
+# ('storage_at_runtime/register_map.csv') with registers the model does not have are dropped.
+#   python gen_register_tables.py --spec register_spec.csv --sdm include/EASTRON_SDM.h --out <header>
+#
+# The runtime register map of the project is generated from the same spec (meter 0):
+#   --check-map <csv>  >> fails when the file differs from the spec (done by CMakeLists.txt)
+#   --write-map <csv>  >> (re)writes the file from the spec
+#-------------------------------------------------------------------------------------------------------
+import argparse
+import csv
+import os
+import re
+import sys
+
+XML_TAGS = 64  # '<responseN>' tags generated (>= MB_MAX_CIDS of main.c)
+
+#-------------------------------------------------------
+# (1) Register map of the meter models: EASTRON_SDM.h
+#-------------------------------------------------------
+def read_sdm_header(path):
+    models = []
+    registers = {}  # Name >> (address, set of models)
+    with open(path, encoding='utf-8') as f:
+        for line in f:
+            if 'REGISTER NAME' in line and 'REGISTER ADDRESS' in line:  # Header: '| UNIT | SDM630 | SDM230 | ...'
+                cols = [c.strip() for c in line.split('|')]
+                models = [re.sub(r'\W', '', c) for c in cols[2:] if c]
+                continue
+            m = re.match(r'\s*#define\s+(SDM_\w+)\s+(0x[0-9A-Fa-f]+)\s*//([^|]*)\|(.*)', line)
+            if m is None:
+                continue
+            marks = [c.strip() for c in m.group(4).split('|')]
+            has = {models[i] for i, c in enumerate(marks[:len(models)]) if c == '1'}
+            registers[m.group(1)] = (int(m.group(2), 16), has)
+    if not models:
+        sys.exit(f'{path}: no model columns found')
+    return models, registers
+
+#-------------------------------------------------------
+# (2) Register spec: register_spec.csv
+#-------------------------------------------------------
+def read_spec(path, registers):
+    spec = []
+    with open(path, encoding='utf-8') as f:
+        rows = [r for r in csv.reader(f) if r and not r[0].lstrip().startswith('#')]
+    for n, row in enumerate(rows[1:], start=2):  # Row 1 = column names
+        row = [c.strip() for c in row]
+        if len(row) < 8:
+            sys.exit(f'{path}: register {n}: 8 columns needed, got {len(row)}')
+        name, unit, vmin, vmax, digits, prio, refresh, reg = row[:8]
+        if not re.fullmatch(r'[A-Za-z0-9_.\-]{1,31}', name):
+            sys.exit(f'{path}: register {n}: invalid topic name {name!r}')
+        if not re.fullmatch(r'[^"\\<>&]{1,7}', unit):
+            sys.exit(f'{path}: register {n}: invalid unit {unit!r}')
+        if reg not in registers:
+            sys.exit(f'{path}: register {n}: {reg!r} is not in EASTRON_SDM.h')
+        spec.append(dict(name=name, unit=unit, min=int(vmin), max=int(vmax), digits=int(digits),
+                         prio=prio.lower() in ('1', 'y', 'yes', 'true'), refresh=int(refresh),
+                         reg=reg, addr=registers[reg][0], models=registers[reg][1]))
+    if len({r['name'] for r in spec}) != len(spec):
+        sys.exit(f'{path}: topic names must be unique')
+    return spec
+
+#-------------------------------------------------------
+# (3) Header
+#-------------------------------------------------------
+def c_str(s):
+    return '"' + s.replace('\\', '\\\\').replace('"', '\\"') + '"'
+
+def write_header(path, spec_path, models, registers, spec):
+    out = []
+    out.append('/* GENERATED by gen_register_tables.py from %s & EASTRON_SDM.h -- do NOT edit */' % os.path.basename(spec_path))
+    out.append('#pragma once')
+    out.append('#include "sdkconfig.h"')
+    out.append('#ifndef PRM_TOPIC_PREFIX')
+    out.append('#error "Define PRM_TOPIC_PREFIX (e.g. \\"Power-Meter/MEA/\\") before including prm_register_tables.h"')
+    out.append('#endif')
+    out.append('/*')
+    out.append('  PRM_GEN_REGISTERS(X): X(index, topicName, unit, minVal, maxVal, digits, hasPrio, refreshMs, registerHex, topic, payloadMid)')
+    out.append('    topic      = PRM_TOPIC_PREFIX + topicName')
+    out.append('    payloadMid = JSON between value and time-stamp: \',"unit":"W","comment":"Power-Total","lastUpdate":"\'')
+    out.append('  PRM_GEN_MODEL_REGS: { register, .. } of ALL registers the model has (sorted >> bsearch)')
+    out.append('*/')
+    for i, model in enumerate(models):
+        regs = [r for r in spec if model in r['models']]
+        dropped = [r['name'] for r in spec if model not in r['models']]
+        out.append('%s CONFIG_PRM_METER_MODEL_%s' % ('#if' if i == 0 else '#elif', model))
+        out.append('#define PRM_GEN_MODEL       "%s"' % model)
+        out.append('#define PRM_GEN_NUM_REGS    (%d)' % len(regs))
+        addrs = sorted({a for a, has in registers.values() if model in has})
+        out.append('#define PRM_GEN_MODEL_REGS  { %s }  /* ALL registers of the model, sorted */'
+                   % ', '.join('0x%04X' % a for a in addrs))
+        if dropped:
+            out.append('/* NOT available at the %s: %s */' % (model, ', '.join(dropped)))
+        if not regs:
+            out.append('#error "No register of %s is available at the %s"' % (os.path.basename(spec_path), model))
+        out.append('#define PRM_GEN_REGISTERS(X) \\')
+        for n, r in enumerate(regs):
+            mid = ',"unit":"%s","comment":"%s","lastUpdate":"' % (r['unit'], r['name'])
+            out.append('  X(%2d, %-16s %-6s %d, %5d, %d, %-6s %5d, %s, PRM_TOPIC_PREFIX %s, %s) \\'
+                       % (n, c_str(r['name']) + ',', c_str(r['unit']) + ',', r['min'], r['max'], r['digits'],
+                          ('true' if r['prio'] else 'false') + ',', r['refresh'], r['reg'], c_str(r['name']), c_str(mid)))
+        out.append('')
+    out.append('#else')
+    out.append('#error "No meter model selected, see menuconfig: PRM_METER_MODEL"')
+    out.append('#endif')
+    out.append('')
+    out.append('/* XML tags of the web page: PRM_GEN_XML_TAGS(X): X(index, "<responseN>", "</responseN>") */')
+    out.append('#define PRM_GEN_NUM_XML_TAGS (%d)' % XML_TAGS)
+    out.append('#define PRM_GEN_XML_TAGS(X) \\')
+    for n in range(XML_TAGS):
+        out.append('  X(%d, "<response%d>", "</response%d>") \\' % (n, n, n))
+    out.append('')
+    text = '\n'.join(out) + '\n'
+    if os.path.exists(path) and open(path, encoding='utf-8').read() == text:
+        return  # Unchanged >> no rebuild of the users
+    os.makedirs(os.path.dirname(path), exist_ok=True)
+    with open(path, 'w', encoding='utf-8') as f:
+        f.write(text)
+
+#-------------------------------------------------------
+# (4) Runtime register map: register_map.csv of meter 0
+#-------------------------------------------------------
+MAP_HEADER = '''# Register map of the meters, read at boot (menuconfig: PRM_REGISTER_MAP_FILE)
+#   GENERATED from 'components/POWERMETER/register_spec.csv' (gen_register_tables.py --write-map):
+#   change the spec, not this file. Copies on the device (LittleFS) can be edited freely.
+#   * Same columns as 'PowerMeter-Eastron-SDM-RelevantMeasuments.xlsx' & 'powermeter_RegArray' in main.c
+#   * meter     = index of the meter in 'powermeter_Devices' (main.c), 0 = first meter
+#   * name      = MQTT topic name (no blanks, '/', '+', '#'), max. 31 chars
+#   * digits    = digits of the value (web page & 'changed significantly' for MQTT), 0..6
+#   * prio      = 1: value is published more often
+#   * refreshMs = target refresh period of the register in ms (min. 100)
+#   * register  = input register (FC04), hex like 0x0034 or decimal
+#   * Registers the meter model (menuconfig: PRM_METER_MODEL) does not have are dropped at boot.
+#   * The registers are read (and shown) sorted by meter & register, NOT in the order of this file.
+#   * Cached as 'register_map.bin', which is rebuilt when this file changes.
+meter,name,unit,min,max,digits,prio,refreshMs,register
+'''
+
+def map_text(spec):
+    rows = ['0,%s,%s,%d,%d,%d,%d,%d,0x%04X' % (r['name'], r['unit'], r['min'], r['max'], r['digits'],
+                                              1 if r['prio'] else 0, r['refresh'], r['addr']) for r in spec]
+    return MAP_HEADER + '\n'.join(rows) + '\n'
+
+def check_map(path, spec):
+    text = open(path, encoding='utf-8').read() if os.path.exists(path) else ''
+    if text != map_text(spec):
+        sys.exit(f'{path} differs from register_spec.csv: change the spec and run\n'
+                 f'  python gen_register_tables.py --spec <spec> --sdm <header> --out <header> --write-map {path}')
+
+def main():
+    p = argparse.ArgumentParser(description='Generate the register tables of all meter models')
+    p.add_argument('--spec', required=True, help='register_spec.csv')
+    p.add_argument('--sdm', required=True, help='EASTRON_SDM.h')
+    p.add_argument('--out', required=True, help='Header to generate')
+    p.add_argument('--check-map', help='register_map.csv that has to match the spec')
+    p.add_argument('--write-map', help='register_map.csv to (re)write from the spec')
+    a = p.parse_args()
+    models, registers = read_sdm_header(a.sdm)
+    spec = read_spec(a.spec, registers)
+    write_header(a.out, a.spec, models, registers, spec)
+    if a.write_map:
+        with open(a.write_map, 'w', encoding='utf-8', newline='\n') as f:
+            f.write(map_text(spec))
+    if a.check_map:
+        check_map(a.check_map, spec)
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,23 @@
+/*===========================================================================================
+ * @brief  Energy integration of a power register: ONE trapezoid step (used by main.c & the host test)
+ *
+ *   * Positive power = import, negative = export; both counters only ever increase.
+ *   * A sign change within the step is split at the zero crossing into two triangles.
+ *   * Header only (static inline): NO dependency on ESP-IDF >> tools/energy_test builds it on the host.
+========================================================================================================*/
+#pragma once
+
+/**
+ * @brief   Trapezoid p0..p1 (W) over dt_s (s) >> added to import & export (Wh).
+ */
+static inline void PowerMeter_Energy_Trapezoid(float p0, float p1, double dt_s, double *import_Wh, double *export_Wh)
+{ if ((p0 >= 0) == (p1 >= 0)) {                         // Same sign: ONE trapezoid
+      double wh = 0.5 * ((double)p0 + p1) * dt_s / 3600.0;
+      if (wh >= 0) { *import_Wh += wh; } else { *export_Wh -= wh; }
+      return; }
+  double t0 = dt_s * p0 / ((double)p0 - p1);            // Zero crossing: two triangles
+  double a0 = 0.5 * p0 * t0 / 3600.0;
+  double a1 = 0.5 * p1 * (dt_s - t0) / 3600.0;
+  if (p1 < 0) { *import_Wh += a0; *export_Wh -= a1; }   // Sign of p1: p0 == 0 belongs to neither side (a0 = 0)
+  else        { *export_Wh -= a0; *import_Wh += a1; }
+}
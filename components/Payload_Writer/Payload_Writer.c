@@ -0,0 +1,171 @@
+/*===========================================================================================
+ * @file        Payload_Writer.c
+ * @brief       Payload writer over a buffer of the caller (see Payload_Writer.h)
+ *
+ * Every append checks the room first: a piece is written completely or not at all (>> overflow).
+ * 'len' is the end of the payload, the '\0' is kept behind it.
+ *
+ * Fixed-point numbers: |v| * 10^digits is rounded to an integer, which is printed with the decimal
+ * point put in. printf rounds the EXACT value of v; the product may be off by one ulp, so a product
+ * closer than that to x.5 (a rounding tie) is handed to printf. Same for NaN, Inf, values beyond
+ * 2^53 and digits beyond PW_MAX_DIGITS >> the text is always the one of "%.*f".
+========================================================================================================*/
+/*----------
+   INCLUDES
+------------*/
+#include "Payload_Writer.h"     // For THIS component
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <math.h>
+#include <float.h>
+
+/*----------------------------------------------------------------------------------------------
+  Room for 'n' more bytes (+ '\0')? Else mark the overflow
+------------------------------------------------------------------------------------------------*/
+static inline bool PW_Room(pw_writer_t *w, size_t n)
+{ if (w->overflow || w->size - w->len <= n) { w->overflow = true; return false; }
+  return true;
+}
+
+void PW_Init(pw_writer_t *w, char *buf, size_t size)
+{ w->buf      = buf;
+  w->size     = size;
+  w->len      = 0;
+  w->overflow = (buf == NULL || size == 0);
+  w->depth    = 0;
+  w->more     = 0;
+  w->array    = 0;
+  if (!w->overflow) { buf[0] = '\0'; }
+}
+
+void PW_Append(pw_writer_t *w, const char *s, size_t n)
+{ if (!PW_Room(w, n)) { return; }
+  memcpy(&w->buf[w->len], s, n);
+  w->len += n;
+  w->buf[w->len] = '\0';
+}
+
+void PW_Append_Str(pw_writer_t *w, const char *s) { PW_Append(w, s, strlen(s)); }
+
+void PW_Append_Escaped(pw_writer_t *w, const char *s)
+{ static const char hex[] = "0123456789abcdef";
+  const char *run = s;                                  // Start of the characters to copy as they are
+  for (; *s; s++) {
+      unsigned char c = (unsigned char)*s;
+      if (c >= 0x20 && c != '"' && c != '\\') { continue; }
+      PW_Append(w, run, s - run);
+      if      (c == '"')  { PW_Append(w, "\\\"", 2); }
+      else if (c == '\\') { PW_Append(w, "\\\\", 2); }
+      else if (c == '\n') { PW_Append(w, "\\n", 2); }
+      else if (c == '\r') { PW_Append(w, "\\r", 2); }
+      else if (c == '\t') { PW_Append(w, "\\t", 2); }
+      else { char u[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0x0F] }; PW_Append(w, u, sizeof(u)); }
+      run = s + 1; }
+  PW_Append(w, run, s - run);
+}
+
+void PW_Append_Int(pw_writer_t *w, int64_t v)
+{ char tmp[24];                                         // Digits from the back
+  char *p = &tmp[sizeof(tmp)];
+  uint64_t u = (v < 0) ? 0 - (uint64_t)v : (uint64_t)v;
+  do { *--p = '0' + (u % 10); u /= 10; } while (u);
+  if (v < 0) { *--p = '-'; }
+  PW_Append(w, p, &tmp[sizeof(tmp)] - p);
+}
+
+static const double   pw_Pow10[PW_MAX_DIGITS + 1]  = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+static const uint32_t pw_Pow10u[PW_MAX_DIGITS + 1] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+
+int PW_Format_Fixed(char *out, size_t size, double v, int digits)
+{ if (digits < 0 || digits > PW_MAX_DIGITS) { return snprintf(out, size, "%.*f", digits, v); }
+  double scaled = fabs(v) * pw_Pow10[digits];
+  if (!(scaled < 9007199254740992.0)) { return snprintf(out, size, "%.*f", digits, v); }  // NaN, Inf, >= 2^53
+  double whole = floor(scaled);
+  double frac  = scaled - whole;                        // Exact
+  if (fabs(frac - 0.5) <= scaled * (4 * DBL_EPSILON)) { return snprintf(out, size, "%.*f", digits, v); } // Next to a tie
+  uint64_t r  = (uint64_t)whole + (frac > 0.5);         // Rounded |v| * 10^digits
+  uint64_t ip = r / pw_Pow10u[digits];                  // Integer part
+  uint32_t fp = (uint32_t)(r % pw_Pow10u[digits]);      // Fraction digits
+  char tmp[32];                                         // Digits from the back
+  char *p = &tmp[sizeof(tmp)];
+  for (int k = 0; k < digits; k++) { *--p = '0' + (fp % 10); fp /= 10; }
+  if (digits) { *--p = '.'; }
+  do { *--p = '0' + (ip % 10); ip /= 10; } while (ip);
+  if (signbit(v)) { *--p = '-'; }                       // Like printf: also "-0.0"
+  int n = (int)(&tmp[sizeof(tmp)] - p);
+  if ((size_t)n < size) { memcpy(out, p, n); out[n] = '\0'; }
+  else if (size) { out[0] = '\0'; }
+  return n;
+}
+
+const char *PW_Fixed_Str(char *buf, double v, int digits)
+{ PW_Format_Fixed(buf, PW_FIXED_MAX, v, digits);
+  return buf;
+}
+
+void PW_Append_Fixed(pw_writer_t *w, double v, int digits)
+{ char tmp[PW_FIXED_MAX];
+  int n = PW_Format_Fixed(tmp, sizeof(tmp), v, digits);
+  if (n < 0 || n >= (int)sizeof(tmp)) { w->overflow = true; return; }   // Absurd value
+  PW_Append(w, tmp, n);
+}
+
+void PW_Appendf(pw_writer_t *w, const char *format, ...)
+{ if (w->overflow) { return; }
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(&w->buf[w->len], w->size - w->len, format, args);
+  va_end(args);
+  if (n < 0 || (size_t)n >= w->size - w->len) { w->buf[w->len] = '\0'; w->overflow = true; return; } // Cut piece dropped
+  w->len += n;
+}
+
+/*----------------------------------------------------------------------------------------------
+  JSON: ',' before all but the first member of the open object / array, then the key (if any)
+------------------------------------------------------------------------------------------------*/
+static void PW_Json_Member(pw_writer_t *w, const char *key)
+{ uint32_t bit = 1u << w->depth;
+  if (w->more & bit) { PW_Append(w, ",", 1); }
+  w->more |= bit;
+  if (key) {
+      PW_Append(w, "\"", 1);
+      PW_Append_Escaped(w, key);
+      PW_Append(w, "\":", 2); }
+}
+
+static void PW_Json_Open(pw_writer_t *w, const char *key, char open, bool array)
+{ if (w->depth >= PW_MAX_DEPTH) { w->overflow = true; return; }
+  PW_Json_Member(w, key);
+  PW_Append(w, &open, 1);
+  w->depth++;
+  w->more  &= ~(1u << w->depth);
+  w->array  = array ? (w->array | (1u << w->depth)) : (w->array & ~(1u << w->depth));
+}
+
+void PW_Json_Object(pw_writer_t *w, const char *key) { PW_Json_Open(w, key, '{', false); }
+void PW_Json_Array(pw_writer_t *w, const char *key)  { PW_Json_Open(w, key, '[', true); }
+
+void PW_Json_Close(pw_writer_t *w)
+{ if (w->depth == 0) { w->overflow = true; return; }   // Nothing open: broken payload
+  PW_Append(w, (w->array & (1u << w->depth)) ? "]" : "}", 1);
+  w->depth--;
+}
+
+void PW_Json_Str(pw_writer_t *w, const char *key, const char *s)
+{ PW_Json_Member(w, key);
+  PW_Append(w, "\"", 1);
+  PW_Append_Escaped(w, s);
+  PW_Append(w, "\"", 1);
+}
+
+void PW_Json_Int(pw_writer_t *w, const char *key, int64_t v)
+{ PW_Json_Member(w, key);
+  PW_Append_Int(w, v);
+}
+
+void PW_Json_Fixed(pw_writer_t *w, const char *key, double v, int digits)
+{ PW_Json_Member(w, key);
+  if (isnan(v) || isinf(v)) { PW_Append(w, "null", 4); return; }     // No number in JSON
+  PW_Append_Fixed(w, v, digits);
+}
@@ -0,0 +1,88 @@
+/*===========================================================================================
+ * @file        pw_fixed_bench.c
+ * @brief       HOST micro-benchmark of PW_Format_Fixed() vs. snprintf("%.*f") (NOT part of the firmware)
+ *
+ * (1) Check: the text must be byte-identical to snprintf for values like the meters give
+ *     (float, 0..4 digits) and for the edge cases (ties, -0, NaN, Inf, huge, tiny).
+ * (2) Time:  the same values formatted by both, ns per number.
+ *
+ * Build & run on the host (from this folder):
+ *     gcc -O2 -I../include pw_fixed_bench.c ../Payload_Writer.c -lm -o pw_fixed_bench && ./pw_fixed_bench
+========================================================================================================*/
+#include "Payload_Writer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#define BENCH_VALUES   (4096)           // Values of ONE round (like a few cycles of all registers)
+#define BENCH_ROUNDS   (500)            // Rounds timed
+#define CHECK_VALUES   (2000000)        // Random values checked
+
+static uint32_t bench_Seed = 12345;
+static uint32_t Bench_Rand(void) { bench_Seed = bench_Seed * 1664525u + 1013904223u; return bench_Seed; }
+
+/*--------------------------------
+  Value like a meter register: float, mostly small ranges, sometimes big or negative
+----------------------------------*/
+static float Bench_Value(void)
+{ static const float range[] = { 1.0f, 50.0f, 250.0f, 5000.0f, 72000.0f, 1e6f };
+  float v = (Bench_Rand() / 4294967296.0f) * range[Bench_Rand() % 6];
+  return (Bench_Rand() & 3) ? v : -v;
+}
+
+static double Bench_Now_Ns(void)
+{ struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int Bench_Check(double v, int digits)
+{ char ref[PW_FIXED_MAX * 8], out[PW_FIXED_MAX * 8];
+  int nr = snprintf(ref, sizeof(ref), "%.*f", digits, v);
+  int no = PW_Format_Fixed(out, sizeof(out), v, digits);
+  if (nr == no && strcmp(ref, out) == 0) { return 0; }
+  printf("MISMATCH %.17g digits %d: printf '%s' formatter '%s'\n", v, digits, ref, out);
+  return 1;
+}
+
+int main(void)
+{ //..................................................
+  // (1) Byte-identical?
+  //..................................................
+  static const double edge[] = { 0.0, -0.0, 0.5, 1.5, 2.5, -0.5, 0.125, 0.375, 1.005, 2.675, 0.045, -0.04, 9.995,
+                                 0.05, 0.15, 0.25, 0.35, 999999.5, 1e-12, -1e-12, 123456789.123456789, 4503599627370495.5,
+                                 9007199254740993.0, 1e300, -1e300, NAN, -NAN, INFINITY, -INFINITY };
+  int bad = 0;
+  long checked = 0;
+  for (size_t k = 0; k < sizeof(edge) / sizeof(edge[0]); k++) {
+      for (int d = 0; d <= 12; d++) { bad += Bench_Check(edge[k], d); checked++; } }
+  for (long k = 0; k < CHECK_VALUES; k++) {
+      float v = Bench_Value();
+      bad += Bench_Check(v, k % 5); checked++; }
+  static const double scale[] = { 1.0, 10.0, 100.0, 1000.0 };
+  for (long k = 0; k < 100000; k++) {                   // Ties (exact or next to): x.5 / 10^d
+      double v = ((Bench_Rand() % 200000) + 0.5) / scale[k % 4];
+      bad += Bench_Check(v, k % 4); checked++; }
+  printf("Check: %ld numbers, %d differ from snprintf\n", checked, bad);
+  //..................................................
+  // (2) Speed
+  //..................................................
+  static float values[BENCH_VALUES];
+  static int   digits[BENCH_VALUES];
+  for (int k = 0; k < BENCH_VALUES; k++) { values[k] = Bench_Value(); digits[k] = Bench_Rand() % 4; }
+  char buf[PW_FIXED_MAX];
+  volatile int sink = 0;
+  double t0 = Bench_Now_Ns();
+  for (int r = 0; r < BENCH_ROUNDS; r++) {
+      for (int k = 0; k < BENCH_VALUES; k++) { sink += snprintf(buf, sizeof(buf), "%.*f", digits[k], values[k]); } }
+  double t1 = Bench_Now_Ns();
+  for (int r = 0; r < BENCH_ROUNDS; r++) {
+      for (int k = 0; k < BENCH_VALUES; k++) { sink += PW_Format_Fixed(buf, sizeof(buf), values[k], digits[k]); } }
+  double t2 = Bench_Now_Ns();
+  double n = (double)BENCH_ROUNDS * BENCH_VALUES;
+  printf("snprintf(\"%%.*f\"): %6.1f ns per number\n", (t1 - t0) / n);
+  printf("PW_Format_Fixed:  %6.1f ns per number  >> %.1fx faster\n", (t2 - t1) / n, (t1 - t0) / (t2 - t1));
+  return bad ? 1 : 0;
+}
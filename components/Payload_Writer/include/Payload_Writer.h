@@ -0,0 +1,115 @@
+/*===========================================================================================
+ * @brief  Payload writer: builds the MQTT & HTTP payloads (JSON, XML, CSV) in a buffer of the caller
+ *
+ *   * NO heap: the caller hands in the arena (stack, static or ONE allocation per request).
+ *   * Bounds-checked: a piece that does not fit is NOT written and the writer is marked as
+ *     overflowed >> `PW_Ok()` = false, the payload must NOT be sent. Always '\0'-terminated.
+ *   * Append with length (no rescan of the string like strcat), integers, fixed-point numbers
+ *     and JSON escaping.
+ *   * Fixed-point numbers are printed as scaled integers, NOT with printf: same text as "%.*f"
+ *     (byte for byte), only the rare values next to a rounding tie fall back to printf.
+ *   * JSON members: the writer puts the ',' between members itself. Numbers are native JSON
+ *     numbers, NaN & Inf become null.
+ *   * NOT thread-safe: ONE writer per payload.
+========================================================================================================*/
+#pragma once
+/*----------
+   INCLUDES
+------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+/*----------
+   CONSTANTS
+------------*/
+#define PW_MAX_DEPTH        (31)        // Max. nesting of JSON objects & arrays
+#define PW_MAX_DIGITS       (9)         // Max. digits after the decimal point of the fast path (more >> printf)
+#define PW_FIXED_MAX        (48)        // Buffer for ONE number of `PW_Format_Fixed()`
+/*------------
+   STRUCTURES
+--------------*/
+typedef struct {                // State of ONE payload
+    char     *buf;              // Arena of the caller
+    size_t   size;              // ... its size incl. '\0'
+    size_t   len;               // Bytes written (without '\0')
+    bool     overflow;          // true = a piece did not fit >> payload NOT usable
+    uint8_t  depth;             // Open JSON objects & arrays
+    uint32_t more;              // Bit per depth: a member was written (>> ',' before the next)
+    uint32_t array;             // Bit per depth: an array (else an object)
+} pw_writer_t;
+
+/*------------------------
+  Define PUBLIC FUNCTIONS
+------------------------*/
+/**
+ * @brief   Start a payload in `buf` (`size` bytes incl. '\0').
+ */
+void PW_Init(pw_writer_t *w, char *buf, size_t size);
+
+/**
+ * @brief   Append `n` bytes (e.g. a constant fragment of known length).
+ */
+void PW_Append(pw_writer_t *w, const char *s, size_t n);
+
+/**
+ * @brief   Append a '\0'-terminated string.
+ */
+void PW_Append_Str(pw_writer_t *w, const char *s);
+
+/**
+ * @brief   Append a string JSON-escaped (", \ and control characters), WITHOUT the quotes.
+ */
+void PW_Append_Escaped(pw_writer_t *w, const char *s);
+
+/**
+ * @brief   Append an integer.
+ */
+void PW_Append_Int(pw_writer_t *w, int64_t v);
+
+/**
+ * @brief   Format a number with `digits` after the decimal point: same text as snprintf "%.*f".
+ *
+ * @return  int  Length of the text (>= `size` = cut, like snprintf).
+ */
+int PW_Format_Fixed(char *out, size_t size, double v, int digits);
+
+/**
+ * @brief   `PW_Format_Fixed()` into `buf` (PW_FIXED_MAX bytes), e.g. as argument of a log message.
+ *
+ * @return  const char*  `buf`.
+ */
+const char *PW_Fixed_Str(char *buf, double v, int digits);
+
+/**
+ * @brief   Append a number with `digits` after the decimal point, like "%.*f".
+ */
+void PW_Append_Fixed(pw_writer_t *w, double v, int digits);
+
+/**
+ * @brief   Append a printf-formatted piece (for the rare parts without a PW_ function).
+ */
+void PW_Appendf(pw_writer_t *w, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+/**
+ * @brief   JSON: open an object / array, as member `key` (NULL = top level or element of an array).
+ */
+void PW_Json_Object(pw_writer_t *w, const char *key);
+void PW_Json_Array(pw_writer_t *w, const char *key);
+
+/**
+ * @brief   JSON: close the object / array opened last.
+ */
+void PW_Json_Close(pw_writer_t *w);
+
+/**
+ * @brief   JSON members: string (escaped), integer, fixed-point number (NaN & Inf give null).
+ *          `key` NULL = element of an array.
+ */
+void PW_Json_Str(pw_writer_t *w, const char *key, const char *s);
+void PW_Json_Int(pw_writer_t *w, const char *key, int64_t v);
+void PW_Json_Fixed(pw_writer_t *w, const char *key, double v, int digits);
+
+/**
+ * @brief   true = everything fitted, the payload can be sent.
+ */
+static inline bool PW_Ok(const pw_writer_t *w) { return !w->overflow && w->depth == 0; }
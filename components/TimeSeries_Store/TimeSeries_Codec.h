@@ -0,0 +1,60 @@
+/*===========================================================================================
+ * @brief  Compression of samples, shared by TimeSeries_Store.c & TimeSeries_Log.c (private to this component)
+ *
+ *   * Time:  delta-of-delta as zig-zag varint (a regular grid gives 0)
+ *   * Value: XOR of the float bits with the previous value, stored without its zero bytes:
+ *            header bits 0..2 = nx bytes stored (0 = unchanged), bits 3..4 = tz trailing zero bytes cut off
+========================================================================================================*/
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define TS_CODEC_XOR_MASK   (0x1F)      // Bits of the header used by the XOR value
+
+static inline uint32_t TS_Bits(float v)    { uint32_t b; memcpy(&b, &v, sizeof(b)); return b; }
+static inline float    TS_Float(uint32_t b) { float v; memcpy(&v, &b, sizeof(v)); return v; }
+
+/*------------------------------------------------------------
+  Varint: zig-zag, 7 bits per byte (max. 10 bytes)
+-------------------------------------------------------------*/
+static inline size_t TS_Put_Varint(uint8_t *out, int64_t v)
+{ uint64_t u = ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);     // Zig-zag: small negative numbers stay small
+  size_t n = 0;
+  while (u >= 0x80) { out[n++] = (uint8_t)(u | 0x80); u >>= 7; }
+  out[n++] = (uint8_t)u;
+  return n;
+}
+
+static inline size_t TS_Get_Varint(const uint8_t *in, size_t avail, int64_t *v)
+{ uint64_t u = 0;
+  size_t n = 0;
+  for (int shift = 0; n < avail && shift < 64; shift += 7) {
+      uint8_t b = in[n++];
+      u |= (uint64_t)(b & 0x7F) << shift;
+      if (!(b & 0x80)) { *v = (int64_t)(u >> 1) ^ -(int64_t)(u & 1); return n; } }
+  return 0;                                                  // Broken: ends within the varint
+}
+
+/*------------------------------------------------------------
+  XOR value: header bits & bytes to store / read back
+-------------------------------------------------------------*/
+static inline uint8_t TS_Xor_Encode(uint32_t x, uint8_t *bytes_out, size_t *num_out)
+{ uint8_t tz = 0, nx = 0;
+  if (x) {
+      while (tz < 3 && (x & 0xFF) == 0) { x >>= 8; tz++; }
+      for (uint32_t r = x; r; r >>= 8) { bytes_out[nx++] = (uint8_t)r; } }
+  *num_out = nx;
+  return nx | (tz << 3);
+}
+
+static inline size_t TS_Xor_Decode(uint8_t hdr, const uint8_t *in, size_t avail, uint32_t *x_out, bool *ok)
+{ uint8_t nx = hdr & 0x07, tz = (hdr >> 3) & 0x03;
+  *ok = (nx <= 4 && nx <= avail);
+  if (!*ok) { return 0; }                                    // Broken
+  uint32_t x = 0;
+  for (uint8_t b = 0; b < nx; b++) { x |= (uint32_t)in[b] << (8 * b); }
+  *x_out = x << (8 * tz);
+  return nx;
+}
@@ -0,0 +1,538 @@
+/*===========================================================================================
+ * @file        TimeSeries_Log.c
+ * @brief       Persistent time-series log on flash, append-only segment files (see TimeSeries_Log.h)
+ *
+ * Files in 'dir':  seg_NNNNNNNN.tsl  segment = pages of TS_LOG_PAGE_BYTES, ONLY appended (the newest is active)
+ *                  seg_NNNNNNNN.idx  index of a full segment: time range, offset & records of each page
+ *                  *.tmp             index being written (renamed when complete, deleted at the start)
+ * Page:   header (magic, records, bytes used, columns, schema, CRC32, time of first & last record), then
+ *         the records, encoded against their predecessor in the SAME page (a page decodes on its own):
+ *            [varint]          delta-of-delta of the time in ms, zig-zag
+ *            per column: byte  XOR header of TimeSeries_Codec.h + its bytes
+ * Crash:  a page is written with ONE fwrite + fsync. A torn or broken page can ONLY be the last one
+ *         of the active segment: it is cut off at the start, so appending goes on page-aligned.
+========================================================================================================*/
+/*----------
+   INCLUDES
+------------*/
+#include "TimeSeries_Log.h"     // For THIS component
+#include "TimeSeries_Codec.h"   // Compression of the samples
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+/*------------------
+  ESP Logging: TAG
+------------------*/
+#include <esp_log.h>                 // For ESP-logging
+static const char *TAG = "TS_Log";   // TAG for logging
+/*                        12345678 */
+/*----------------------------
+   Constants via #define
+------------------------------*/
+#define TS_LOG_PAGE_MAGIC   (0x5453)                            // 'TS'
+#define TS_LOG_IDX_MAGIC    (0x58444954)                        // 'TIDX'
+#define TS_LOG_MAX_SEGMENTS (64)                                // Max. segments of a log
+#define TS_LOG_MAX_RECORD   (10 + 5 * TS_LOG_MAX_COLS)          // Varint of an int64 + header & 4 XOR bytes per column
+#define TS_LOG_PATH_LEN     (96)
+/*----------------------------
+   STRUCTURES
+------------------------------*/
+typedef struct {
+    uint16_t magic;             // TS_LOG_PAGE_MAGIC
+    uint16_t count;             // Records in the page
+    uint16_t used;              // Bytes of 'data' used
+    uint16_t num_cols;          // Columns of each record
+    uint32_t schema;            // Schema of the log
+    uint32_t crc;               // CRC32 of the whole page with 'crc' = 0
+    int64_t  t_first;           // Time of the first record (ms)
+    int64_t  t_last;            // Time of the last record (ms)
+    uint8_t  data[];            // Records, encoded
+} ts_log_page_t;
+#define TS_LOG_DATA_BYTES   (TS_LOG_PAGE_BYTES - offsetof(ts_log_page_t, data))
+
+typedef union {                 // ONE page as written to flash
+    ts_log_page_t page;
+    uint8_t       raw[TS_LOG_PAGE_BYTES];
+} ts_log_page_buf_t;
+
+typedef struct {                // Entry of an index file: ONE page
+    int64_t  t_first;           // Time of the first record
+    int64_t  t_last;            // Time of the last record
+    uint32_t offset;            // Offset of the page in the segment file
+    uint32_t count;             // Records in the page
+} ts_log_idx_t;
+
+typedef struct {                // Header of an index file, followed by 'pages' entries
+    uint32_t magic;             // TS_LOG_IDX_MAGIC
+    uint32_t pages;             // Pages of the segment
+    uint32_t crc;               // CRC32 of the entries
+    uint32_t schema;            // Schema of the log
+} ts_log_idx_hdr_t;
+
+typedef struct {                // ONE segment file
+    uint32_t id;                // Number in the file name, rising
+    uint32_t pages;             // Pages in the file
+    uint32_t records;           // Records in the file
+    int64_t  t_first;           // Time of the first record
+    int64_t  t_last;            // Time of the last record
+} ts_log_seg_t;
+
+typedef struct {                // Encoder state within a page
+    int64_t  prev_t;            // Time of the previous record
+    int64_t  prev_delta;        // Time delta of the previous record
+    uint32_t prev_bits[TS_LOG_MAX_COLS]; // Bits of the previous values
+} ts_log_enc_t;
+
+struct ts_log_s {
+    SemaphoreHandle_t mutex;    // Writers & readers take turns (short: ONE record or ONE page)
+    ts_log_config_t cfg;        // Settings, 'dir' copied to 'dir'
+    char     dir[TS_LOG_PATH_LEN - 24];
+    uint32_t seg_pages;         // Pages of a full segment
+    ts_log_seg_t seg[TS_LOG_MAX_SEGMENTS]; // Segments, oldest first, the last is active
+    size_t   num_seg;           // Segments in 'seg'
+    ts_log_idx_t *act_idx;      // Index of the active segment (seg_pages entries)
+    ts_log_page_buf_t buf;      // Page collected in RAM (count 0 = empty)
+    ts_log_enc_t enc;           // Encoder state of 'buf'
+    int64_t  last_t;            // Time of the newest record (times never go backwards)
+    uint32_t pages_written;     // COUNTER of pages written
+};
+
+/*------------------------------------------------------------
+  Helpers: CRC32 (poly 0xEDB88320) & file names
+-------------------------------------------------------------*/
+static uint32_t TS_Log_CRC32(uint32_t crc, const void *data, size_t len)
+{ const uint8_t *p = data;
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++) {
+      crc ^= p[i];
+      for (int b = 0; b < 8; b++) { crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1; } }
+  return ~crc;
+}
+
+static uint32_t TS_Log_Page_CRC(const ts_log_page_buf_t *pb)  // Before 'crc', 0 for it, after it: NO copy of the page (stack)
+{ static const uint32_t zero = 0;
+  const size_t ofs = offsetof(ts_log_page_t, crc);
+  uint32_t crc = TS_Log_CRC32(0, pb->raw, ofs);
+  crc = TS_Log_CRC32(crc, &zero, sizeof(zero));
+  return TS_Log_CRC32(crc, &pb->raw[ofs + sizeof(zero)], sizeof(pb->raw) - ofs - sizeof(zero));
+}
+
+static void TS_Log_Path(const struct ts_log_s *log, uint32_t id, const char *ext, char *out)
+{ snprintf(out, TS_LOG_PATH_LEN, "%s/seg_%08" PRIu32 ".%s", log->dir, id, ext); }
+
+/*------------------------------------------------------------
+  TS_Log_Page_Check: ONE page read from flash
+-------------------------------------------------------------*/
+typedef enum { TS_LOG_PAGE_OK, TS_LOG_PAGE_BROKEN, TS_LOG_PAGE_OTHER_SCHEMA } ts_log_page_state_t;
+
+static ts_log_page_state_t TS_Log_Page_Check(const struct ts_log_s *log, const ts_log_page_buf_t *pb)
+{ const ts_log_page_t *pg = &pb->page;
+  if (pg->magic != TS_LOG_PAGE_MAGIC || pg->count == 0 || pg->used > TS_LOG_DATA_BYTES || pg->crc != TS_Log_Page_CRC(pb)) {
+      return TS_LOG_PAGE_BROKEN; }
+  if (pg->schema != log->cfg.schema || pg->num_cols != log->cfg.num_cols) { return TS_LOG_PAGE_OTHER_SCHEMA; }
+  return TS_LOG_PAGE_OK;
+}
+
+/*------------------------------------------------------------
+  TS_Log_Seg_Set: segment state from its page index
+-------------------------------------------------------------*/
+static void TS_Log_Seg_Set(ts_log_seg_t *seg, const ts_log_idx_t *idx, uint32_t pages)
+{ seg->pages   = pages;
+  seg->records = 0;
+  seg->t_first = (pages > 0) ? idx[0].t_first : 0;
+  seg->t_last  = (pages > 0) ? idx[pages - 1].t_last : 0;
+  for (uint32_t p = 0; p < pages; p++) { seg->records += idx[p].count; }
+}
+
+/*------------------------------------------------------------
+  TS_Log_Seg_Scan: read ALL pages of a segment, cut off a torn / broken end
+    Returns the pages, -1 = segment of another schema
+-------------------------------------------------------------*/
+static int TS_Log_Seg_Scan(const struct ts_log_s *log, uint32_t id, ts_log_idx_t *idx)
+{ char path[TS_LOG_PATH_LEN];
+  TS_Log_Path(log, id, "tsl", path);
+  FILE *f = fopen(path, "rb");
+  if (f == NULL) { return 0; }
+  ts_log_page_buf_t pb;
+  uint32_t pages = 0;
+  while (pages < log->seg_pages && fread(pb.raw, 1, sizeof(pb.raw), f) == sizeof(pb.raw)) {
+      ts_log_page_state_t state = TS_Log_Page_Check(log, &pb);
+      if (state == TS_LOG_PAGE_OTHER_SCHEMA) { fclose(f); return -1; }
+      if (state == TS_LOG_PAGE_BROKEN) { break; }
+      idx[pages] = (ts_log_idx_t){ .t_first = pb.page.t_first, .t_last = pb.page.t_last,
+                                   .offset = pages * TS_LOG_PAGE_BYTES, .count = pb.page.count };
+      pages++; }
+  fclose(f);
+  struct stat st;
+  if (stat(path, &st) == 0 && (size_t)st.st_size != (size_t)pages * TS_LOG_PAGE_BYTES) { // Torn write before a crash / power loss
+      ESP_LOGW(TAG, "!!     ⚠️  %s: %ld bytes, %d valid pages >> cut off the rest", path, (long)st.st_size, (int)pages);
+      if (truncate(path, (off_t)pages * TS_LOG_PAGE_BYTES) != 0) {
+          ESP_LOGE(TAG, "--  ❌ Can't truncate %s: %s", path, strerror(errno)); } }
+  return (int)pages;
+}
+
+/*------------------------------------------------------------
+  TS_Log_Idx_Write / TS_Log_Idx_Load: index file of a full segment
+-------------------------------------------------------------*/
+static void TS_Log_Idx_Write(const struct ts_log_s *log, uint32_t id, const ts_log_idx_t *idx, uint32_t pages)
+{ char path[TS_LOG_PATH_LEN], tmp[TS_LOG_PATH_LEN];
+  TS_Log_Path(log, id, "idx", path);
+  TS_Log_Path(log, id, "tmp", tmp);
+  ts_log_idx_hdr_t hdr = { .magic = TS_LOG_IDX_MAGIC, .pages = pages, .schema = log->cfg.schema,
+                           .crc = TS_Log_CRC32(0, idx, pages * sizeof(*idx)) };
+  FILE *f = fopen(tmp, "wb");
+  bool ok = (f != NULL);
+  if (ok) {
+      ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1 && fwrite(idx, sizeof(*idx), pages, f) == pages;
+      ok = (fflush(f) == 0) && ok;
+      fsync(fileno(f));
+      fclose(f); }
+  if (ok) { ok = (rename(tmp, path) == 0); }                     // Complete or not there at all
+  if (!ok) {
+      unlink(tmp);
+      ESP_LOGW(TAG, "!!     ⚠️  Can't write %s (rebuilt at the next start)", path); }
+}
+
+static int TS_Log_Idx_Load(const struct ts_log_s *log, uint32_t id, ts_log_idx_t *idx)
+{ char path[TS_LOG_PATH_LEN];
+  TS_Log_Path(log, id, "idx", path);
+  FILE *f = fopen(path, "rb");
+  if (f == NULL) { return -1; }
+  ts_log_idx_hdr_t hdr;
+  bool ok = fread(&hdr, sizeof(hdr), 1, f) == 1 && hdr.magic == TS_LOG_IDX_MAGIC && hdr.schema == log->cfg.schema
+            && hdr.pages > 0 && hdr.pages <= log->seg_pages && fread(idx, sizeof(*idx), hdr.pages, f) == hdr.pages
+            && hdr.crc == TS_Log_CRC32(0, idx, hdr.pages * sizeof(*idx));
+  fclose(f);
+  struct stat st;
+  TS_Log_Path(log, id, "tsl", path);
+  if (ok) { ok = (stat(path, &st) == 0 && (size_t)st.st_size == (size_t)hdr.pages * TS_LOG_PAGE_BYTES); } // Index fits the segment?
+  return ok ? (int)hdr.pages : -1;
+}
+
+/*------------------------------------------------------------
+  TS_Log_Seg_Delete: delete the files of the segment at position 'pos'
+-------------------------------------------------------------*/
+static void TS_Log_Seg_Delete(struct ts_log_s *log, size_t pos)
+{ char path[TS_LOG_PATH_LEN];
+  TS_Log_Path(log, log->seg[pos].id, "idx", path);
+  unlink(path);
+  TS_Log_Path(log, log->seg[pos].id, "tsl", path);
+  unlink(path);
+  memmove(&log->seg[pos], &log->seg[pos + 1], (log->num_seg - pos - 1) * sizeof(log->seg[0]));
+  log->num_seg--;
+}
+
+static int TS_Log_Cmp_Id(const void *a, const void *b)
+{ uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+  return (x > y) - (x < y);
+}
+
+/*------------------------------------------------------------
+  TS_Log_Recover: find the segments of 'dir', check & repair them
+-------------------------------------------------------------*/
+static esp_err_t TS_Log_Recover(struct ts_log_s *log)
+{ DIR *d = opendir(log->dir);
+  if (d == NULL) { return ESP_FAIL; }
+  uint32_t ids[TS_LOG_MAX_SEGMENTS * 2], idx_ids[TS_LOG_MAX_SEGMENTS * 2];
+  size_t   num_ids = 0, num_idx_ids = 0;
+  char path[TS_LOG_PATH_LEN];
+  struct dirent *e;
+  while ((e = readdir(d)) != NULL) {
+      unsigned long id;
+      char ext[8];
+      if (sscanf(e->d_name, "seg_%8lu.%3s", &id, ext) != 2) { continue; }
+      if (strcmp(ext, "tsl") == 0 && num_ids < sizeof(ids) / sizeof(ids[0])) { ids[num_ids++] = (uint32_t)id; }
+      if (strcmp(ext, "idx") == 0 && num_idx_ids < sizeof(idx_ids) / sizeof(idx_ids[0])) { idx_ids[num_idx_ids++] = (uint32_t)id; }
+      if (strcmp(ext, "tmp") == 0) {                            // Index not completed before a crash
+          TS_Log_Path(log, (uint32_t)id, "tmp", path);
+          unlink(path); } }
+  closedir(d);
+  qsort(ids, num_ids, sizeof(ids[0]), TS_Log_Cmp_Id);
+  for (size_t k = 0; k < num_idx_ids; k++) {                   // Index without its segment (crash while evicting)
+      if (bsearch(&idx_ids[k], ids, num_ids, sizeof(ids[0]), TS_Log_Cmp_Id) == NULL) {
+          TS_Log_Path(log, idx_ids[k], "idx", path); unlink(path); } }
+  //..................................................
+  // Check each segment: full ones by their index (rebuilt if missing / broken), the newest by its pages
+  //..................................................
+  log->num_seg = 0;
+  for (size_t i = 0; i < num_ids; i++) {
+      bool newest = (i == num_ids - 1);
+      int pages = newest ? -1 : TS_Log_Idx_Load(log, ids[i], log->act_idx);
+      if (pages < 0) {
+          pages = TS_Log_Seg_Scan(log, ids[i], log->act_idx);
+          if (pages < 0) {                                     // Log of other columns: start again
+              ESP_LOGW(TAG, "!!     ⚠️  %s: log of another schema >> deleted", log->dir);
+              for (size_t k = 0; k < num_ids; k++) {
+                  TS_Log_Path(log, ids[k], "idx", path); unlink(path);
+                  TS_Log_Path(log, ids[k], "tsl", path); unlink(path); }
+              log->num_seg = 0;
+              return ESP_OK; }
+          if (!newest && pages > 0) { TS_Log_Idx_Write(log, ids[i], log->act_idx, pages); } }
+      if (pages == 0) {                                        // Nothing valid in it
+          TS_Log_Path(log, ids[i], "idx", path); unlink(path);
+          TS_Log_Path(log, ids[i], "tsl", path); unlink(path);
+          continue; }
+      if (log->num_seg == TS_LOG_MAX_SEGMENTS) { TS_Log_Seg_Delete(log, 0); }
+      log->seg[log->num_seg].id = ids[i];
+      TS_Log_Seg_Set(&log->seg[log->num_seg], log->act_idx, pages);
+      log->num_seg++; }
+  //..................................................
+  // Too many segments (e.g. 'max_segments' made smaller)
+  //..................................................
+  while (log->num_seg > log->cfg.max_segments) { TS_Log_Seg_Delete(log, 0); }
+  if (log->num_seg > 0 && log->seg[log->num_seg - 1].pages > 0) {  // Index of the active segment: from its pages again
+      ts_log_seg_t *act = &log->seg[log->num_seg - 1];
+      if (TS_Log_Seg_Scan(log, act->id, log->act_idx) != (int)act->pages) { TS_Log_Seg_Set(act, log->act_idx, 0); } }
+  return ESP_OK;
+}
+
+/*------------------------------------------------------------
+  TS_Log_Open
+-------------------------------------------------------------*/
+esp_err_t TS_Log_Open(const ts_log_config_t *cfg, ts_log_handle_t *handle_out)
+{ if (cfg == NULL || cfg->dir == NULL || handle_out == NULL || cfg->num_cols == 0 || cfg->num_cols > TS_LOG_MAX_COLS
+      || cfg->segment_bytes < TS_LOG_PAGE_BYTES || cfg->max_segments < 2 || strlen(cfg->dir) >= TS_LOG_PATH_LEN - 24) {
+      return ESP_ERR_INVALID_ARG; }
+  struct ts_log_s *log = calloc(1, sizeof(*log));
+  if (log == NULL) { return ESP_ERR_NO_MEM; }
+  log->cfg       = *cfg;
+  strcpy(log->dir, cfg->dir);
+  log->cfg.dir   = log->dir;
+  log->cfg.max_segments = (cfg->max_segments > TS_LOG_MAX_SEGMENTS) ? TS_LOG_MAX_SEGMENTS : cfg->max_segments;
+  log->seg_pages = cfg->segment_bytes / TS_LOG_PAGE_BYTES;
+  log->act_idx   = calloc(log->seg_pages, sizeof(ts_log_idx_t));
+  log->mutex     = xSemaphoreCreateMutex();
+  if (log->act_idx == NULL || log->mutex == NULL) {
+      free(log->act_idx); free(log);
+      return ESP_ERR_NO_MEM; }
+  if (mkdir(log->dir, 0775) != 0 && errno != EEXIST) {
+      ESP_LOGE(TAG, "--  ❌ Can't create %s: %s", log->dir, strerror(errno)); }
+  if (TS_Log_Recover(log) != ESP_OK) {
+      ESP_LOGE(TAG, "--  ❌ Can't read %s", log->dir);
+      vSemaphoreDelete(log->mutex); free(log->act_idx); free(log);
+      return ESP_FAIL; }
+  if (log->num_seg > 0) { log->last_t = log->seg[log->num_seg - 1].t_last; }
+  ts_log_info_t info;
+  TS_Log_Get_Info(log, &info);
+  ESP_LOGI(TAG, "--  ✅ Log %s: %d segments, %d kB, %" PRIu32 " records (max. %d segments of %d kB)", log->dir,
+           (int)info.segments, (int)(info.bytes / 1024), info.records, (int)log->cfg.max_segments, (int)(cfg->segment_bytes / 1024));
+  *handle_out = log;
+  return ESP_OK;
+}
+
+/*------------------------------------------------------------
+  TS_Log_Write_Page: the page in RAM >> active segment (mutex taken)
+-------------------------------------------------------------*/
+static esp_err_t TS_Log_Write_Page(struct ts_log_s *log)
+{ ts_log_page_t *pg = &log->buf.page;
+  if (pg->count == 0) { return ESP_OK; }
+  pg->crc = TS_Log_Page_CRC(&log->buf);
+  //..................................................
+  // Active segment full: write its index, evict the oldest, start a new one
+  //..................................................
+  if (log->num_seg == 0 || log->seg[log->num_seg - 1].pages >= log->seg_pages) {
+      if (log->num_seg > 0) {
+          ts_log_seg_t *full = &log->seg[log->num_seg - 1];
+          TS_Log_Idx_Write(log, full->id, log->act_idx, full->pages); }
+      while (log->num_seg >= log->cfg.max_segments) { TS_Log_Seg_Delete(log, 0); }
+      uint32_t id = (log->num_seg > 0) ? log->seg[log->num_seg - 1].id + 1 : 1;
+      log->seg[log->num_seg++] = (ts_log_seg_t){ .id = id }; }
+  ts_log_seg_t *act = &log->seg[log->num_seg - 1];
+  //..................................................
+  // ONE aligned write of the whole page
+  //..................................................
+  char path[TS_LOG_PATH_LEN];
+  TS_Log_Path(log, act->id, "tsl", path);
+  FILE *f = fopen(path, "ab");
+  bool ok = (f != NULL);
+  if (ok) {
+      ok = fwrite(log->buf.raw, sizeof(log->buf.raw), 1, f) == 1;
+      ok = (fflush(f) == 0) && ok;
+      ok = (fsync(fileno(f)) == 0) && ok;
+      ok = (fclose(f) == 0) && ok; }
+  esp_err_t err = ESP_OK;
+  if (ok) {
+      log->act_idx[act->pages] = (ts_log_idx_t){ .t_first = pg->t_first, .t_last = pg->t_last,
+                                                 .offset = act->pages * TS_LOG_PAGE_BYTES, .count = pg->count };
+      TS_Log_Seg_Set(act, log->act_idx, act->pages + 1);
+      log->pages_written++;
+  } else {                                                     // Records of the page are lost, keep the segment page-aligned
+      ESP_LOGE(TAG, "--  ❌ Can't write a page to %s: %s", path, strerror(errno));
+      truncate(path, (off_t)act->pages * TS_LOG_PAGE_BYTES);
+      err = ESP_FAIL; }
+  memset(&log->buf, 0, sizeof(log->buf));
+  return err;
+}
+
+/*------------------------------------------------------------
+  TS_Log_Encode: ONE record against the state of the encoder
+-------------------------------------------------------------*/
+static size_t TS_Log_Encode(ts_log_enc_t *enc, uint16_t num_cols, int64_t t_ms, const float *values, uint8_t *out)
+{ int64_t delta = t_ms - enc->prev_t;
+  size_t  n     = TS_Put_Varint(out, delta - enc->prev_delta);
+  for (uint16_t c = 0; c < num_cols; c++) {
+      uint32_t bits = TS_Bits(values[c]);
+      size_t   nx;
+      out[n] = TS_Xor_Encode(bits ^ enc->prev_bits[c], &out[n + 1], &nx);
+      n += 1 + nx;
+      enc->prev_bits[c] = bits; }
+  enc->prev_t     = t_ms;
+  enc->prev_delta = delta;
+  return n;
+}
+
+static void TS_Log_Page_Start(struct ts_log_s *log, int64_t t_ms)
+{ memset(&log->buf, 0, sizeof(log->buf));
+  memset(&log->enc, 0, sizeof(log->enc));
+  log->buf.page.magic    = TS_LOG_PAGE_MAGIC;
+  log->buf.page.num_cols = log->cfg.num_cols;
+  log->buf.page.schema   = log->cfg.schema;
+  log->buf.page.t_first  = t_ms;
+  log->enc.prev_t        = t_ms;
+}
+
+/*------------------------------------------------------------
+  TS_Log_Append
+-------------------------------------------------------------*/
+esp_err_t TS_Log_Append(ts_log_handle_t log, int64_t t_ms, const float *values)
+{ if (log == NULL || values == NULL) { return ESP_ERR_INVALID_ARG; }
+  uint8_t rec[TS_LOG_MAX_RECORD];
+  esp_err_t err = ESP_OK;
+  xSemaphoreTake(log->mutex, portMAX_DELAY);
+  if (t_ms < log->last_t) { t_ms = log->last_t; }              // Never backwards
+  ts_log_page_t *pg = &log->buf.page;
+  if (pg->count == 0) { TS_Log_Page_Start(log, t_ms); }
+  ts_log_enc_t next = log->enc;                                // Encode on a copy: the record may need a new page
+  size_t n = TS_Log_Encode(&next, log->cfg.num_cols, t_ms, values, rec);
+  if (pg->used + n > TS_LOG_DATA_BYTES || pg->count == UINT16_MAX) {
+      err = TS_Log_Write_Page(log);
+      TS_Log_Page_Start(log, t_ms);
+      next = log->enc;
+      n = TS_Log_Encode(&next, log->cfg.num_cols, t_ms, values, rec); }
+  memcpy(&pg->data[pg->used], rec, n);
+  pg->used  += n;
+  pg->count++;
+  pg->t_last = t_ms;
+  log->enc    = next;
+  log->last_t = t_ms;
+  xSemaphoreGive(log->mutex);
+  return err;
+}
+
+/*------------------------------------------------------------
+  TS_Log_Flush
+-------------------------------------------------------------*/
+esp_err_t TS_Log_Flush(ts_log_handle_t log)
+{ if (log == NULL) { return ESP_ERR_INVALID_ARG; }
+  xSemaphoreTake(log->mutex, portMAX_DELAY);
+  esp_err_t err = TS_Log_Write_Page(log);
+  xSemaphoreGive(log->mutex);
+  return err;
+}
+
+/*------------------------------------------------------------
+  TS_Log_Decode_Page: hand the records in range to the callback
+    Returns false = stopped by the callback
+-------------------------------------------------------------*/
+static bool TS_Log_Decode_Page(const ts_log_page_t *pg, int64_t from_ms, int64_t to_ms, ts_log_record_cb_t cb, void *ctx, size_t *emitted)
+{ int64_t  t = pg->t_first, delta = 0;
+  uint32_t bits[TS_LOG_MAX_COLS] = { 0 };
+  float    values[TS_LOG_MAX_COLS];
+  size_t   p = 0;
+  for (uint16_t k = 0; k < pg->count; k++) {
+      int64_t dod;
+      size_t n = TS_Get_Varint(&pg->data[p], pg->used - p, &dod);
+      if (n == 0) { return true; }                             // Broken page: skip its rest
+      p += n;
+      for (uint16_t c = 0; c < pg->num_cols; c++) {
+          uint32_t x;
+          bool ok = (p < pg->used);
+          if (ok) { p++; p += TS_Xor_Decode(pg->data[p - 1], &pg->data[p], pg->used - p, &x, &ok); }
+          if (!ok) { return true; }
+          bits[c] ^= x;
+          values[c] = TS_Float(bits[c]); }
+      delta += dod;
+      t     += delta;
+      if (t > to_ms) { return true; }
+      if (t < from_ms) { continue; }
+      (*emitted)++;
+      if (!cb(ctx, t, values, pg->num_cols)) { return false; } }
+  return true;
+}
+
+/*------------------------------------------------------------
+  TS_Log_Query: segment by segment, page by page, oldest first
+-------------------------------------------------------------*/
+size_t TS_Log_Query(ts_log_handle_t log, int64_t from_ms, int64_t to_ms, ts_log_record_cb_t cb, void *ctx)
+{ if (log == NULL || cb == NULL || to_ms < from_ms) { return 0; }
+  ts_log_page_buf_t *pb   = malloc(sizeof(*pb));               // ONE page, decoded outside the lock
+  ts_log_page_buf_t *ram  = malloc(sizeof(*ram));              // Page in RAM at the start of the query
+  ts_log_idx_t      *idx  = malloc(log->seg_pages * sizeof(*idx));
+  ts_log_seg_t      *segs = malloc(sizeof(log->seg));
+  size_t emitted = 0, num_seg;
+  if (pb == NULL || ram == NULL || idx == NULL || segs == NULL) { goto done; }
+  //..................................................
+  // Snapshot: segments & page in RAM of the same moment (pages written later are NOT read twice)
+  //..................................................
+  xSemaphoreTake(log->mutex, portMAX_DELAY);
+  num_seg = log->num_seg;
+  memcpy(segs, log->seg, num_seg * sizeof(segs[0]));
+  *ram = log->buf;
+  xSemaphoreGive(log->mutex);
+  for (size_t s = 0; s < num_seg; s++) {
+      if (segs[s].t_first > to_ms) { break; }                  // Segments are in time order
+      if (segs[s].t_last < from_ms) { continue; }
+      char path[TS_LOG_PATH_LEN];
+      TS_Log_Path(log, segs[s].id, "tsl", path);
+      xSemaphoreTake(log->mutex, portMAX_DELAY);
+      int pages = (s + 1 < num_seg) ? TS_Log_Idx_Load(log, segs[s].id, idx) : -1;
+      xSemaphoreGive(log->mutex);
+      if (pages < 0) {                                         // Active segment or no index: read its pages
+          pages = (int)segs[s].pages;
+          for (int p = 0; p < pages; p++) {
+              idx[p] = (ts_log_idx_t){ .t_first = INT64_MIN, .t_last = INT64_MAX, .offset = p * TS_LOG_PAGE_BYTES }; } }
+      if (pages > (int)segs[s].pages) { pages = (int)segs[s].pages; }
+      for (int p = 0; p < pages; p++) {
+          if (idx[p].t_first != INT64_MIN && (idx[p].t_last < from_ms || idx[p].t_first > to_ms)) { continue; }
+          xSemaphoreTake(log->mutex, portMAX_DELAY);           // The segment may be evicted meanwhile
+          FILE *f = fopen(path, "rb");
+          bool ok = (f != NULL && fseek(f, idx[p].offset, SEEK_SET) == 0 && fread(pb->raw, sizeof(pb->raw), 1, f) == 1);
+          if (f) { fclose(f); }
+          xSemaphoreGive(log->mutex);
+          if (!ok) { break; }
+          if (TS_Log_Page_Check(log, pb) != TS_LOG_PAGE_OK) { continue; }
+          if (pb->page.t_first > to_ms) { goto done; }
+          if (pb->page.t_last < from_ms) { continue; }
+          if (!TS_Log_Decode_Page(&pb->page, from_ms, to_ms, cb, ctx, &emitted)) { goto done; } } }
+  if (ram->page.count > 0) { TS_Log_Decode_Page(&ram->page, from_ms, to_ms, cb, ctx, &emitted); }
+done:
+  free(pb); free(ram); free(idx); free(segs);
+  return emitted;
+}
+
+/*------------------------------------------------------------
+  TS_Log_Get_Info
+-------------------------------------------------------------*/
+esp_err_t TS_Log_Get_Info(ts_log_handle_t log, ts_log_info_t *info)
+{ if (log == NULL || info == NULL) { return ESP_ERR_INVALID_ARG; }
+  memset(info, 0, sizeof(*info));
+  xSemaphoreTake(log->mutex, portMAX_DELAY);
+  info->segments      = log->num_seg;
+  info->pages_written = log->pages_written;
+  for (size_t s = 0; s < log->num_seg; s++) {
+      info->bytes   += (size_t)log->seg[s].pages * TS_LOG_PAGE_BYTES;
+      info->records += log->seg[s].records; }
+  info->records += log->buf.page.count;
+  if (log->num_seg > 0) { info->first_t_ms = log->seg[0].t_first; info->last_t_ms = log->seg[log->num_seg - 1].t_last; }
+  else if (log->buf.page.count > 0) { info->first_t_ms = log->buf.page.t_first; }
+  if (log->buf.page.count > 0) { info->last_t_ms = log->buf.page.t_last; }
+  xSemaphoreGive(log->mutex);
+  return ESP_OK;
+}
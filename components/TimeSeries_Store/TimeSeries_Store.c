@@ -0,0 +1,285 @@
+/*===========================================================================================
+ * @file        TimeSeries_Store.c
+ * @brief       Time-series store in RAM / PSRAM with compressed samples (see TimeSeries_Store.h)
+ *
+ * Layout:  ONE memory area = num_series x blocks_per_series blocks of CONFIG_TS_STORE_BLOCK_BYTES.
+ *          A series writes its blocks as a ring; block 'seq' (1, 2, ...) is at slot (seq-1) % blocks_per_series.
+ * Block:   header with the FIRST sample in full, then the further samples encoded against their predecessor:
+ *            byte 0   bits 0..2  nx = bytes of the XOR of the value bits (0 = value unchanged)
+ *                     bits 3..4  tz = trailing zero bytes of the XOR (not stored)
+ *                     bit  5     1 = time delta same as before (delta-of-delta 0, no time bytes)
+ *            [varint]            delta-of-delta of the time in ms, zig-zag (only if bit 5 = 0)
+ *            [nx bytes]          XOR >> (8*tz), low byte first
+ *          So every block can be decoded on its own, a dropped block never breaks the others.
+========================================================================================================*/
+/*----------
+   INCLUDES
+------------*/
+#include "TimeSeries_Store.h"   // For THIS component
+#include "TimeSeries_Codec.h"   // Compression of the samples
+#include "sdkconfig.h"
+#include <string.h>
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"      // For PSRAM
+/*------------------
+  ESP Logging: TAG
+------------------*/
+#include <esp_log.h>                 // For ESP-logging
+static const char *TAG = "TS_Store"; // TAG for logging
+/*                        12345678 */
+/*----------------------------
+   Constants via #define
+------------------------------*/
+#define TS_BLOCK_BYTES      ((CONFIG_TS_STORE_BLOCK_BYTES + 7) & ~7) // Size of ONE block incl. header: multiple of 8 (int64 of the next block)
+#define TS_MAX_SAMPLE_BYTES (1 + 10 + 4)                        // Header + varint of an int64 + 4 XOR bytes
+#define TS_FLAG_SAME_DELTA  (0x20)                              // Bit 5 of the sample header
+/*----------------------------
+   STRUCTURES
+------------------------------*/
+typedef struct {
+    uint32_t seq;               // Running number of the block in its series (0 = empty)
+    uint16_t count;             // Samples in the block, incl. the first
+    uint16_t used;              // Bytes of 'data' used
+    int64_t  t_first;           // Time of the first sample (ms)
+    int64_t  t_last;            // Time of the last sample (ms)
+    float    v_first;           // Value of the first sample
+    uint8_t  data[];            // Further samples, encoded
+} ts_block_t;
+#define TS_DATA_BYTES       (TS_BLOCK_BYTES - offsetof(ts_block_t, data))
+_Static_assert(TS_BLOCK_BYTES % _Alignof(ts_block_t) == 0, "blocks sit back to back: size must keep the int64 fields aligned");
+
+typedef struct {
+    uint32_t head_seq;          // Block written now (0 = no sample yet)
+    uint32_t appended;          // COUNTER of samples appended
+    int64_t  prev_t;            // Encoder: time of the previous sample
+    int64_t  prev_delta;        // Encoder: time delta of the previous sample
+    uint32_t prev_bits;         // Encoder: bits of the previous value
+} ts_series_t;
+
+struct ts_store_s {
+    SemaphoreHandle_t mutex;    // Writers & readers take turns (short: ONE sample or ONE block copy)
+    size_t   num_series;        // Number of series
+    size_t   blocks_per_series; // Ring size of each series
+    uint8_t  *mem;              // The blocks of ALL series
+    bool     in_psram;          // 'mem' is in PSRAM
+    ts_series_t series[];       // State of each series
+};
+
+/*------------------------------------------------------------
+  Helper: block of a series
+-------------------------------------------------------------*/
+static inline ts_block_t *TS_Block(struct ts_store_s *st, size_t series, uint32_t seq)
+{ return (ts_block_t *)(st->mem + (series * st->blocks_per_series + (seq - 1) % st->blocks_per_series) * TS_BLOCK_BYTES); }
+
+/*------------------------------------------------------------
+  TS_Encode: ONE sample against the state of the encoder
+-------------------------------------------------------------*/
+static size_t TS_Encode(ts_series_t *ser, int64_t t_ms, float value, uint8_t *out)
+{ if (t_ms < ser->prev_t) { t_ms = ser->prev_t; }              // Never backwards
+  int64_t  delta = t_ms - ser->prev_t;
+  int64_t  dod   = delta - ser->prev_delta;
+  uint32_t bits  = TS_Bits(value);
+  uint8_t  xb[4];
+  size_t   nx;
+  uint8_t  hdr   = TS_Xor_Encode(bits ^ ser->prev_bits, xb, &nx);
+  size_t n = 0;
+  out[n++] = hdr | (dod == 0 ? TS_FLAG_SAME_DELTA : 0);
+  if (dod != 0) { n += TS_Put_Varint(&out[n], dod); }
+  memcpy(&out[n], xb, nx);
+  n += nx;
+  ser->prev_t     = t_ms;
+  ser->prev_delta = delta;
+  ser->prev_bits  = bits;
+  return n;
+}
+
+/*------------------------------------------------------------
+  TS_Store_Create
+-------------------------------------------------------------*/
+esp_err_t TS_Store_Create(size_t num_series, ts_store_handle_t *handle_out)
+{ if (num_series == 0 || handle_out == NULL) { return ESP_ERR_INVALID_ARG; }
+  struct ts_store_s *st = calloc(1, sizeof(*st) + num_series * sizeof(ts_series_t));
+  if (st == NULL) { return ESP_ERR_NO_MEM; }
+  size_t size = 0;
+#if CONFIG_SPIRAM
+  if (CONFIG_TS_STORE_PSRAM_KB > 0) {                          // PSRAM: much more history
+      size = (size_t)CONFIG_TS_STORE_PSRAM_KB * 1024;
+      st->mem = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+      st->in_psram = (st->mem != NULL); }
+#endif
+  if (st->mem == NULL) {
+      size = (size_t)CONFIG_TS_STORE_RAM_KB * 1024;
+      st->mem = heap_caps_malloc(size, MALLOC_CAP_8BIT); }
+  st->num_series        = num_series;
+  st->blocks_per_series = (st->mem != NULL) ? size / (num_series * TS_BLOCK_BYTES) : 0;
+  if (st->blocks_per_series < 2) {                             // Ring needs 2 blocks: the oldest is dropped, the newest kept
+      ESP_LOGE(TAG, "--  ❌ No memory for %d series (%d bytes)", (int)num_series, (int)size);
+      heap_caps_free(st->mem); free(st);
+      return ESP_ERR_NO_MEM; }
+  memset(st->mem, 0, st->blocks_per_series * num_series * TS_BLOCK_BYTES); // seq 0 = empty
+  st->mutex = xSemaphoreCreateMutex();
+  ESP_LOGI(TAG, "--  ✅ Store of %d series in %s: %d kB, %d blocks of %d bytes each", (int)num_series, st->in_psram ? "PSRAM" : "RAM",
+           (int)(size / 1024), (int)st->blocks_per_series, TS_BLOCK_BYTES);
+  *handle_out = st;
+  return ESP_OK;
+}
+
+/*------------------------------------------------------------
+  TS_Store_Append
+-------------------------------------------------------------*/
+esp_err_t TS_Store_Append(ts_store_handle_t st, size_t series, int64_t t_ms, float value)
+{ if (st == NULL || series >= st->num_series) { return ESP_ERR_INVALID_ARG; }
+  ts_series_t *ser = &st->series[series];
+  uint8_t enc[TS_MAX_SAMPLE_BYTES];
+  xSemaphoreTake(st->mutex, portMAX_DELAY);
+  ts_block_t *blk = NULL;
+  if (ser->head_seq != 0) {                                    // Try the block written now
+      blk = TS_Block(st, series, ser->head_seq);
+      ts_series_t next = *ser;                                 // Encode on a copy: the sample may need a new block
+      size_t n = TS_Encode(&next, t_ms, value, enc);
+      if (blk->used + n <= TS_DATA_BYTES && blk->count < UINT16_MAX) {
+          memcpy(&blk->data[blk->used], enc, n);
+          blk->used += n;
+          blk->count++;
+          blk->t_last = next.prev_t;
+          *ser = next;
+          ser->appended++;
+          xSemaphoreGive(st->mutex);
+          return ESP_OK; } }
+  //..................................................
+  // NEW block (the oldest one of the ring is dropped): starts with the sample in full
+  //..................................................
+  if (ser->head_seq != 0 && t_ms < ser->prev_t) { t_ms = ser->prev_t; } // Never backwards, also across blocks
+  ser->head_seq++;
+  blk = TS_Block(st, series, ser->head_seq);
+  blk->seq     = ser->head_seq;
+  blk->count   = 1;
+  blk->used    = 0;
+  blk->t_first = t_ms;
+  blk->t_last  = t_ms;
+  blk->v_first = value;
+  ser->prev_t     = t_ms;
+  ser->prev_delta = 0;
+  ser->prev_bits  = TS_Bits(value);
+  ser->appended++;
+  xSemaphoreGive(st->mutex);
+  return ESP_OK;
+}
+
+/*------------------------------------------------------------
+  Query: downsampling into buckets
+-------------------------------------------------------------*/
+typedef struct {
+    int64_t  from_ms, to_ms;    // Time range
+    uint32_t step_ms;           // Bucket size (0 = every sample)
+    ts_point_t bucket;          // Bucket collected now (n = 0: none)
+    double   sum;               // Sum of the values in the bucket
+    size_t   emitted;           // Points handed to the callback
+    ts_store_point_cb_t cb;
+    void     *ctx;
+} ts_query_t;
+
+static bool TS_Query_Emit(ts_query_t *q, const ts_point_t *p)
+{ q->emitted++;
+  return q->cb(q->ctx, p);
+}
+
+static bool TS_Query_Flush(ts_query_t *q)                      // Hand over the collected bucket
+{ if (q->bucket.n == 0) { return true; }
+  q->bucket.value = (float)(q->sum / q->bucket.n);
+  bool go_on = TS_Query_Emit(q, &q->bucket);
+  q->bucket.n = 0;
+  return go_on;
+}
+
+static bool TS_Query_Add(ts_query_t *q, int64_t t_ms, float v)  // ONE decoded sample
+{ if (t_ms < q->from_ms || t_ms > q->to_ms) { return true; }
+  if (q->step_ms == 0) {
+      ts_point_t p = { .t_ms = t_ms, .value = v, .min = v, .max = v, .n = 1 };
+      return TS_Query_Emit(q, &p); }
+  int64_t start = q->from_ms + (t_ms - q->from_ms) / q->step_ms * q->step_ms;
+  if (q->bucket.n && start != q->bucket.t_ms && !TS_Query_Flush(q)) { return false; } // Sample of the next bucket
+  if (q->bucket.n == 0) { q->bucket.t_ms = start; q->bucket.min = q->bucket.max = v; q->sum = 0; }
+  if (v < q->bucket.min) { q->bucket.min = v; }
+  if (v > q->bucket.max) { q->bucket.max = v; }
+  q->sum += v;
+  q->bucket.n++;
+  return true;
+}
+
+/*------------------------------------------------------------
+  TS_Store_Query: block by block, oldest first
+-------------------------------------------------------------*/
+size_t TS_Store_Query(ts_store_handle_t st, size_t series, int64_t from_ms, int64_t to_ms, uint32_t step_ms,
+                      ts_store_point_cb_t cb, void *ctx)
+{ if (st == NULL || series >= st->num_series || cb == NULL || to_ms < from_ms) { return 0; }
+  ts_query_t q = { .from_ms = from_ms, .to_ms = to_ms, .step_ms = step_ms, .cb = cb, .ctx = ctx };
+  union { ts_block_t blk; uint8_t raw[TS_BLOCK_BYTES]; } copy; // ONE block, decoded outside the lock
+  ts_block_t *blk = &copy.blk;
+  xSemaphoreTake(st->mutex, portMAX_DELAY);
+  uint32_t head = st->series[series].head_seq;
+  xSemaphoreGive(st->mutex);
+  uint32_t oldest = (head > st->blocks_per_series) ? head - st->blocks_per_series + 1 : 1;
+  for (uint32_t seq = oldest; seq != 0 && seq <= head; seq++) {
+      xSemaphoreTake(st->mutex, portMAX_DELAY);
+      const ts_block_t *src = TS_Block(st, series, seq);
+      bool take = (src->seq == seq && src->t_last >= from_ms && src->t_first <= to_ms); // Dropped meanwhile / not in range?
+      bool past = (src->seq == seq && src->t_first > to_ms);
+      if (take) { memcpy(copy.raw, src, offsetof(ts_block_t, data) + src->used); }
+      xSemaphoreGive(st->mutex);
+      if (past) { break; }                                     // Blocks are in time order
+      if (!take) { continue; }
+      //..................................................
+      // Decode the block
+      //..................................................
+      int64_t  t = blk->t_first, delta = 0;
+      uint32_t bits = TS_Bits(blk->v_first);
+      bool go_on = TS_Query_Add(&q, t, blk->v_first);
+      size_t p = 0;
+      for (uint16_t k = 1; go_on && k < blk->count && p < blk->used; k++) {
+          uint8_t h = blk->data[p++];
+          int64_t dod = 0;
+          if (!(h & TS_FLAG_SAME_DELTA)) {
+              size_t n = TS_Get_Varint(&blk->data[p], blk->used - p, &dod);
+              if (n == 0) { break; }
+              p += n; }
+          uint32_t x;
+          bool ok;
+          p += TS_Xor_Decode(h, &blk->data[p], blk->used - p, &x, &ok);
+          if (!ok) { break; }                                  // Broken block: skip its rest
+          delta += dod;
+          t     += delta;
+          bits  ^= x;
+          if (t > to_ms) { break; }
+          go_on = TS_Query_Add(&q, t, TS_Float(bits)); }
+      if (!go_on) { return q.emitted; }                        // Stopped by the callback
+  }
+  TS_Query_Flush(&q);                                          // Last bucket
+  return q.emitted;
+}
+
+/*------------------------------------------------------------
+  TS_Store_Get_Info
+-------------------------------------------------------------*/
+esp_err_t TS_Store_Get_Info(ts_store_handle_t st, size_t series, ts_store_info_t *info)
+{ if (st == NULL || info == NULL || (series != TS_STORE_ALL_SERIES && series >= st->num_series)) { return ESP_ERR_INVALID_ARG; }
+  memset(info, 0, sizeof(*info));
+  size_t s_first = (series == TS_STORE_ALL_SERIES) ? 0 : series;
+  size_t s_end   = (series == TS_STORE_ALL_SERIES) ? st->num_series : series + 1;
+  info->bytes_total = (s_end - s_first) * st->blocks_per_series * TS_BLOCK_BYTES;
+  info->in_psram    = st->in_psram;
+  xSemaphoreTake(st->mutex, portMAX_DELAY);
+  for (size_t s = s_first; s < s_end; s++) {
+      uint32_t head = st->series[s].head_seq;
+      info->appended += st->series[s].appended;
+      for (uint32_t seq = (head > st->blocks_per_series) ? head - st->blocks_per_series + 1 : 1; seq != 0 && seq <= head; seq++) {
+          const ts_block_t *blk = TS_Block(st, s, seq);
+          info->samples    += blk->count;
+          info->bytes_used += offsetof(ts_block_t, data) + blk->used;
+          if (info->first_t_ms == 0 || blk->t_first < info->first_t_ms) { info->first_t_ms = blk->t_first; }
+          if (blk->t_last > info->last_t_ms) { info->last_t_ms = blk->t_last; } } }
+  xSemaphoreGive(st->mutex);
+  return ESP_OK;
+}
@@ -0,0 +1,88 @@
+/*===========================================================================================
+ * @brief  Persistent time-series log on flash (e.g. LittleFS): append-only segment files of records
+ *
+ *   * A record = time + a fixed number of float columns (e.g. mean, min & max of some registers).
+ *   * Records are collected in RAM and written as whole pages (TS_LOG_PAGE_BYTES) >> few, aligned writes.
+ *     Each page is compressed on its own (time delta-of-delta, values XOR) and has a CRC.
+ *   * Segment files of 'segment_bytes'; a full segment gets a small index file (time range & offset
+ *     of each page). The oldest segment is deleted when there are more than 'max_segments'.
+ *   * Crash-consistent: at the start a torn or broken page at the end of a segment is cut off,
+ *     missing or broken index files are rebuilt.
+ *   * Thread-safe: queries copy a page at a time and call back outside the lock.
+========================================================================================================*/
+#pragma once
+/*----------
+   INCLUDES
+------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+/*----------
+   CONSTANTS
+------------*/
+#define TS_LOG_PAGE_BYTES   (512)       // Size of ONE page = ONE write
+#define TS_LOG_MAX_COLS     (32)        // Max. columns of a record
+/*------------
+   STRUCTURES
+--------------*/
+typedef struct ts_log_s *ts_log_handle_t;   // Handle of a log
+
+typedef struct {                // Settings of a log
+    const char *dir;            // Directory of the segment files (created if missing)
+    uint16_t num_cols;          // Columns of each record (1 .. TS_LOG_MAX_COLS)
+    uint32_t schema;            // Id of the meaning of the columns: a log of another schema is deleted at the start
+    size_t   segment_bytes;     // Size of ONE segment file (multiple of TS_LOG_PAGE_BYTES)
+    size_t   max_segments;      // Segments kept (>= 2), the oldest is deleted first
+} ts_log_config_t;
+
+typedef struct {                // State of a log
+    size_t   segments;          // Segment files
+    size_t   bytes;             // Bytes in the segment files
+    uint32_t records;           // Records in the segment files & the page in RAM
+    uint32_t pages_written;     // COUNTER of pages written since the start
+    int64_t  first_t_ms;        // Time of the oldest record (0 = none)
+    int64_t  last_t_ms;         // Time of the newest record
+} ts_log_info_t;
+
+/**
+ * @brief   Callback of `TS_Log_Query()` for each record, in time order.
+ *
+ * @return  bool  `true` = go on, `false` = stop the query.
+ */
+typedef bool (*ts_log_record_cb_t)(void *ctx, int64_t t_ms, const float *values, uint16_t num_cols);
+
+/*------------------------
+  Define PUBLIC FUNCTIONS
+------------------------*/
+/**
+ * @brief   Open (and recover) the log in `cfg->dir`, or start a new one.
+ *
+ * @return  esp_err_t  `ESP_OK`, `ESP_ERR_INVALID_ARG`, `ESP_ERR_NO_MEM`, `ESP_FAIL` (directory not usable).
+ */
+esp_err_t TS_Log_Open(const ts_log_config_t *cfg, ts_log_handle_t *handle_out);
+
+/**
+ * @brief   Append ONE record (collected in RAM, a full page is written). Times must not go backwards.
+ *
+ * @param[in]  t_ms     Time of the record, e.g. epoch ms (survives restarts).
+ * @param[in]  values   `num_cols` values.
+ */
+esp_err_t TS_Log_Append(ts_log_handle_t handle, int64_t t_ms, const float *values);
+
+/**
+ * @brief   Write the page collected in RAM now, even if not full (e.g. before a restart).
+ */
+esp_err_t TS_Log_Flush(ts_log_handle_t handle);
+
+/**
+ * @brief   Iterate the records in the time range [from_ms, to_ms], oldest first (incl. the page in RAM).
+ *
+ * @return  size_t  Number of records handed to `cb`.
+ */
+size_t TS_Log_Query(ts_log_handle_t handle, int64_t from_ms, int64_t to_ms, ts_log_record_cb_t cb, void *ctx);
+
+/**
+ * @brief   State of the log.
+ */
+esp_err_t TS_Log_Get_Info(ts_log_handle_t handle, ts_log_info_t *info_out);
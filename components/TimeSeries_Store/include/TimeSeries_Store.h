@@ -0,0 +1,83 @@
+/*===========================================================================================
+ * @brief  Time-series store in RAM: ONE ring of compressed samples per series (e.g. per register)
+ *
+ *   * Fixed memory, taken ONCE at the start: PSRAM if there is some, else internal RAM.
+ *   * Samples are compressed: time as delta-of-delta, value as XOR with the previous value
+ *     (an unchanged value on a regular grid needs 1 byte).
+ *   * When the ring of a series is full, its oldest block of samples is dropped.
+ *   * Thread-safe: one writer per series, any number of readers (queries copy a block at a time).
+========================================================================================================*/
+#pragma once
+/*----------
+   INCLUDES
+------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+/*------------
+   STRUCTURES
+--------------*/
+typedef struct ts_store_s *ts_store_handle_t;   // Handle of a store
+
+typedef struct {                // ONE point of a query: a sample, or a bucket of samples when downsampled
+    int64_t  t_ms;              // Time of the sample / start of the bucket (time base of the caller)
+    float    value;             // Value of the sample / mean of the bucket
+    float    min;               // Smallest value in the bucket (= value for a sample)
+    float    max;               // Largest value in the bucket  (= value for a sample)
+    uint32_t n;                 // Number of samples in the bucket (1 for a sample)
+} ts_point_t;
+
+typedef struct {                // State of a store (or of ONE series)
+    size_t   bytes_total;       // Memory of the blocks
+    size_t   bytes_used;        // ... holding samples
+    uint32_t samples;           // Samples held
+    uint32_t appended;          // Samples appended since the start (held or dropped)
+    int64_t  first_t_ms;        // Time of the oldest sample held (0 = none)
+    int64_t  last_t_ms;         // Time of the newest sample
+    bool     in_psram;          // Store is in PSRAM
+} ts_store_info_t;
+
+/**
+ * @brief   Callback of `TS_Store_Query()` for each point, in time order.
+ *
+ * @return  bool  `true` = go on, `false` = stop the query.
+ */
+typedef bool (*ts_store_point_cb_t)(void *ctx, const ts_point_t *point);
+
+/*------------------------
+  Define PUBLIC FUNCTIONS
+------------------------*/
+/**
+ * @brief   Create a store for `num_series` series (memory see menuconfig: TS_STORE_*).
+ *
+ * @param[out] handle_out  Handle of the store.
+ *
+ * @return  esp_err_t  `ESP_OK`, `ESP_ERR_NO_MEM` (also: less than 2 blocks per series), `ESP_ERR_INVALID_ARG`.
+ */
+esp_err_t TS_Store_Create(size_t num_series, ts_store_handle_t *handle_out);
+
+/**
+ * @brief   Append ONE sample to a series. Times of a series must not go backwards (earlier = taken as the last time).
+ *
+ * @param[in]  t_ms   Time of the sample in ms, any time base (e.g. `esp_timer_get_time() / 1000`).
+ */
+esp_err_t TS_Store_Append(ts_store_handle_t handle, size_t series, int64_t t_ms, float value);
+
+/**
+ * @brief   Iterate the samples of a series in the time range [from_ms, to_ms], optionally downsampled.
+ *
+ * @param[in]  step_ms  0 = every sample; > 0 = ONE point per bucket of step_ms (aligned to from_ms):
+ *                      mean, min, max & number of the samples in the bucket. Empty buckets are left out.
+ * @param[in]  cb       Called for each point (outside the lock of the store: may be slow, e.g. send).
+ *
+ * @return  size_t  Number of points handed to `cb`.
+ */
+size_t TS_Store_Query(ts_store_handle_t handle, size_t series, int64_t from_ms, int64_t to_ms, uint32_t step_ms,
+                      ts_store_point_cb_t cb, void *ctx);
+
+/**
+ * @brief   State of ONE series, or of the whole store with `series` = `TS_STORE_ALL_SERIES`.
+ */
+#define TS_STORE_ALL_SERIES  ((size_t)-1)
+esp_err_t TS_Store_Get_Info(ts_store_handle_t handle, size_t series, ts_store_info_t *info_out);
@@ -21,6 +21,7 @@
    INCLUDES
 -----------*/
 #include "myMQTT.h"                 // For THIS component
+#include "Payload_Writer.h"         // For the JSON payload (no heap, bounds-checked)
 /*------------------
   ESP Logging: TAG 
 ------------------*/
@@ -77,13 +78,18 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
         //........................................................................
         // Build the message to be sent
         char msg_payload[256];
-        strcpy(msg_payload, "{\"Connection\":\"Sucessfull connected to MQTT-Broker.\",\"comment\":\"Status\",\"lastUpdate\":\""); // JSON-Payload
-        strcat(msg_payload, mqtt_start_timestamp_txt);                                                                            // Add the timestamp 
-        strcat(msg_payload, "\"}");                                                                                               // Add the closing bracket
+        pw_writer_t w;
+        PW_Init(&w, msg_payload, sizeof(msg_payload));
+        PW_Json_Object(&w, NULL);                                                           // JSON-Payload
+        PW_Json_Str(&w, "Connection", "Sucessfull connected to MQTT-Broker.");
+        PW_Json_Str(&w, "comment", "Status");
+        PW_Json_Str(&w, "lastUpdate", mqtt_start_timestamp_txt);                             // Add the timestamp 
+        PW_Json_Close(&w);
+        if (!PW_Ok(&w)) { ESP_LOGE(TAG, "--  ❌ Start-Message does not fit"); break; }
         // Publish
         msg_id = esp_mqtt_client_publish(client,
             CONFIG_MQTT_ROOT_TOPIC "/TXT/Status", // Set the topic to publish 
-            msg_payload , 0,                      // use this Payload
+            msg_payload , (int)w.len,             // use this Payload
             CONFIG_MQTT_QOS_DEFAULT,              // QoS level
             CONFIG_MQTT_RETAIN_DEFAULT);          // Retain flag 
         ESP_LOGD(TAG, "--   Publish successful, Start-Message with msg_id=%d", msg_id);
@@ -6,9 +6,12 @@
 /*----------
    INCLUDES
 -----------*/
+#include "sdkconfig.h"
 #include "esp_event.h"
+#if !CONFIG_IDF_TARGET_LINUX    // HOST: network stack of the host (see xlan_connection_linux.c)
 #include "esp_netif.h"          // For TCPI function/conenections
 #include "esp_eth.h"            // For ETHERNET connection
+#endif
 
 extern bool my_lan_Isconnected;     // Flag to check if my lan is connected
 extern char global_ip_info[16];     // Global variable to store IP information
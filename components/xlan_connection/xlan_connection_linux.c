@@ -0,0 +1,33 @@
+/*#################################################################################################################################
+   HOST stand-in of xlan_connection for the ESP-IDF linux target
+   ----------------------------------------------------------------------------------------------------------------------------
+   The host is already on the LAN (its own network stack), so 'connecting' only fills the infos the application shows.
+   Same public functions as 'xlan_connection.c', selected by CMakeLists.txt.
+##################################################################################################################################*/
+#include "xlan_connection.h"
+#include <stdio.h>
+#include <esp_log.h>                      // For ESP-logging
+static const char *TAG = "CON_xLAN";      // Use always 8 chars where possilbe >> TAG used for ESP-logging
+
+bool lan_is_connected = false;            // Flag to check indicate if LAN is connected (INIT: false)
+char global_ip_info[16];                  // Global variable to store IP information
+char url_with_hostname[70];               // Global variable to store URL with hostname
+
+/*================================================================================
+  connect_to_xlan(): Nothing to connect on the host, just fill the infos
+  used by: app_main
+=================================================================================*/
+esp_err_t connect_to_xlan(void) {
+    snprintf(global_ip_info, sizeof(global_ip_info), "127.0.0.1");
+    snprintf(url_with_hostname, sizeof(url_with_hostname), "http://localhost");
+    lan_is_connected = true;
+    ESP_LOGI(TAG, "--  ✅ Host target: Network stack of the host is used (%s)", url_with_hostname);
+    return ESP_OK;
+}
+
+/********************************************************************************
+   GETTERS   GETTERS   GETTERS   GETTERS   GETTERS   GETTERS   GETTERS   GETTERS   
+*********************************************************************************/
+char *get_lan_ip_info(void)        { return global_ip_info; }
+bool is_lan_connected(void)        { return lan_is_connected; }
+bool was_last_ping_successful(void){ return true; }    // No gateway ping on the host
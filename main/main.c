@@ -30,12 +30,22 @@
 *---------------------------------------------------------*/
 #include "freertos/FreeRTOS.h"  // For FreeRTOS functions
 #include "freertos/queue.h"     // For FreeRTOS queue functions
+#include "freertos/semphr.h"    // For FreeRTOS mutex (poll tasks of several buses)
 #include <time.h>               // For time, ctime, localtime, strftime
 #include "esp_timer.h"          // Include for time measurement in microseconds
 #include <math.h>               // For math functions like pow() and round()
+#include <string.h>             // For strsep, strpbrk (register map)
+#include <stdlib.h>             // For qsort, strtol (register map)
+#include <stddef.h>             // For offsetof (energy checkpoint)
+#include <sys/stat.h>           // For stat (storage budget of flash log & spill file)
+#include <dirent.h>             // For opendir (storage budget of flash log & spill file)
+#include <unistd.h>             // For truncate (spill file of store & forward)
+#if !CONFIG_IDF_TARGET_LINUX
 #include "esp_littlefs.h"       // Use LittleFS to store the HTML page
 #include "driver/gpio.h"        // For GPIO functions to set valid stage as early as possible
+#endif
 #include "nvs_flash.h"          // For NVS Flash functions, use to store 'lastBootReason'
+#include "esp_system.h"         // For esp_restart, esp_register_shutdown_handler (energy checkpoint, flash log)
 // (my)Components
 #include "xlan_connection.h"    // For connect_to_xlan() utilize ETHERNET or WIFI connection
 #include "NTPSync_and_localTZ.h"// For NTP-Sync and Set local TZ
@@ -44,6 +54,10 @@
 #include "myMQTT.h"             // For Start MQTT functions
 #include "async_httpd_helper.h" // For Async HTTPD helper functions
 #include "OTA_mDNS.h"           // For OTA and mDNS (based URL) 
+#include "PowerMeter_Energy.h"  // For the trapezoid step of the energy integration
+#include "TimeSeries_Store.h"   // For the history of the values in RAM / PSRAM
+#include "TimeSeries_Log.h"     // For the log of the window statistics on flash
+#include "Payload_Writer.h"     // For the MQTT & HTTP payloads in buffers of the caller (no heap, bounds-checked)
 /*--------------------------------------------------------- 
   ESP Logging: TAG 
 *---------------------------------------------------------*/
@@ -61,6 +75,11 @@ char       firmware_build_ts[40];  // Firmware-Build-TS filled by 'app_main'
   GLOBAL VARIABLES   
 *---------------------------------------------------------*/
 char s_ts[SHRORT_TS_LEN]= "-no error-";  // Short Time-Stamp for commonn use
+#if CONFIG_IDF_TARGET_LINUX
+#define RT_FILES_PATH CONFIG_PRM_LINUX_RT_FILES_DIR // HOST: Runtime files from a directory of the host
+#else
+#define RT_FILES_PATH "/rt_files"                   // Mounting point of LittleFS with the runtime files
+#endif
 /*--------------------------------------------------------- 
    SETTINGS of LAN + NTP-Time
 *---------------------------------------------------------*/
@@ -79,12 +98,23 @@ bool isNVSready = false;                                // Store the status of N
 /*--------------------------------------------------------- 
   MODBUS: defines and variables  
 *---------------------------------------------------------*/
-#define MB_UNIT_ID                            (1)       // Modbus Slave ID under which the SDM630 is reachable = This needs a SETTING at SDM630
-#define MB_READ_INTERVAL_MS                   (2000)    // Interval in ms to read the SDM630
+#define MB_UNIT_ID                            (1)       // Modbus Slave ID under which the SDM630 is reachable = This needs a SETTING at SDM630 (1st meter of powermeter_Devices)
+#define MB_READ_INTERVAL_MS                   (2000)    // Interval in ms to read the SDM630 (while OTA is running)
+#define MB_SCHED_FOLD_AHEAD_MS                (200)     // Registers due within this time are read together with the due ones
+#define MB_SCHED_MIN_SLEEP_MS                 (50)      // Min. idle time between two poll cycles (also after an error)
+#define MB_SCHED_MAX_REGS_PER_CYCLE           (64)      // Max. registers taken per cycle (earliest deadline first)
+#define MB_RETRY_BUDGET_PER_CYCLE             (4)       // Max. single-register retries per cycle after a failed block read
+#define MB_BACKOFF_BASE_MS                    (500)     // Back-off after the 1st failure of a register, doubles with every further failure
+#define MB_BACKOFF_MAX_MS                     (30000)   // Max. back-off of a failing register
+#define MB_BREAKER_THRESHOLD                  (5)       // Consecutive failures of a register that open its circuit breaker
+#define MB_BREAKER_OPEN_MS                    (300000)  // Register is dropped from the plan that long, then tried once again
+#define MB_DEVICE_BACKOFF_MAX_MS              (10000)   // Max. back-off of a meter that does not answer (timeouts), NO breaker
 #define TAG_MB_READ                         "MB_R_REG"  // TAG for logging wehn reading Values from Modbus
 void *handle_to_Modbus_MasterController     = NULL;     // Define a Pointer to Mobus-Controler  Define a variable to hold the Modbus controller handle
 unsigned long readDataSetTime =               350;      // Last duration of read all Registers from Modbus (INIT with dummy, in ms)
-TaskHandle_t modbus_poll_task_handle        = NULL;     // Handle for the Modbus poll task        
+unsigned long readDataSetRegs =               20;       // Number of registers read in that duration (INIT with dummy)
+TaskHandle_t modbus_poll_task_handle[MB_NUM_BUSES] = { NULL }; // Handle for the Modbus poll task (one per bus)
+SemaphoreHandle_t powermeter_CycleMutex     = NULL;     // Protects the cycle results shared by the poll tasks of all buses
 /*--------------------------------------------------------- 
   MQTT: defines and variables  
 *---------------------------------------------------------*/
@@ -95,6 +125,9 @@ TaskHandle_t modbus_poll_task_handle        = NULL;     // Handle for the Modbus
 #define MQTT_ESP_SUB_TOPIC                    "ESP"     // Sub-Topic for ESP-Informations
 #define MQTT_PRM_SUB_TOPIC                    "PRM"     // Sub-Topic for PowerMeter-Common-Informations
 #define MQTT_OTM_SUB_TOPIC                    "OTM"     // Sub-Topic for ESP One-Time-Messages (e.g. Last-Boot-Time)
+#define MQTT_ERROR_SUB_TOPIC                  "ERR"     // Sub-Topic for read errors per register
+#define MQTT_STATS_SUB_TOPIC                  "STAT"    // Sub-Topic for window statistics per register
+#define MQTT_ENERGY_SUB_TOPIC                 "NRG"     // Sub-Topic for the energy integrated on the ESP
 esp_mqtt_client_handle_t handle_to_MQTT_client = NULL;  // Init: Handle to MQTT client
 #define TAG_MB_PUBL                         "MQ_P_REG"  // TAG for logging when publishing Modbus-Values to MQTT
 #define TAG_ESP_PUBL                        "MQ_P_ESP"  // TAG for logging when publishing ESP-Values to MQTT
@@ -105,6 +138,8 @@ volatile uint32_t powermeter_published_error = 0;       // COUNTER of publish er
 char powermeter_PublishSuccess_TS[SHRORT_TS_LEN]="-no publish-";// Time-Stamp last successful publishing to MQTT
 char powermeter_PublishError_TS[SHRORT_TS_LEN]= "-no error-";   // Time-Stamp lasst error publishing to MQTT
 TaskHandle_t mqtt_publish_task_handle_PRM   = NULL;     // Handle for the MQTT publish task
+#define PRM_PUBLISH_STACK_BYTES               (6144)    // Stack of the publish task: ALSO writes flash log & spill file (LittleFS, fsync)
+#define PRM_PUBLISH_STACK_WARN_BYTES          (768)     // Less stack never used >> warning (raise PRM_PUBLISH_STACK_BYTES)
 /*--------------------------------------------------------- 
   CONFIGURATION <SDM> electrical measurements (modbus)  
 *---------------------------------------------------------*/
@@ -148,34 +183,6 @@ char powermeter_ErrorRead_TS[SHRORT_TS_LEN] = "-no error-";     // Time-Stamp fi
    HELPERS   HELPERS   HELPERS   HELPERS   HELPERS   HELPERS   HELPERS   HELPERS   HELPERS   HELPERS   HELPERS   HELPERS   HELPERS
 ##################################################################################################################################*/
 
-/** ------------------------------------------------------------------------------------------------
- * @brief  HELPER function to append to a string
- * 
- * This function appends a formatted string to a dynamically allocated string.
- * It uses `vasprintf` to format the string and `realloc` to resize the destination string.
- * 
- * @param[out] dest   Pointer to the destination string where the formatted string will be appended.
- * @param[in]  format Format string for the new piece to append.
- * 
- * @note  
- *    used by `Interface_ModbusValues_to_WebServer_SDMValues`
- *-------------------------------------------------------------------------------------------------*/
-static void Helper_AppendTo_String(char **dest, const char *format, ...) {
-    va_list args;             // Declare Variable of type va_list, used to hold the arguments passed to the function.  <stdarg.h>
-    va_start(args, format);   // Initialize the va_list variable with the format string
-    char *new_piece;          // Declares a pointer to a char that should be added newly 
-    int len = vasprintf(&new_piece, format, args); // allocate new formatted string
-    va_end(args);             // Clean up the va_list variable after it has been used.  Ensures resources released.
-    if (len == -1) { ESP_LOGE(TAG, "vasprintf failed"); return; } // check for allocation error
-    if (*dest == NULL) { *dest = new_piece;   // If NULL it is the fist piece
-    } else { 
-        size_t old_len = strlen(*dest);       // Get length of the existing string
-        *dest = realloc(*dest, old_len + len + 1); // Reallocate memory for the new string (make bigger)
-        strcat(*dest, new_piece);             // append the new piece to the existing string to *dest
-        free(new_piece);                      // Free the memory allocated for new_piece
-    }
-}
-
 /** ------------------------------------------------------------------------------------------------
  * @brief  HELPER to get runtime of the ESP32 as formatted string
  * 
@@ -340,6 +347,82 @@ char* Helper_read_from_nvs_with_key(const char* key_str) {
     return read_str; // Return the string or NULL
 }
 
+/*#################################################################################################################################
+   TIMING   TIMING   TIMING   TIMING   TIMING   TIMING   TIMING   TIMING   TIMING   TIMING   TIMING   TIMING   TIMING   TIMING
+##################################################################################################################################*/
+/*---------------------------------------------------------------------------------------------------------
+  Cadence statistics of a periodic activity (poll & publish)
+  ---------------------------------------------------------------------------------------------------------
+  * jitter   = |actual start - planned deadline| in a histogram
+  * overrun  = a cycle (or register) started a whole period or more too late
+  * skipped  = periods left out because of overruns (the grid is kept, no catch-up bursts)
+----------------------------------------------------------------------------------------------------------*/
+#define JITTER_NUM_BUCKETS                    (10)      // Number of buckets of the jitter histogram
+static const uint32_t jitter_bucket_ms[JITTER_NUM_BUCKETS-1] = {1, 2, 5, 10, 20, 50, 100, 200, 500}; // Upper limits, last bucket = above
+typedef struct {
+  uint32_t  cycles;                             // COUNTER of planned starts
+  uint32_t  overruns;                           // COUNTER of starts later than one period
+  uint32_t  skipped;                            // COUNTER of skipped periods
+  uint32_t  maxJitterUs;                        // Max. jitter seen in µs
+  uint32_t  hist[JITTER_NUM_BUCKETS];           // Jitter histogram, see jitter_bucket_ms
+} cadence_stats_t;
+
+cadence_stats_t powermeter_PollCadence[MB_NUM_BUSES];   // Jitter of the reads against the deadlines of the registers (per bus)
+cadence_stats_t powermeter_PublCadence;                 // Jitter of the MQTT publish cycles
+
+/*--------------------------------
+  Cadence_Record: Add one start with its deviation from the deadline (µs, +late / -early)
+----------------------------------*/ 
+static void Cadence_Record(cadence_stats_t *st, int64_t jitter_us) {
+  uint32_t abs_us = (uint32_t)((jitter_us < 0) ? -jitter_us : jitter_us);
+  int b = 0;
+  while (b < JITTER_NUM_BUCKETS-1 && abs_us >= jitter_bucket_ms[b] * 1000) { b++; }
+  st->hist[b]++;
+  st->cycles++;
+  if (abs_us > st->maxJitterUs) { st->maxJitterUs = abs_us; }
+}
+
+/*--------------------------------
+  Cadence_Wait_Next: Sleep until the next deadline of a fixed grid (drift-free)
+  * An overrun skips the missed periods, the phase stays the same.
+  * Rounds UP to whole ticks: never wakes up before the deadline.
+----------------------------------*/ 
+static void Cadence_Wait_Next(cadence_stats_t *st, int64_t *next_us, int64_t period_us) {
+  int64_t now_us = esp_timer_get_time();
+  *next_us += period_us;                        // Next point of the grid
+  if (*next_us <= now_us) {                     // OVERRUN: that point has passed already
+      uint32_t missed = (uint32_t)((now_us - *next_us) / period_us) + 1;
+      st->overruns++;
+      st->skipped += missed;
+      *next_us += (int64_t)missed * period_us; }
+  int64_t tick_us = (int64_t)portTICK_PERIOD_MS * 1000;
+  vTaskDelay((TickType_t)((*next_us - now_us + tick_us - 1) / tick_us));
+  Cadence_Record(st, esp_timer_get_time() - *next_us);
+}
+
+/*--------------------------------
+  Cadence_Add: Sum up statistics (e.g. of several buses)
+----------------------------------*/ 
+static void Cadence_Add(cadence_stats_t *sum, const cadence_stats_t *add) {
+  sum->cycles   += add->cycles;
+  sum->overruns += add->overruns;
+  sum->skipped  += add->skipped;
+  if (add->maxJitterUs > sum->maxJitterUs) { sum->maxJitterUs = add->maxJitterUs; }
+  for (int b = 0; b < JITTER_NUM_BUCKETS; b++) { sum->hist[b] += add->hist[b]; }
+}
+
+/*--------------------------------
+  Cadence_Format_Hist: Histogram as text "<1ms:12 <2ms:3 ... >500ms:0"
+----------------------------------*/ 
+static void Cadence_Format_Hist(const cadence_stats_t *st, char *buf, size_t len) {
+  size_t pos = 0;
+  buf[0] = '\0';
+  for (int b = 0; b < JITTER_NUM_BUCKETS && pos < len; b++) {
+      if (b < JITTER_NUM_BUCKETS-1) { pos += snprintf(buf + pos, len - pos, "%s<%lums:%lu", b ? " " : "", (unsigned long)jitter_bucket_ms[b], (unsigned long)st->hist[b]); }
+      else                          { pos += snprintf(buf + pos, len - pos, " >%lums:%lu", (unsigned long)jitter_bucket_ms[b-1], (unsigned long)st->hist[b]); }
+  }
+}
+
 /*#################################################################################################################################
  MODBUS   POWERMETER   MODBUS   POWERMETER   MODBUS   POWERMETER   MODBUS   POWERMETER   MODBUS   POWERMETER   MODBUS   POWERMETER
 ##################################################################################################################################*/
@@ -357,64 +440,385 @@ typedef struct {
   int            digits;        // Digits for conversion to char* used by WebServer to Display Data
                                 // AND to determine if value have changes (significanlty enough) see updateMQTT
   bool           hasPrio;       // Prio flag is used to send this value more often
-  const uint16_t registerHex;   // Register-No as HEX
+  uint32_t       refreshMs;     // Target refresh period in ms >> Register is read again when due (deadline scheduler)
+  uint16_t       registerHex;   // Register-No as HEX
   bool           updateMQTT;    // Flag indicates it value have changes (significanlty enough) to be re-published to MQTT     
+  uint32_t       changeSeq;     // Counts the changes that set 'updateMQTT' >> publisher clears only the change it has published
+  int64_t        nextDue_us;    // Deadline (esp_timer in µs) when the register is due to be read again (INIT 0 = due at once)
+  uint32_t       errCount;      // COUNTER of failed reads of this register (never resets)
+  uint8_t        failStreak;    // Consecutive failed reads >> back-off & circuit breaker (0 = healthy)
+  bool           updateErrMQTT; // Flag indicates the error count / breaker state has to be re-published to MQTT
+  int64_t        sample_us;     // Acquisition time (esp_timer in µs) of 'currVal' = answer of the meter received (0 = never read)
+  const char     *topicFull;    // Pre-joined MQTT topic  'Power-Meter/MEA/Power-Total'            (generated, NULL = join at runtime)
+  const char     *payloadMid;   // Constant JSON fragment ',"unit":"W","comment":"Power-Total","lastUpdate":"' (generated, NULL = join at runtime)
 } powermeter_struct;
 
-volatile powermeter_struct powermeter_RegArray[] = {
 /*------------------------------------------------------------------------------------------------------------------------
    ARRAY with selected SDM Registers that should be requested frequently
 ---------------------------------------------------------------------------------------------------------------------------
- !!  IMPORTANT  !!  IMPORTANT  !!  IMPORTANT  !!  IMPORTANT  !!  IMPORTANT  !!  IMPORTANT  !!  IMPORTANT  !!  IMPORTANT
- !!  cid-Numbers NEED to start with 0!!! and increased by one for every further entry!
+ GENERATED at build time: 'components/POWERMETER/register_spec.csv' is the ONE place to select the registers.
+   * The table of the meter model set with menuconfig (PRM_METER_MODEL) is taken, it holds only registers the model has.
+   * Topic & JSON fragment of each register are pre-joined >> no string assembly per message.
+ !!  IMPORTANT  !!  cid-Numbers start with 0 and increase by one for every further entry (the generator numbers them)!
  Why? 
    * Otherwise belows 'powermeter_param_descriptors' will NOT be accepted by 'mbc_master_set_descriptor'
                        >> Error: Message: "Invalid CID"
    * The cid-Numbers seem to be used as Array-index with while identify the register in the Modbus-Controller structure.
+------------------------------------------------------------------------------------------------------------------------*/
+#define PRM_TOPIC_PREFIX CONFIG_MQTT_ROOT_TOPIC "/" MQTT_MEASUREMENT_SUB_TOPIC "/" // Topics of the generated table: 'Power-Meter/MEA/'
+#include "prm_register_tables.h"                         // GENERATED: PRM_GEN_REGISTERS of the selected meter model
+#define PRM_REG_ENTRY(idx, name, unit, min, max, dig, prio, refresh, reg, topic, mid) \
+  { .cid = idx, .topicName = name, .unitOfValue = unit, .currVal = NAN, .minVal = min, .maxVal = max, .digits = dig, \
+    .hasPrio = prio, .refreshMs = refresh, .registerHex = reg, .topicFull = topic, .payloadMid = mid },
+volatile powermeter_struct powermeter_RegArray[] = { PRM_GEN_REGISTERS(PRM_REG_ENTRY) };  // currVal NAN = NOT read yet
+#define MBREG (sizeof(powermeter_RegArray)/sizeof(powermeter_RegArray[0])) // Number of Selected SDM registers to read +1!!. READ-TIME per Register= ~22ms (single reads, see block reads)
+
+/*--------------------------------
+  Structure for each Powermeter 
+  used by: powermeter_Devices
+----------------------------------*/ 
+typedef struct {
+  uint8_t        bus;           // RS485-bus (0 .. CONFIG_MY_MB_NUM_BUSES-1) the meter is connected to
+  uint8_t        slaveId;       // Modbus Slave ID under which the meter is reachable = This needs a SETTING at the meter
+  const char     *model;        // Name/Model of the meter, shown by WebServer & MQTT
+  volatile powermeter_struct *regs; // Register set of the meter (holds the values!)
+  size_t         numRegs;       // Number of registers in 'regs'
+  const char     *subTopic;     // MQTT sub-topic of the meter, below 'MEA' ("" = no extra level)
+  uint16_t       firstCid;      // CID of regs[0]                           (set by Modbus_Build_ParaDescriptors_PowerMeter)
+  uint32_t       readsOk;       // COUNTER of cycles all due registers of the meter were read
+  uint32_t       readsErr;      // COUNTER of cycles with read errors at the meter
+  unsigned long  busTimeMs;     // Bus time used for the meter in its last cycle in ms
+  esp_err_t      lastErr;       // Last error reading the meter
+  uint8_t        failStreak;    // Consecutive times the meter did NOT answer (timeout, bus noise) >> back-off of the METER
+  int64_t        backoffUntil_us; // Meter is NOT polled before this time (0 = healthy)
+} powermeter_device_t;
+
+powermeter_device_t powermeter_Devices[] = {
+/*------------------------------------------------------------------------------------------------------------------------
+   TABLE of all Powermeters sharing the ONE RS485-bus
+---------------------------------------------------------------------------------------------------------------------------
+ * Every meter needs its own Slave ID and its OWN register set (like powermeter_RegArray above).
+   Meters of the same model can use a copy of the same array, but NOT the same array (it holds the values):
+     volatile powermeter_struct powermeter_RegArray_2[] = { PRM_GEN_REGISTERS(PRM_REG_ENTRY) };
+   The pre-joined topics of the generated table are used for meters WITHOUT subTopic only.
+ * Every bus has its own poll task, the block reads of the meters on one bus are interleaved.
+   Meters on different buses are read in parallel (more buses see menuconfig: CONFIG_MY_MB_NUM_BUSES).
 ------------------------------------------------------------------------------------------------------------------------  
-  cid, topicName,    Unit,  currVal,  min-,maxVal,digits, hasPrio, registerHex, updateMQTT                            */ 
-  {0, "Power-Total",  "W",   999.0,   0,72000,    0,       true,   SDM_TOTAL_SYSTEM_POWER, false},          // 0
-  {1, "Frequency",    "HZ",  99.99,   0,60,       2,       true,   SDM_FREQUENCY, false},                   // 1
-  {2, "ReactiveP",    "W",   999.0,   0,72000,    0,       false,  SDM_TOTAL_SYSTEM_REACTIVE_POWER, false}, // 2
-  {3, "ApparentP",    "W",   999.0,   0,72000,    0,       false,  SDM_TOTAL_SYSTEM_APPARENT_POWER, false}, // 3
-  {4, "Neutral-Curr", "A",   99.99,   0,100,      2,       false,  SDM_NEUTRAL_CURRENT, false},             // 4
-  {5, "L1-3-Curr",    "A",   99.99,   0,100,      2,       false,  SDM_SUM_LINE_CURRENT, false},            // 5
-  {6, "PFactor",      "PF",  9.99,    0,10,       2,       false,  SDM_TOTAL_SYSTEM_POWER_FACTOR, false},   // 6
-  {7, "Energy-Sum",   "kWh", 99999.0, 0,99999,    2,       false,  SDM_IMPORT_ACTIVE_ENERGY, false},        // 7
-
-  {8, "Power-L1",     "W",   999.0,   0,72000,    0,       false,  SDM_PHASE_1_POWER, false},               // 8
-  {9, "Power-L2",     "W",   999.0,   0,72000,    0,       false,  SDM_PHASE_2_POWER, false},               // 9
-  {10,"Power-L3",     "W",   999.0,   0,72000,    0,       false,  SDM_PHASE_3_POWER, false},               // 10
-  {11,"ReactiveP-L1", "W",   999.0,   0,72000,    0,       false,  SDM_PHASE_1_REACTIVE_POWER, false},      // 11
-  {12,"ReactiveP-L2", "W",   999.0,   0,72000,    0,       false,  SDM_PHASE_2_REACTIVE_POWER, false},      // 12
-  {13,"ReactiveP-L3", "W",   999.0,   0,72000,    0,       false,  SDM_PHASE_3_REACTIVE_POWER, false},      // 13
-
-  {14,"Voltage-L1",   "V",   999.0,   0,300,      1,       true,   SDM_PHASE_1_VOLTAGE, false},             // 14
-  {15,"Voltage-L2",   "V",   999.0,   0,300,      1,       false,  SDM_PHASE_2_VOLTAGE, false},             // 15
-  {16,"Voltage-L3",   "V",   999.0,   0,300,      1,       false,  SDM_PHASE_3_VOLTAGE, false},             // 16
-  {17,"Current-L1",   "A",   99.99,   0,100,      2,       false,  SDM_PHASE_1_CURRENT, false},             // 17
-  {18,"Current-L2",   "A",   99.99,   0,100,      2,       false,  SDM_PHASE_2_CURRENT, false},             // 18
-  {19,"Current-L3",   "A",   99.99,   0,100,      2,       false,  SDM_PHASE_3_CURRENT, false}              // 19
+  bus, slaveId,    model,    regs,                numRegs, subTopic                                                   */
+  {0,  MB_UNIT_ID, PRM_Name, powermeter_RegArray, MBREG,   ""},
+/*{1,  2, "Eastron SDM72D-M", powermeter_RegArray_2, sizeof(powermeter_RegArray_2)/sizeof(powermeter_RegArray_2[0]), "Meter-2"}, */
 };
-#define MBREG (sizeof(powermeter_RegArray)/sizeof(powermeter_RegArray[0])) // Number of Selected SDM registers to read +1!!. READ-TIME per Register= ~22ms
+#define PRM_NUM_DEVICES (sizeof(powermeter_Devices)/sizeof(powermeter_Devices[0])) // Number of meters on the bus
+#define MB_MAX_CIDS                           (64)      // Max. number of registers of ALL meters together
+volatile powermeter_struct *powermeter_Regs[MB_MAX_CIDS]; // CID >> Register of its meter
+uint8_t powermeter_RegDevice[MB_MAX_CIDS];                // CID >> Index of its meter in powermeter_Devices
+size_t  powermeter_NumCids = 0;                           // Number of registers of ALL meters (=CIDs)
+
+#if CONFIG_PRM_REGISTER_MAP_FILE
+/*---------------------------------------------------------------------------------------------------------
+  REGISTER MAP at runtime: 'register_map.csv' of the runtime files replaces the compiled register sets
+  ---------------------------------------------------------------------------------------------------------
+  * ONE line per register:  meter, topicName, unit, minVal, maxVal, digits, hasPrio, refreshMs, registerHex
+    (same columns as 'PowerMeter-Eastron-SDM-RelevantMeasuments.xlsx' & powermeter_RegArray above)
+  * The CSV is parsed ONCE into a compact binary table, sorted by meter & register = order of the block reads.
+    The table is cached in 'register_map.bin' with the CRC of the CSV >> next boots skip the parsing.
+  * Rows with a register the meter model (menuconfig: PRM_METER_MODEL) does not have are dropped (warning).
+  * A meter without lines in the CSV keeps its compiled register set.
+    Missing or invalid CSV >> ALL meters keep their compiled register sets.
+  used by: app_main (before Modbus_Build_ParaDescriptors_PowerMeter)
+----------------------------------------------------------------------------------------------------------*/
+#define REGMAP_CSV_FILE       RT_FILES_PATH "/register_map.csv"
+#define REGMAP_BIN_FILE       RT_FILES_PATH "/register_map.bin"
+#define REGMAP_MAGIC          (0x50524D52)  // 'PRMR'
+#define REGMAP_VERSION        (1)           // Increase when regmap_desc_t changes
+#define REGMAP_POOL_SIZE      (1024)        // Bytes for the names & units of ALL registers
+#define REGMAP_CSV_MAX_SIZE   (16 * 1024)   // Larger CSV files are refused
+#define REGMAP_CSV_FIELDS     (9)           // Columns per register line
+#define REGMAP_NAME_MAX       (31)          // Max. length of a topic name
+#define REGMAP_UNIT_MAX       (7)           // Max. length of a unit
+#define REGMAP_MIN_REFRESH_MS (100)         // Shortest refresh period accepted
+#define REGMAP_NO_STRING      (0xFFFF)      // Pool offset: string did not fit
+
+typedef struct {              // ONE register in binary form (no pointers >> can be cached as it is)
+  uint16_t registerHex;       // Register-No
+  uint8_t  meter;             // Index in powermeter_Devices
+  uint8_t  digits;            // Digits of the value
+  uint8_t  hasPrio;           // 1 = Prio value
+  uint8_t  reserved;
+  uint16_t nameOfs;           // Offset of the topic name in the string pool
+  uint16_t unitOfs;           // Offset of the unit in the string pool
+  int32_t  minVal;
+  int32_t  maxVal;
+  uint32_t refreshMs;
+} regmap_desc_t;
+
+typedef struct {              // Header of 'register_map.bin', followed by the descriptors & the string pool
+  uint32_t magic;             // REGMAP_MAGIC
+  uint16_t version;           // REGMAP_VERSION
+  uint16_t descSize;          // sizeof(regmap_desc_t) >> layout check
+  uint32_t srcCrc;            // CRC32 of the CSV the cache was built from
+  uint32_t srcLen;            // Length of that CSV
+  uint16_t numRegs;           // Number of descriptors
+  uint16_t poolLen;           // Bytes used in the string pool
+  uint32_t binCrc;            // CRC32 of descriptors & string pool
+} regmap_bin_header_t;
+
+volatile powermeter_struct powermeter_RegArrayRT[MB_MAX_CIDS]; // Register sets of the meters from the register map (hold the values!)
+static char powermeter_RegMapPool[REGMAP_POOL_SIZE];           // Names & units of powermeter_RegArrayRT
+const char *powermeter_RegMapSource = "compiled";              // Where the register sets come from: "compiled", "csv" or "cache"
+
+/*--------------------------------------------------------------------------------------------------
+  CRC32 (IEEE, reflected), bitwise: runs once per boot over a few kByte
+----------------------------------------------------------------------------------------------------*/
+static uint32_t RegMap_CRC32(uint32_t crc, const void *data, size_t len)
+{ const uint8_t *p = (const uint8_t *)data;
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++) {
+      crc ^= p[i];
+      for (int b = 0; b < 8; b++) { crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1; } }
+  return ~crc;
+}
+
+/*--------------------------------------------------------------------------------------------------
+  String pool: Add a string once (units repeat a lot), answer its offset
+----------------------------------------------------------------------------------------------------*/
+static uint16_t RegMap_Pool_Add(char *pool, uint16_t *pool_len, const char *s)
+{ for (uint16_t o = 0; o < *pool_len; o += strlen(pool + o) + 1) {
+      if (strcmp(pool + o, s) == 0) { return o; } }
+  size_t n = strlen(s) + 1;
+  if (*pool_len + n > REGMAP_POOL_SIZE) { return REGMAP_NO_STRING; }
+  memcpy(pool + *pool_len, s, n);
+  uint16_t o = *pool_len;
+  *pool_len += n;
+  return o;
+}
+
+static char *RegMap_Trim(char *s)
+{ if (s == NULL) { return ""; }
+  while (*s == ' ' || *s == '\t') { s++; }
+  char *e = s + strlen(s);
+  while (e > s && (e[-1] == ' ' || e[-1] == '\t' || e[-1] == '\r')) { *--e = '\0'; }
+  return s;
+}
+
+static int RegMap_Compare(const void *a, const void *b)
+{ const regmap_desc_t *x = a, *y = b;
+  if (x->meter != y->meter) { return x->meter - y->meter; }
+  return x->registerHex - y->registerHex;
+}
+
+/*--------------------------------------------------------------------------------------------------
+  RegMap_Model_Has: Does the meter model (menuconfig: PRM_METER_MODEL) have this register?
+  PRM_GEN_MODEL_REGS = ALL registers of the model, sorted (generated from EASTRON_SDM.h)
+----------------------------------------------------------------------------------------------------*/
+static const uint16_t powermeter_ModelRegs[] = PRM_GEN_MODEL_REGS;
+
+static int RegMap_Compare_Reg(const void *a, const void *b)
+{ return *(const uint16_t *)a - *(const uint16_t *)b; }
+
+static bool RegMap_Model_Has(uint16_t reg)
+{ return bsearch(&reg, powermeter_ModelRegs, sizeof(powermeter_ModelRegs) / sizeof(powermeter_ModelRegs[0]),
+                 sizeof(powermeter_ModelRegs[0]), RegMap_Compare_Reg) != NULL;
+}
+
+/*--------------------------------------------------------------------------------------------------
+  RegMap_Parse_CSV: CSV >> binary table, sorted by meter & register
+  Answer: Number of registers, -1 on error (logged with its line)
+----------------------------------------------------------------------------------------------------*/
+static int RegMap_Parse_CSV(char *csv, regmap_desc_t *desc, char *pool, uint16_t *pool_len)
+{ int n = 0, line_no = 0;
+  char *next = NULL;
+  *pool_len = 0;
+  for (char *line = csv; line != NULL; line = next) {
+      next = strchr(line, '\n');
+      if (next) { *next++ = '\0'; }
+      line_no++;
+      line = RegMap_Trim(line);
+      if (line[0] < '0' || line[0] > '9') { continue; }  // Empty, comment '#' or header line
+      //-------------------------------------------------
+      // Split & check the columns
+      //-------------------------------------------------
+      char *f[REGMAP_CSV_FIELDS];
+      int nf = 0;
+      for (char *p = line; p != NULL && nf < REGMAP_CSV_FIELDS; nf++) { f[nf] = RegMap_Trim(strsep(&p, ",")); } // Further columns are ignored
+      const char *why = NULL;
+      char *end;
+      long     meter   = strtol(f[0], &end, 10);
+      if      (nf < REGMAP_CSV_FIELDS)                                   { why = "too few columns"; }
+      else if (*end || meter < 0 || meter >= PRM_NUM_DEVICES)            { why = "meter is not in powermeter_Devices"; }
+      else if (f[1][0] == '\0' || strlen(f[1]) > REGMAP_NAME_MAX || strpbrk(f[1], " /+#<>&\"")) { why = "invalid topic name"; }
+      else if (f[2][0] == '\0' || strlen(f[2]) > REGMAP_UNIT_MAX || strpbrk(f[2], "<>&\""))      { why = "invalid unit"; }
+      else if (n >= MB_MAX_CIDS)                                         { why = "more registers than MB_MAX_CIDS"; }
+      if (why == NULL) {
+          regmap_desc_t *d = &desc[n];
+          unsigned long reg = strtoul(f[8], &end, 0);                    // '0x0034' or '52'
+          long digits       = strtol(f[5], NULL, 10);
+          long refresh      = strtol(f[7], NULL, 10);
+          if      (*end || f[8][0] == '\0' || reg > 0xFFFE)              { why = "invalid register"; }
+          else if (digits < 0 || digits > 6)                             { why = "digits must be 0..6"; }
+          else if (refresh < REGMAP_MIN_REFRESH_MS)                      { why = "refreshMs too short"; }
+          else if (!RegMap_Model_Has(reg)) {                             // Would only answer with exceptions
+              ESP_LOGW(TAG, "--     ⚠️ %s line %d: register 0x%04lX is not available at the %s >> dropped", REGMAP_CSV_FILE, line_no, reg, PRM_GEN_MODEL);
+              continue; }
+          else {
+              d->registerHex = reg;
+              d->meter       = meter;
+              d->digits      = digits;
+              d->hasPrio     = (strchr("1yYtT", f[6][0]) != NULL && f[6][0] != '\0');  // 1, y(es), t(rue)
+              d->reserved    = 0;
+              d->minVal      = strtol(f[3], NULL, 10);
+              d->maxVal      = strtol(f[4], NULL, 10);
+              d->refreshMs   = refresh;
+              d->nameOfs     = RegMap_Pool_Add(pool, pool_len, f[1]);
+              d->unitOfs     = RegMap_Pool_Add(pool, pool_len, f[2]);
+              if (d->nameOfs == REGMAP_NO_STRING || d->unitOfs == REGMAP_NO_STRING) { why = "names exceed REGMAP_POOL_SIZE"; }
+          }
+      }
+      if (why) { ESP_LOGE(TAG, "!!     ❌ %s line %d: %s", REGMAP_CSV_FILE, line_no, why); return -1; }
+      n++;
+  }
+  //-------------------------------------------------
+  // Sort by meter & register = order of the block reads
+  //-------------------------------------------------
+  qsort(desc, n, sizeof(regmap_desc_t), RegMap_Compare);
+  for (int i = 1; i < n; i++) {
+      if (RegMap_Compare(&desc[i-1], &desc[i]) == 0) {
+          ESP_LOGE(TAG, "!!     ❌ %s: register 0x%04X of meter %d twice", REGMAP_CSV_FILE, desc[i].registerHex, desc[i].meter); return -1; } }
+  return n;
+}
+
+/*--------------------------------------------------------------------------------------------------
+  RegMap_Load_Cache: Take the binary table of 'register_map.bin' if it was built from THIS CSV
+  Answer: Number of registers, -1 = no valid cache
+----------------------------------------------------------------------------------------------------*/
+static int RegMap_Load_Cache(uint32_t src_crc, uint32_t src_len, regmap_desc_t *desc, char *pool, uint16_t *pool_len)
+{ FILE *f = fopen(REGMAP_BIN_FILE, "rb");
+  if (f == NULL) { return -1; }
+  regmap_bin_header_t h;
+  int n = -1;
+  if (fread(&h, sizeof(h), 1, f) == 1 && h.magic == REGMAP_MAGIC && h.version == REGMAP_VERSION &&
+      h.descSize == sizeof(regmap_desc_t) && h.srcCrc == src_crc && h.srcLen == src_len &&
+      h.numRegs <= MB_MAX_CIDS && h.poolLen > 0 && h.poolLen <= REGMAP_POOL_SIZE &&
+      fread(desc, sizeof(regmap_desc_t), h.numRegs, f) == h.numRegs && fread(pool, 1, h.poolLen, f) == h.poolLen &&
+      RegMap_CRC32(RegMap_CRC32(0, desc, h.numRegs * sizeof(regmap_desc_t)), pool, h.poolLen) == h.binCrc &&
+      pool[h.poolLen - 1] == '\0') {
+      n = h.numRegs;
+      *pool_len = h.poolLen;
+      for (int i = 0; i < n; i++) {   // Meters or model may have changed since (new firmware, same CSV)
+          if (desc[i].meter >= PRM_NUM_DEVICES || desc[i].nameOfs >= h.poolLen || desc[i].unitOfs >= h.poolLen ||
+              !RegMap_Model_Has(desc[i].registerHex)) { n = -1; break; } }
+  }
+  fclose(f);
+  return n;
+}
+
+/*--------------------------------------------------------------------------------------------------
+  RegMap_Save_Cache: Write 'register_map.bin' (via a temp. file: a power loss never leaves half of it)
+----------------------------------------------------------------------------------------------------*/
+static void RegMap_Save_Cache(uint32_t src_crc, uint32_t src_len, const regmap_desc_t *desc, int n, const char *pool, uint16_t pool_len)
+{ regmap_bin_header_t h = { .magic = REGMAP_MAGIC, .version = REGMAP_VERSION, .descSize = sizeof(regmap_desc_t),
+                            .srcCrc = src_crc, .srcLen = src_len, .numRegs = n, .poolLen = pool_len,
+                            .binCrc = RegMap_CRC32(RegMap_CRC32(0, desc, n * sizeof(regmap_desc_t)), pool, pool_len) };
+  FILE *f = fopen(REGMAP_BIN_FILE ".tmp", "wb");
+  if (f == NULL) { ESP_LOGW(TAG, "--     ⚠️ Can't write the cache '%s', the CSV is parsed again next boot", REGMAP_BIN_FILE); return; }
+  bool ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+            fwrite(desc, sizeof(regmap_desc_t), n, f) == (size_t)n &&
+            fwrite(pool, 1, pool_len, f) == pool_len;
+  ok = (fclose(f) == 0) && ok;
+  remove(REGMAP_BIN_FILE);
+  if (ok && rename(REGMAP_BIN_FILE ".tmp", REGMAP_BIN_FILE) == 0) {
+      ESP_LOGI(TAG, "--     ✅ Cached as '%s' (%d bytes)", REGMAP_BIN_FILE, (int)(sizeof(h) + n * sizeof(regmap_desc_t) + pool_len));
+  } else {
+      remove(REGMAP_BIN_FILE ".tmp");
+      ESP_LOGW(TAG, "--     ⚠️ Can't write the cache '%s', the CSV is parsed again next boot", REGMAP_BIN_FILE); }
+}
+
+/*--------------------------------------------------------------------------------------------------
+  PowerMeter_Load_RegisterMap: Replace the compiled register sets of the meters by the register map
+----------------------------------------------------------------------------------------------------*/
+void PowerMeter_Load_RegisterMap(void)
+{ //-------------------------------------------------
+  // 1. Read the CSV
+  //-------------------------------------------------
+  FILE *f = fopen(REGMAP_CSV_FILE, "r");
+  if (f == NULL) { ESP_LOGI(TAG, "--     No '%s' >> compiled register sets are used", REGMAP_CSV_FILE); return; }
+  char *csv = malloc(REGMAP_CSV_MAX_SIZE + 1);
+  regmap_desc_t *desc = malloc(MB_MAX_CIDS * sizeof(regmap_desc_t));
+  if (csv == NULL || desc == NULL) { fclose(f); free(csv); free(desc); ESP_LOGE(TAG, "!!     ❌ No memory to load the register map"); return; }
+  size_t len = fread(csv, 1, REGMAP_CSV_MAX_SIZE + 1, f);
+  fclose(f);
+  csv[len > REGMAP_CSV_MAX_SIZE ? REGMAP_CSV_MAX_SIZE : len] = '\0';
+  //-------------------------------------------------
+  // 2. Take the cache, or parse & cache
+  //-------------------------------------------------
+  int64_t start_us = esp_timer_get_time();
+  uint32_t crc = RegMap_CRC32(0, csv, len);
+  uint16_t pool_len = 0;
+  int n = -1;
+  if (len > REGMAP_CSV_MAX_SIZE) { ESP_LOGE(TAG, "!!     ❌ '%s' is larger than %d bytes", REGMAP_CSV_FILE, REGMAP_CSV_MAX_SIZE); }
+  else if ((n = RegMap_Load_Cache(crc, len, desc, powermeter_RegMapPool, &pool_len)) >= 0) { powermeter_RegMapSource = "cache"; }
+  else if ((n = RegMap_Parse_CSV(csv, desc, powermeter_RegMapPool, &pool_len)) >= 0) {
+      powermeter_RegMapSource = "csv";
+      RegMap_Save_Cache(crc, len, desc, n, powermeter_RegMapPool, pool_len); }
+  free(csv);
+  if (n <= 0) {
+      if (n == 0) { ESP_LOGW(TAG, "--     ⚠️ '%s' has no registers", REGMAP_CSV_FILE); }
+      ESP_LOGW(TAG, "--     ⚠️ Register map NOT used >> compiled register sets are used");
+      powermeter_RegMapSource = "compiled";
+      free(desc); return; }
+  //-------------------------------------------------
+  // 3. Hand the register sets over to the meters
+  //-------------------------------------------------
+  for (int i = 0; i < n; i++) {
+      const regmap_desc_t *d = &desc[i];
+      if (i == 0 || d->meter != desc[i-1].meter) {                          // First register of the meter
+          powermeter_Devices[d->meter].regs    = &powermeter_RegArrayRT[i];
+          powermeter_Devices[d->meter].numRegs = 0; }
+      powermeter_RegArrayRT[i] = (powermeter_struct) {
+          .cid         = powermeter_Devices[d->meter].numRegs++,
+          .topicName   = powermeter_RegMapPool + d->nameOfs,
+          .unitOfValue = powermeter_RegMapPool + d->unitOfs,
+          .currVal     = NAN,                                               // NOT read yet (NAN != any value >> 1st read is published)
+          .minVal      = d->minVal,
+          .maxVal      = d->maxVal,
+          .digits      = d->digits,
+          .hasPrio     = d->hasPrio,
+          .refreshMs   = d->refreshMs,
+          .registerHex = d->registerHex };
+  }
+  free(desc);
+  ESP_LOGI(TAG, "--     ✅ Register map from %s: %d registers in %lld µs", powermeter_RegMapSource, n, (long long)(esp_timer_get_time() - start_us));
+}
+#else
+const char *powermeter_RegMapSource = "compiled";              // Where the register sets come from (only compiled ones)
+#endif
 
 /*---------------------------------------------------------------------------------------------------------
   Modbus_Build_ParaDescriptors_PowerMeter: Build the list of selected SDM registers for ESP-IDF's Modbus-Controller
   ---------------------------------------------------------------------------------------------------------
+  The CIDs run over ALL meters of powermeter_Devices, one after the other.
   used by: app_main 
            as handover to initialize the Modbus-Controller 
 ----------------------------------------------------------------------------------------------------------*/
-mb_parameter_descriptor_t powermeter_param_descriptors[MBREG]; // Create an empty array of parameter descriptors for all my SDM registers 
+mb_parameter_descriptor_t powermeter_param_descriptors[MB_MAX_CIDS]; // Create an empty array of parameter descriptors for all my SDM registers 
 void Modbus_Build_ParaDescriptors_PowerMeter(void) {
-  for (int i = 0; i < MBREG; i++) { // Fill the empty array with the values from powermeter_RegArray
+  int i = 0; // CID = running number over all meters
+  int dropped = 0; // Registers left out: NO room for their CID
+  for (int d = 0; d < PRM_NUM_DEVICES; d++) { 
+    powermeter_Devices[d].firstCid = i;
+    if (i + powermeter_Devices[d].numRegs > MB_MAX_CIDS) { dropped += i + powermeter_Devices[d].numRegs - MB_MAX_CIDS; }
+    for (int r = 0; r < powermeter_Devices[d].numRegs && i < MB_MAX_CIDS; r++, i++) { // Fill the empty array with the values from the meter's registers
+      volatile powermeter_struct *reg = &powermeter_Devices[d].regs[r];
+      powermeter_Regs[i] = reg;                                                          // Lookup: CID >> Register
+      powermeter_RegDevice[i] = d;                                                       // Lookup: CID >> Meter
       powermeter_param_descriptors[i].cid            = i;                                  // [uint16_t],unsig 16-b int   >> CID for Modbus-Controller Structure / 
-      powermeter_param_descriptors[i].param_key      = powermeter_RegArray[i].topicName;   // ➡️[const char]:             >> Meaning of the Register same like MQTT topic-name
-      powermeter_param_descriptors[i].param_units    = powermeter_RegArray[i].unitOfValue; // ➡️[const char]:             >> The physical unit
-      powermeter_param_descriptors[i].mb_slave_addr  = MB_UNIT_ID;                    // [uint8t],unsign.8-bit int        >> Address of the Slave Device to be read from
+      powermeter_param_descriptors[i].param_key      = reg->topicName;                     // ➡️[const char]:             >> Meaning of the Register same like MQTT topic-name
+      powermeter_param_descriptors[i].param_units    = reg->unitOfValue;                   // ➡️[const char]:             >> The physical unit
+      powermeter_param_descriptors[i].mb_slave_addr  = powermeter_Devices[d].slaveId; // [uint8t],unsign.8-bit int        >> Address of the Slave Device to be read from
       powermeter_param_descriptors[i].mb_param_type  = MB_PARAM_INPUT;                // [enum] Modbus Pare-Types         >> What kind of Modbus register you want to access and how?   
                                           // Possible Types={MB_PARAM_HOLDING = Holding Reg., MB_PARAM_INPUT= Input Reg., MB_PARAM_COIL=Coils/boolean, MB_PARAM_DISCRETE= Discrete bits}
-      powermeter_param_descriptors[i].mb_reg_start   = powermeter_RegArray[i].registerHex; // [uint16_t],unsig 16-b int   >> Modbus register address, hex
-      powermeter_param_descriptors[i].mb_size        = PARAM_SIZE_FLOAT;              // [uint16_t],unsig 16-b int        >> Size of MB Parameter in registers
+      powermeter_param_descriptors[i].mb_reg_start   = reg->registerHex;                   // [uint16_t],unsig 16-b int   >> Modbus register address, hex
+      powermeter_param_descriptors[i].mb_size        = PARAM_SIZE_FLOAT/2;            // [uint16_t],unsig 16-b int        >> Size of MB Parameter in registers (float = 2 registers)
       powermeter_param_descriptors[i].param_offset   = (i*2);                         // [uint32t],unsign.32-bit int      >> Parameter name (OFFSET in the parameter structure or address of instance) // offsetof(powermeter_struct, currVal)
       powermeter_param_descriptors[i].param_type     = PARAM_TYPE_FLOAT_CDAB;         // [enum] >> Includes the encoding! >> Float, U8, U16, U32, ASCII, and very specialed ones thie above like used  PARAM_TYPE_FLOAT_CDAB
                                                                                //           SDM630: 32-bit IEEE-754 floating point: Big-endian byte order, 2 Modbus registers
@@ -424,25 +828,1120 @@ void Modbus_Build_ParaDescriptors_PowerMeter(void) {
                  PARAM_TYPE_FLOAT_BADC >> ERROR // Little-endian byte order, 2 Modbus registers, reversed register order
                  PARAM_TYPE_FLOAT_DCBA >> ERROR // Little-endian byte order, 2 Modbus registers */     
       // Info about the Value-Range and precision of the value  
-      powermeter_param_descriptors[i].param_opts.min  = powermeter_RegArray[i].minVal; // Minimal Value. !!! NOT USED  in my Prj.!!!
-      powermeter_param_descriptors[i].param_opts.max  = powermeter_RegArray[i].maxVal; // Maximal Value. !!! NOT USED  in my Prj.!!!
-      powermeter_param_descriptors[i].param_opts.step = powermeter_RegArray[i].digits; // Step of parameter change tracking.
+      powermeter_param_descriptors[i].param_opts.min  = reg->minVal;                   // Minimal Value. !!! NOT USED  in my Prj.!!!
+      powermeter_param_descriptors[i].param_opts.max  = reg->maxVal;                   // Maximal Value. !!! NOT USED  in my Prj.!!!
+      powermeter_param_descriptors[i].param_opts.step = reg->digits;                   // Step of parameter change tracking.
       powermeter_param_descriptors[i].access          = PAR_PERMS_READ;                // Access permissions based on mode
+    }
+  }
+  powermeter_NumCids = i; // Number of CIDs over all meters
+  if (dropped == 0) { return; } // ALL fitted (also exactly MB_MAX_CIDS)
+  ESP_LOGE(TAG_MB_READ, "!!  ⚠️ Registers of all meters exceed MB_MAX_CIDS (%d), %d left out, increase it!", MB_MAX_CIDS, dropped);
+}
+
+/*#################################################################################################################################
+   SNAPSHOT   SNAPSHOT   SNAPSHOT   SNAPSHOT   SNAPSHOT   SNAPSHOT   SNAPSHOT   SNAPSHOT   SNAPSHOT   SNAPSHOT   SNAPSHOT   SNAPSHOT
+##################################################################################################################################*/
+/*---------------------------------------------------------------------------------------------------------
+  Consistent data set of ONE poll cycle for WebServer & MQTT (seqlock)
+  ---------------------------------------------------------------------------------------------------------
+  * WRITERS (poll tasks of all buses, MQTT publish task) take turns with 'powermeter_CycleMutex'.
+    The sequence number is odd while a writer copies into the snapshot.
+  * READERS never lock: they copy the snapshot and retry, when the sequence number was odd or has changed.
+    So a WebServer refresh never mixes values of two poll cycles and never blocks the poll tasks.
+----------------------------------------------------------------------------------------------------------*/
+typedef struct {
+  uint32_t       cycle;                         // Sequence number of the poll cycle (counts cycles of all buses)
+  float          values[MB_MAX_CIDS];           // Value of each register (CID)
+  int64_t        sampleUs[MB_MAX_CIDS];         // Acquisition time of the value (esp_timer µs, 0 = never read)
+  int64_t        sampleEpochMs[MB_MAX_CIDS];    // Acquisition time of the value as wall-clock (epoch ms, 0 = unknown)
+  uint32_t       errCount[MB_MAX_CIDS];         // Read errors of each register
+  bool           breakerOpen[MB_MAX_CIDS];      // Circuit breaker of the register is open
+  bool           updateMQTT[MB_MAX_CIDS];       // Value of the register is to be published (flag at the time of the snapshot)
+  uint32_t       changeSeq[MB_MAX_CIDS];        // ... and the change it belongs to
+  uint32_t       readsSuccess;                  // = powermeter_reads_success
+  uint32_t       readsError;                    // = powermeter_reads_error
+  const char     *lastErrTxt;                   // = str_Error_RegisterRead
+  char           successTS[SHRORT_TS_LEN];      // = powermeter_SuccessUpdateDS_TS
+  char           errorTS[SHRORT_TS_LEN];        // = powermeter_ErrorRead_TS
+  unsigned long  readDataSetTime;               // = readDataSetTime
+  unsigned long  readDataSetRegs;               // = readDataSetRegs
+  uint32_t       devReadsOk[PRM_NUM_DEVICES];   // = powermeter_Devices[].readsOk
+  uint32_t       devReadsErr[PRM_NUM_DEVICES];  // = powermeter_Devices[].readsErr
+  unsigned long  devBusTimeMs[PRM_NUM_DEVICES]; // = powermeter_Devices[].busTimeMs
+  esp_err_t      devLastErr[PRM_NUM_DEVICES];   // = powermeter_Devices[].lastErr
+  uint32_t       publSuccess;                   // = powermeter_published_success
+  uint32_t       publError;                     // = powermeter_published_error
+  char           publSuccessTS[SHRORT_TS_LEN];  // = powermeter_PublishSuccess_TS
+  char           publErrorTS[SHRORT_TS_LEN];    // = powermeter_PublishError_TS
+  cadence_stats_t pollCadence;                  // = powermeter_PollCadence[] of all buses
+  cadence_stats_t publCadence;                  // = powermeter_PublCadence
+} powermeter_snapshot_t;
+static powermeter_snapshot_t powermeter_Snapshot;       // The ONE shared snapshot
+static uint32_t powermeter_SnapshotSeq = 0;             // Sequence number of the seqlock (odd = write in progress)
+static uint32_t powermeter_CycleSeq    = 0;             // Running number of poll cycles
+
+/*--------------------------------
+  Seqlock: Begin/End of a write, caller HOLDS powermeter_CycleMutex
+----------------------------------*/ 
+static inline void PowerMeter_Snapshot_Write_Begin(void) {
+  __atomic_store_n(&powermeter_SnapshotSeq, powermeter_SnapshotSeq + 1, __ATOMIC_RELAXED); // >> odd
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);              // Odd number visible BEFORE the data changes
+}
+static inline void PowerMeter_Snapshot_Write_End(void) {
+  __atomic_store_n(&powermeter_SnapshotSeq, powermeter_SnapshotSeq + 1, __ATOMIC_RELEASE); // >> even = stable
+}
+
+/*---------------------------------------------------------------------------------------------------------
+  PowerMeter_Snapshot_Poll_Results: Copy the values & results of a finished poll cycle into the snapshot
+  used by: Task_Modbus_SDM_Poll_RegisterValues (holds powermeter_CycleMutex) & app_main (initial)
+----------------------------------------------------------------------------------------------------------*/
+static void PowerMeter_Snapshot_Poll_Results(void) {
+  powermeter_snapshot_t *s = &powermeter_Snapshot;
+  PowerMeter_Snapshot_Write_Begin();
+  s->cycle = ++powermeter_CycleSeq;
+  int64_t boot_ms = getEpochMs_of_Timer(0);            // Wall-clock at esp_timer = 0 (0 = no NTP time yet)
+  for (int i = 0; i < powermeter_NumCids; i++) {
+      s->values[i]      = powermeter_Regs[i]->currVal;
+      s->sampleUs[i]    = powermeter_Regs[i]->sample_us;
+      s->sampleEpochMs[i] = (boot_ms && s->sampleUs[i]) ? boot_ms + s->sampleUs[i] / 1000 : 0;
+      s->errCount[i]    = powermeter_Regs[i]->errCount;
+      s->breakerOpen[i] = (powermeter_Regs[i]->failStreak >= MB_BREAKER_THRESHOLD);
+      s->changeSeq[i]   = powermeter_Regs[i]->changeSeq;
+      s->updateMQTT[i]  = powermeter_Regs[i]->updateMQTT; }
+  s->readsSuccess    = powermeter_reads_success;
+  s->readsError      = powermeter_reads_error;
+  s->lastErrTxt      = str_Error_RegisterRead;
+  s->readDataSetTime = readDataSetTime;
+  s->readDataSetRegs = readDataSetRegs;
+  snprintf(s->successTS, sizeof(s->successTS), "%s", powermeter_SuccessUpdateDS_TS);
+  snprintf(s->errorTS, sizeof(s->errorTS), "%s", powermeter_ErrorRead_TS);
+  for (int d = 0; d < PRM_NUM_DEVICES; d++) {
+      s->devReadsOk[d]   = powermeter_Devices[d].readsOk;
+      s->devReadsErr[d]  = powermeter_Devices[d].readsErr;
+      s->devBusTimeMs[d] = powermeter_Devices[d].busTimeMs;
+      s->devLastErr[d]   = powermeter_Devices[d].lastErr; }
+  memset(&s->pollCadence, 0, sizeof(s->pollCadence));
+  for (int bus = 0; bus < MB_NUM_BUSES; bus++) { Cadence_Add(&s->pollCadence, &powermeter_PollCadence[bus]); }
+  PowerMeter_Snapshot_Write_End();
+}
+
+/*---------------------------------------------------------------------------------------------------------
+  PowerMeter_Snapshot_Publish_Results: Copy the results of a finished MQTT publish cycle into the snapshot
+  used by: Task_MQTT_PowerMeter_Publish (holds powermeter_CycleMutex) & app_main (initial)
+----------------------------------------------------------------------------------------------------------*/
+static void PowerMeter_Snapshot_Publish_Results(void) {
+  powermeter_snapshot_t *s = &powermeter_Snapshot;
+  PowerMeter_Snapshot_Write_Begin();
+  s->publSuccess = powermeter_published_success;
+  s->publError   = powermeter_published_error;
+  snprintf(s->publSuccessTS, sizeof(s->publSuccessTS), "%s", powermeter_PublishSuccess_TS);
+  snprintf(s->publErrorTS, sizeof(s->publErrorTS), "%s", powermeter_PublishError_TS);
+  s->publCadence = powermeter_PublCadence;
+  PowerMeter_Snapshot_Write_End();
+}
+
+/*--------------------------------
+  Is the value of the snapshot to be published? Its flag is set AND no newer change came since the snapshot
+  (the poll task changes flag & 'changeSeq' only while the flag is clear >> a match stays valid until the publisher clears it)
+----------------------------------*/ 
+static inline bool PowerMeter_Snapshot_Update_Pending(int i, const powermeter_snapshot_t *snap) {
+  return snap->updateMQTT[i] && powermeter_Regs[i]->updateMQTT && powermeter_Regs[i]->changeSeq == snap->changeSeq[i];
+}
+
+/*---------------------------------------------------------------------------------------------------------
+  PowerMeter_Snapshot_Read: Get a consistent copy of the snapshot, without any lock
+  ---------------------------------------------------------------------------------------------------------
+  A writer needs only some µs. If the reader has a higher priority than the writer on the same core,
+  spinning would never let the writer finish >> after some tries the reader sleeps one tick.
+  used by: Interface_ModbusValues_to_WebServer_SDMValues & Task_MQTT_PowerMeter_Publish
+----------------------------------------------------------------------------------------------------------*/
+void PowerMeter_Snapshot_Read(powermeter_snapshot_t *out) {
+  uint32_t seq_start, seq_end;
+  for (int tries = 1; ; tries++) {
+      seq_start = __atomic_load_n(&powermeter_SnapshotSeq, __ATOMIC_ACQUIRE);
+      if ((seq_start & 1) == 0) {                       // No write in progress
+          memcpy(out, &powermeter_Snapshot, sizeof(*out));
+          __atomic_thread_fence(__ATOMIC_ACQUIRE);      // Copy done BEFORE the number is checked again
+          seq_end = __atomic_load_n(&powermeter_SnapshotSeq, __ATOMIC_RELAXED);
+          if (seq_start == seq_end) { return; }         // Nothing changed meanwhile >> consistent
+      }
+      if (tries % 8 == 0) { vTaskDelay(1); }            // Let the writer finish
   }
 }
 
+/*---------------------------------------------------------------------------------------------------------
+  Modbus_Build_ReadPlan_PowerMeter: Group the DUE SDM registers to a few block reads (FC04)
+  ---------------------------------------------------------------------------------------------------------
+  Deadline scheduler (earliest-deadline-first):
+    * Every register has its own refresh period 'refreshMs' and a deadline 'nextDue_us'.
+    * Registers due now (or within MB_SCHED_FOLD_AHEAD_MS) are taken in order of their deadline,
+      max. MB_SCHED_MAX_REGS_PER_CYCLE of them. The most overdue ones are served first.
+    * The taken registers are grouped to block reads by the planner of 'Modbus_UART_RTU'.
+    * Each bus has its own plan, only the registers of the meters on that bus are taken.
+  Answer: Number of planned block reads (0 = nothing due)
+  used by: Task_Modbus_SDM_Poll_RegisterValues & app_main (with now=0 >> ALL registers, to log the plan)
+----------------------------------------------------------------------------------------------------------*/
+uint16_t        powermeter_ReadOrder[MB_NUM_BUSES][MB_MAX_CIDS];    // CIDs sorted by register = order used by the read plan
+mb_block_read_t powermeter_ReadPlan[MB_NUM_BUSES][MB_MAX_CIDS];     // Planned block reads (worst case: one block per register)
+size_t          powermeter_NumBlocks[MB_NUM_BUSES] = { 0 };         // Number of planned block reads
+
+/*---------------------------------------------------------------------------------------------------------
+  Modbus_Interleave_ReadPlan_PowerMeter: Reorder the planned blocks, so the meters take turns on the bus
+  ---------------------------------------------------------------------------------------------------------
+  The planner returns the blocks sorted by slave address: A1 A2 A3 B1 B2 >> A1 B1 A2 B2 A3
+  So a slow or missing meter does not delay all values of the next meter in the cycle.
+  used by: Modbus_Build_ReadPlan_PowerMeter
+----------------------------------------------------------------------------------------------------------*/
+static void Modbus_Interleave_ReadPlan_PowerMeter(uint8_t bus) {
+  mb_block_read_t *plan = powermeter_ReadPlan[bus];
+  mb_block_read_t sorted[MB_MAX_CIDS];          // Copy of the plan, sorted by slave
+  size_t next[PRM_NUM_DEVICES];                 // Next block to take of each slave-group
+  size_t end[PRM_NUM_DEVICES];                  // End of each slave-group
+  size_t num_groups = 0, n = 0;
+  memcpy(sorted, plan, powermeter_NumBlocks[bus] * sizeof(mb_block_read_t));
+  for (size_t b = 0; b < powermeter_NumBlocks[bus]; b++) {  // Find the slave-groups
+      if (b == 0 || sorted[b].slave_addr != sorted[b-1].slave_addr) { next[num_groups++] = b; }
+      end[num_groups-1] = b + 1; }
+  while (n < powermeter_NumBlocks[bus]) {                   // Round-robin over the groups
+      for (size_t g = 0; g < num_groups; g++) {
+          if (next[g] < end[g]) { plan[n++] = sorted[next[g]++]; } } }
+}
+
+/*--------------------------------
+  Deadline of a register: its own, or later while its meter is backed off (does not answer)
+----------------------------------*/ 
+static inline int64_t PowerMeter_Due_us(int i) {
+  int64_t due_us = powermeter_Regs[i]->nextDue_us;
+  int64_t dev_us = powermeter_Devices[powermeter_RegDevice[i]].backoffUntil_us;
+  return (dev_us > due_us) ? dev_us : due_us;
+}
+
+size_t Modbus_Build_ReadPlan_PowerMeter(uint8_t bus, int64_t now_us) {
+  uint16_t *order = powermeter_ReadOrder[bus];  // CIDs of this bus
+  mb_block_read_t *plan = powermeter_ReadPlan[bus];
+  size_t num_due = 0;                           // Number of due registers
+  int64_t due_limit = now_us + (int64_t)MB_SCHED_FOLD_AHEAD_MS * 1000; // Registers due until then are read now
+  //----------------------------------------------------
+  // 1. Collect due registers sorted by their deadline
+  //----------------------------------------------------
+  for (int i = 0; i < powermeter_NumCids; i++) {
+      if (powermeter_Devices[powermeter_RegDevice[i]].bus != bus) { continue; }     // Other bus
+      if (now_us != 0 && PowerMeter_Due_us(i) > due_limit) { continue; }          // NOT due (or its meter backed off)
+      int j = num_due++;
+      while (j > 0 && PowerMeter_Due_us(order[j-1]) > PowerMeter_Due_us(i)) {
+          order[j] = order[j-1]; j--; }  // Insert sorted by deadline (EDF)
+      order[j] = powermeter_param_descriptors[i].cid;
+  }
+  if (num_due > MB_SCHED_MAX_REGS_PER_CYCLE) { num_due = MB_SCHED_MAX_REGS_PER_CYCLE; } // Rest is taken next cycle
+  //----------------------------------------------------
+  // 2. Group them to block reads
+  //----------------------------------------------------
+  powermeter_NumBlocks[bus] = Modbus_Plan_Block_Reads(bus, order, num_due, plan, MB_MAX_CIDS);
+  if (PRM_NUM_DEVICES > 1) { Modbus_Interleave_ReadPlan_PowerMeter(bus); } // Meters take turns on the bus
+  if (now_us == 0) { // Log the plan for ALL registers 
+      ESP_LOGI(TAG_MB_READ, "--  Read-Plan bus %d: %d registers with %d block reads (when all are due)", bus, num_due, powermeter_NumBlocks[bus]);
+      for (int b = 0; b < powermeter_NumBlocks[bus]; b++) {
+          ESP_LOGI(TAG_MB_READ, "--    * Block %d: slave %d 0x%04X..0x%04X (%3d regs) covers %2d registers", b, plan[b].slave_addr,
+              plan[b].reg_start, plan[b].reg_start + plan[b].reg_count - 1, plan[b].reg_count, plan[b].num_cids);
+      }
+  }
+  return powermeter_NumBlocks[bus];
+}
+
+#if CONFIG_PRM_HISTORY_ENABLE
+/*---------------------------------------------------------------------------------------------------------
+  HISTORY of the values: ONE series per register (CID) in the time-series store (RAM, PSRAM if there is)
+  ---------------------------------------------------------------------------------------------------------
+  * EVERY read value is appended, time = acquisition time in ms since boot (esp_timer / 1000).
+    >> wall-clock: getEpochMs_of_Timer(t_ms * 1000)
+  * Read with TS_Store_Query(powermeter_History, cid, from, to, step, ...): a time range, downsampled on the fly.
+----------------------------------------------------------------------------------------------------------*/
+ts_store_handle_t powermeter_History = NULL;            // NULL = no history (no memory)
+#endif
+
+#if CONFIG_PRM_STATS_ENABLE
+/*---------------------------------------------------------------------------------------------------------
+  WINDOW STATISTICS per register: count, min, max, mean, std. deviation, first & last value
+  ---------------------------------------------------------------------------------------------------------
+  * EVERY read value is added to the running window of its register: O(1), no samples are kept
+    (Welford: mean & sum of squared deviations, numerically stable also for large values).
+  * TUMBLING window: CONFIG_PRM_STATS_WINDOW_S, the same grid for ALL registers, aligned to the wall-clock
+    (e.g. 60 s >> closes at every full minute, before NTP sync on the time since boot).
+  * ROLLING window: the last CONFIG_PRM_STATS_ROLLING_WINDOWS closed tumbling windows, merged when a
+    window closes (e.g. 15 x 60 s >> the last 15 min, advanced every minute).
+  * A window closes with the first value after its end, or by the MQTT publish task (meter does not answer).
+  So a broker gets one summary per register & window instead of every value, peaks included.
+----------------------------------------------------------------------------------------------------------*/
+typedef struct {                       // Aggregate of ONE window of ONE register
+  uint32_t       n;                    // Number of values
+  float          min;                  // Smallest value
+  float          max;                  // Largest value
+  float          first;                // First value of the window
+  float          last;                 // Last value of the window
+  double         mean;                 // Running mean
+  double         m2;                   // Sum of squared deviations from the mean >> variance = m2 / n
+} powermeter_window_t;
+
+static SemaphoreHandle_t   powermeter_StatsMutex = NULL;          // Poll tasks of all buses add, a window close takes all
+static powermeter_window_t powermeter_StatsCur[MB_MAX_CIDS];      // Running tumbling window of each register
+static powermeter_window_t *powermeter_StatsRing = NULL;          // Closed windows [cid * CONFIG_PRM_STATS_ROLLING_WINDOWS + slot] (heap)
+static int                 powermeter_StatsHead = 0;              // Slot of the ring the NEXT closed window goes to
+static int                 powermeter_StatsFilled = 0;            // Closed windows in the ring (<= CONFIG_PRM_STATS_ROLLING_WINDOWS)
+static int64_t             powermeter_StatsStart_us = 0;          // Start of the running window (esp_timer µs)
+static int64_t             powermeter_StatsEnd_us = INT64_MAX;    // End of the running window   (INT64_MAX = not set up)
+typedef struct {                       // RESULTS of the last window close (MQTT & WebServer get a copy)
+  uint32_t       closed;               // COUNTER of closed windows (changes >> new results to publish)
+  int64_t        startUs;              // Start of the last closed tumbling window (esp_timer µs)
+  int64_t        endUs;                // End of it
+  int64_t        rollStartUs;          // Start of the rolling window (it ends with the tumbling one)
+  powermeter_window_t last[MB_MAX_CIDS]; // Last closed tumbling window of each register
+  powermeter_window_t roll[MB_MAX_CIDS]; // Rolling window of each register
+} powermeter_stats_result_t;
+static powermeter_stats_result_t powermeter_StatsResult;          // Written & read with powermeter_StatsMutex
+
+/*--------------------------------
+  Add ONE value to a window (Welford)
+----------------------------------*/ 
+static inline void Stats_Window_Add(powermeter_window_t *w, float value) {
+  if (w->n == 0) { w->min = w->max = w->first = value; }
+  else           { if (value < w->min) { w->min = value; }
+                   if (value > w->max) { w->max = value; } }
+  w->last = value;
+  w->n++;
+  double delta = value - w->mean;
+  w->mean += delta / w->n;
+  w->m2   += delta * (value - w->mean);
+}
+
+/*--------------------------------
+  Merge window 'b' (later) into 'a' (earlier): Chan et al.
+----------------------------------*/ 
+static void Stats_Window_Merge(powermeter_window_t *a, const powermeter_window_t *b) {
+  if (b->n == 0) { return; }
+  if (a->n == 0) { *a = *b; return; }
+  double n = (double)a->n + b->n;
+  double delta = b->mean - a->mean;
+  a->mean += delta * b->n / n;
+  a->m2   += b->m2 + delta * delta * a->n * b->n / n;
+  if (b->min < a->min) { a->min = b->min; }
+  if (b->max > a->max) { a->max = b->max; }
+  a->last = b->last;                   // 'first' stays the one of the earlier window
+  a->n   += b->n;
+}
+
+/*--------------------------------
+  End of the window starting at 'start_us': next full multiple of the window length on the wall-clock
+----------------------------------*/ 
+static int64_t Stats_Window_End(int64_t start_us) {
+  int64_t win_ms   = (int64_t)CONFIG_PRM_STATS_WINDOW_S * 1000;
+  int64_t start_ms = getEpochMs_of_Timer(start_us);     // 0 = no NTP time yet >> grid since boot
+  if (start_ms == 0) { start_ms = start_us / 1000; }
+  return start_us + (win_ms - start_ms % win_ms) * 1000;
+}
+
+/*--------------------------------------------------------------------------------------------------
+  PowerMeter_Stats_Close: Close the running window of ALL registers, caller HOLDS powermeter_StatsMutex
+----------------------------------------------------------------------------------------------------*/
+static void PowerMeter_Stats_Close(int64_t now_us) {
+  const int nwin = CONFIG_PRM_STATS_ROLLING_WINDOWS;
+  for (int k = 0; k <= nwin && now_us >= powermeter_StatsEnd_us; k++) { // A long gap closes empty windows (max. a whole ring)
+      for (int i = 0; i < powermeter_NumCids; i++) {
+          powermeter_StatsRing[i * nwin + powermeter_StatsHead] = powermeter_StatsCur[i];
+          memset(&powermeter_StatsCur[i], 0, sizeof(powermeter_StatsCur[i])); }
+      powermeter_StatsHead = (powermeter_StatsHead + 1) % nwin;
+      if (powermeter_StatsFilled < nwin) { powermeter_StatsFilled++; }
+      powermeter_StatsResult.startUs = powermeter_StatsStart_us;
+      powermeter_StatsResult.endUs   = powermeter_StatsEnd_us;
+      powermeter_StatsStart_us       = powermeter_StatsEnd_us;
+      powermeter_StatsEnd_us         = Stats_Window_End(powermeter_StatsStart_us); }
+  if (now_us >= powermeter_StatsEnd_us) {                                // Gap longer than the ring >> restart the grid now
+      powermeter_StatsStart_us = now_us;
+      powermeter_StatsEnd_us   = Stats_Window_End(now_us); }
+  //..................................................
+  // Results: last tumbling window & merge of the ring (oldest first)
+  //..................................................
+  powermeter_stats_result_t *res = &powermeter_StatsResult;
+  int oldest = (powermeter_StatsHead - powermeter_StatsFilled + nwin) % nwin;
+  for (int i = 0; i < powermeter_NumCids; i++) {
+      const powermeter_window_t *ring = &powermeter_StatsRing[i * nwin];
+      res->last[i] = ring[(powermeter_StatsHead - 1 + nwin) % nwin];
+      memset(&res->roll[i], 0, sizeof(res->roll[i]));
+      for (int k = 0; k < powermeter_StatsFilled; k++) { Stats_Window_Merge(&res->roll[i], &ring[(oldest + k) % nwin]); } }
+  res->rollStartUs = res->endUs - (int64_t)powermeter_StatsFilled * CONFIG_PRM_STATS_WINDOW_S * 1000000; // First window may have been shorter
+  res->closed++;
+}
+
+/*--------------------------------------------------------------------------------------------------
+  PowerMeter_Stats_Setup: Ring of the closed windows (needs the number of registers) & first window
+  used by: app_main
+----------------------------------------------------------------------------------------------------*/
+void PowerMeter_Stats_Setup(void)
+{ powermeter_StatsRing = calloc((size_t)powermeter_NumCids * CONFIG_PRM_STATS_ROLLING_WINDOWS, sizeof(powermeter_window_t));
+  if (powermeter_StatsRing == NULL || powermeter_NumCids == 0) {
+      ESP_LOGE(TAG_MB_READ, "--  ❌ Window statistics: no memory for %d registers, statistics OFF", (int)powermeter_NumCids);
+      return; }
+  powermeter_StatsMutex    = xSemaphoreCreateMutex();
+  powermeter_StatsStart_us = esp_timer_get_time();
+  powermeter_StatsEnd_us   = Stats_Window_End(powermeter_StatsStart_us); // First window is shorter: ends on the grid
+  ESP_LOGI(TAG_MB_READ, "--  ✅ Window statistics of %d registers: tumbling %d s, rolling %d x %d s (%d bytes)", (int)powermeter_NumCids,
+           CONFIG_PRM_STATS_WINDOW_S, CONFIG_PRM_STATS_ROLLING_WINDOWS, CONFIG_PRM_STATS_WINDOW_S,
+           (int)(powermeter_NumCids * CONFIG_PRM_STATS_ROLLING_WINDOWS * sizeof(powermeter_window_t)));
+}
+
+/*--------------------------------------------------------------------------------------------------
+  PowerMeter_Stats_Add: Add a read value to the window of its register (closes a finished window first)
+  used by: PowerMeter_Update_Value
+----------------------------------------------------------------------------------------------------*/
+static void PowerMeter_Stats_Add(int i, float value, int64_t now_us)
+{ if (powermeter_StatsMutex == NULL || isnan(value)) { return; }
+  xSemaphoreTake(powermeter_StatsMutex, portMAX_DELAY);
+  if (now_us >= powermeter_StatsEnd_us) { PowerMeter_Stats_Close(now_us); } // Value belongs to the NEXT window
+  Stats_Window_Add(&powermeter_StatsCur[i], value);
+  xSemaphoreGive(powermeter_StatsMutex);
+}
+
+/*--------------------------------------------------------------------------------------------------
+  PowerMeter_Stats_Tick: Close a finished window, also when no value comes in
+  used by: Task_MQTT_PowerMeter_Publish
+----------------------------------------------------------------------------------------------------*/
+static void PowerMeter_Stats_Tick(void)
+{ if (powermeter_StatsMutex == NULL) { return; }
+  int64_t now_us = esp_timer_get_time();
+  if (now_us < powermeter_StatsEnd_us) { return; }                      // Most calls: nothing to do, no lock
+  xSemaphoreTake(powermeter_StatsMutex, portMAX_DELAY);
+  if (now_us >= powermeter_StatsEnd_us) { PowerMeter_Stats_Close(now_us); }
+  xSemaphoreGive(powermeter_StatsMutex);
+}
+
+/*--------------------------------------------------------------------------------------------------
+  PowerMeter_Stats_Read: Copy of the results of the last window close
+  Answer: Number of closed windows (0 = none yet, or statistics OFF)
+  used by: Task_MQTT_PowerMeter_Publish & Handle_WebServer_Stats_GET
+----------------------------------------------------------------------------------------------------*/
+uint32_t PowerMeter_Stats_Read(powermeter_stats_result_t *out)
+{ if (powermeter_StatsMutex == NULL) { out->closed = 0; return 0; }
+  xSemaphoreTake(powermeter_StatsMutex, portMAX_DELAY);
+  memcpy(out, &powermeter_StatsResult, sizeof(*out));
+  xSemaphoreGive(powermeter_StatsMutex);
+  return out->closed;
+}
+
+/*--------------------------------------------------------------------------------------------------
+  PowerMeter_Stats_Format: ONE window as JSON members, 'digits' of the register (+1 for mean & sd)
+    "n":58,"min":-512.0,"max":3120.0,"mean":1022.37,"sd":812.04,"first":980.0,"last":1002.0
+  used by: MQTT_Publish_PWR_Stats & Handle_WebServer_Stats_GET
+----------------------------------------------------------------------------------------------------*/
+static void PowerMeter_Stats_Format(pw_writer_t *pw, const powermeter_window_t *w, int digits)
+{ PW_Json_Int(pw, "n", w->n);
+  if (w->n == 0) { return; }                                                      // No value in the window
+  PW_Json_Fixed(pw, "min",   w->min, digits);
+  PW_Json_Fixed(pw, "max",   w->max, digits);
+  PW_Json_Fixed(pw, "mean",  w->mean, digits + 1);
+  PW_Json_Fixed(pw, "sd",    sqrt(w->m2 / w->n), digits + 1);
+  PW_Json_Fixed(pw, "first", w->first, digits);
+  PW_Json_Fixed(pw, "last",  w->last, digits);
+}
+#endif
+
+#if CONFIG_PRM_ENERGY_ENABLE
+/*---------------------------------------------------------------------------------------------------------
+  ENERGY INTEGRATION: import & export energy of power registers (e.g. per phase), on the device
+  ---------------------------------------------------------------------------------------------------------
+  * EVERY read value of the power registers in CONFIG_PRM_ENERGY_REGISTERS (of every meter) is integrated
+    with the trapezoidal rule on the acquisition times (µs). Positive power = import, negative = export;
+    a segment crossing zero is split at the zero crossing, so import & export are both right.
+  * Gaps longer than CONFIG_PRM_ENERGY_MAX_GAP_S (meter or ESP offline) are NOT bridged, only counted.
+  * Checkpoint to NVS (wear-aware): at most every CONFIG_PRM_ENERGY_CHECKPOINT_MIN and only if the energy
+    changed by CONFIG_PRM_ENERGY_CHECKPOINT_WH; always before a restart (shutdown handler).
+  * Cross-check: the first channel of a meter is compared with its 'import active energy' register,
+    counted from the start of the accumulators.
+----------------------------------------------------------------------------------------------------------*/
+#define PRM_ENERGY_MAX_CH     (16)      // Max. integrated power registers of ALL meters
+#define PRM_ENERGY_NVS_KEY    "energy"  // NVS key (namespace 'storage') of the checkpoint
+#define PRM_ENERGY_NVS_MAGIC  (0x4E524731) // 'NRG1' >> layout of the checkpoint
+
+typedef struct {                        // ONE integrated power register
+  uint16_t       cid;                   // CID of the power register
+  bool           isCheck;               // First channel of its meter >> cross-check with the meter's energy register
+  float          lastW;                 // Last power value (W)
+  int64_t        last_us;               // Acquisition time of it (0 = no value yet)
+  double         importWh;              // Integrated import energy (Wh)
+  double         exportWh;              // Integrated export energy (Wh), positive
+  double         gapS;                  // Time NOT integrated (gaps > CONFIG_PRM_ENERGY_MAX_GAP_S) in s
+  float          meterBaseKWh;          // Energy register of the meter when the accumulators started (NAN = not read yet)
+  float          meterKWh;              // Energy register of the meter, last value (NAN = not read yet)
+} powermeter_energy_ch_t;
+
+typedef struct {                        // NVS checkpoint: ONE blob, only the used channels are written
+  uint32_t       magic;                 // PRM_ENERGY_NVS_MAGIC
+  uint32_t       num;                   // Number of channels
+  struct {                              // ONE channel: found again by meter & name
+      char       name[32];              // Topic name of the power register
+      uint8_t    slaveId;               // Slave ID of its meter
+      uint8_t    bus;                   // Bus of its meter
+      double     importWh;
+      double     exportWh;
+      double     gapS;
+      float      meterBaseKWh;
+  } ch[PRM_ENERGY_MAX_CH];
+} powermeter_energy_nvs_t;
+#define PRM_ENERGY_NVS_LEN(num) (offsetof(powermeter_energy_nvs_t, ch) + (num) * sizeof(((powermeter_energy_nvs_t *)0)->ch[0]))
+
+static SemaphoreHandle_t      powermeter_EnergyMutex = NULL;            // Poll tasks add, publish task & checkpoint read
+static SemaphoreHandle_t      powermeter_EnergySaveMutex = NULL;        // ONE checkpoint at a time (publish task or restart)
+static powermeter_energy_ch_t powermeter_EnergyCh[PRM_ENERGY_MAX_CH];   // The integrated channels
+static int                    powermeter_EnergyNum = 0;                 // Number of channels
+static int8_t                 powermeter_EnergyOfCid[MB_MAX_CIDS];      // CID >> channel (-1 = not integrated)
+static int16_t                powermeter_EnergyMeterCid[PRM_NUM_DEVICES]; // Meter >> CID of its energy register (-1 = none)
+static double                 powermeter_EnergySavedWh = 0;             // Import + export at the last checkpoint
+static int64_t                powermeter_EnergySaved_us = 0;            // Time of the last checkpoint
+uint32_t                      powermeter_EnergySaves = 0;               // COUNTER of checkpoints written since boot
+
+/*--------------------------------------------------------------------------------------------------
+  PowerMeter_Energy_Checkpoint: Write the accumulators to NVS (wear-aware, see above)
+  used by: Task_MQTT_PowerMeter_Publish (force = false) & the shutdown handler (force = true)
+----------------------------------------------------------------------------------------------------*/
+void PowerMeter_Energy_Checkpoint(bool force)
+{ if (powermeter_EnergyMutex == NULL || powermeter_EnergyNum == 0) { return; }
+  int64_t now_us = esp_timer_get_time();
+  if (!force && now_us - powermeter_EnergySaved_us < (int64_t)CONFIG_PRM_ENERGY_CHECKPOINT_MIN * 60 * 1000000) { return; } // Too early
+  //..................................................
+  // Copy of the channels, and do they differ enough from the last checkpoint?
+  //..................................................
+  static powermeter_energy_nvs_t blob;                 // Static: keep it off the stack
+  xSemaphoreTake(powermeter_EnergySaveMutex, portMAX_DELAY);
+  blob.magic = PRM_ENERGY_NVS_MAGIC;
+  double total_Wh = 0;
+  xSemaphoreTake(powermeter_EnergyMutex, portMAX_DELAY);
+  for (int c = 0; c < powermeter_EnergyNum; c++) {
+      const powermeter_energy_ch_t *ch = &powermeter_EnergyCh[c];
+      const powermeter_device_t *dev = &powermeter_Devices[powermeter_RegDevice[ch->cid]];
+      snprintf(blob.ch[c].name, sizeof(blob.ch[c].name), "%s", powermeter_Regs[ch->cid]->topicName);
+      blob.ch[c].slaveId      = dev->slaveId;
+      blob.ch[c].bus          = dev->bus;
+      blob.ch[c].importWh     = ch->importWh;
+      blob.ch[c].exportWh     = ch->exportWh;
+      blob.ch[c].gapS         = ch->gapS;
+      blob.ch[c].meterBaseKWh = ch->meterBaseKWh;
+      total_Wh += ch->importWh + ch->exportWh; }
+  xSemaphoreGive(powermeter_EnergyMutex);
+  blob.num = powermeter_EnergyNum;
+  if (total_Wh - powermeter_EnergySavedWh < (force ? 0.001 : CONFIG_PRM_ENERGY_CHECKPOINT_WH)) { // Not worth a flash write
+      xSemaphoreGive(powermeter_EnergySaveMutex);
+      return; }
+  //..................................................
+  // Write ONE blob (only the used channels)
+  //..................................................
+  nvs_handle_t nvs_handle;
+  esp_err_t err = nvs_open("storage", NVS_READWRITE, &nvs_handle);
+  if (err == ESP_OK) {
+      err = nvs_set_blob(nvs_handle, PRM_ENERGY_NVS_KEY, &blob, PRM_ENERGY_NVS_LEN(blob.num));
+      if (err == ESP_OK) { err = nvs_commit(nvs_handle); }
+      nvs_close(nvs_handle); }
+  if (err == ESP_OK) {
+      powermeter_EnergySavedWh  = total_Wh;
+      powermeter_EnergySaved_us = now_us;
+      powermeter_EnergySaves++; }
+  xSemaphoreGive(powermeter_EnergySaveMutex);
+  if (err != ESP_OK) { ESP_LOGE(TAG_MB_READ, "--  ❌ Energy checkpoint NOT written: %s", esp_err_to_name(err)); return; }
+  ESP_LOGI(TAG_MB_READ, "--  ✅ Energy checkpoint %lu written (%d channels%s)", (unsigned long)powermeter_EnergySaves, (int)blob.num, force ? ", before restart" : "");
+}
+
+static void PowerMeter_Energy_Shutdown(void) { PowerMeter_Energy_Checkpoint(true); } // Nothing integrated since the last checkpoint gets lost
+
+/*--------------------------------------------------------------------------------------------------
+  PowerMeter_Energy_Setup: Find the power & energy registers, load the checkpoint
+  used by: app_main
+----------------------------------------------------------------------------------------------------*/
+void PowerMeter_Energy_Setup(void)
+{ memset(powermeter_EnergyOfCid, -1, sizeof(powermeter_EnergyOfCid));
+  for (int d = 0; d < PRM_NUM_DEVICES; d++) { powermeter_EnergyMeterCid[d] = -1; }
+  for (int i = 0; i < powermeter_NumCids; i++) {                        // Energy register of each meter (cross-check)
+      if (powermeter_Regs[i]->registerHex == SDM_IMPORT_ACTIVE_ENERGY) { powermeter_EnergyMeterCid[powermeter_RegDevice[i]] = i; } }
+  //..................................................
+  // 1. Channels: the names of the list at ALL meters (in the order of the list >> first = cross-check)
+  //..................................................
+  char list[] = CONFIG_PRM_ENERGY_REGISTERS;
+  char *rest = list, *name;
+  bool first_of_dev[PRM_NUM_DEVICES];
+  memset(first_of_dev, 1, sizeof(first_of_dev));
+  while ((name = strsep(&rest, ",")) != NULL) {
+      while (*name == ' ') { name++; }
+      for (int i = 0; i < powermeter_NumCids; i++) {
+          if (strcmp(powermeter_Regs[i]->topicName, name) != 0 || powermeter_EnergyOfCid[i] >= 0) { continue; }
+          if (powermeter_EnergyNum >= PRM_ENERGY_MAX_CH) { ESP_LOGW(TAG_MB_READ, "--  ⚠️ Energy: max. %d channels, '%s' left out", PRM_ENERGY_MAX_CH, name); break; }
+          powermeter_energy_ch_t *ch = &powermeter_EnergyCh[powermeter_EnergyNum];
+          memset(ch, 0, sizeof(*ch));
+          ch->cid          = i;
+          ch->isCheck      = first_of_dev[powermeter_RegDevice[i]];
+          ch->meterBaseKWh = NAN;
+          ch->meterKWh     = NAN;
+          first_of_dev[powermeter_RegDevice[i]] = false;
+          powermeter_EnergyOfCid[i] = powermeter_EnergyNum++; } }
+  if (powermeter_EnergyNum == 0) { ESP_LOGW(TAG_MB_READ, "--  ⚠️ Energy: none of '%s' is read, integration OFF", CONFIG_PRM_ENERGY_REGISTERS); return; }
+  //..................................................
+  // 2. Checkpoint of NVS: channels are found again by meter & name (a changed register map keeps the rest)
+  //..................................................
+  static powermeter_energy_nvs_t blob;
+  size_t len = sizeof(blob);
+  nvs_handle_t nvs_handle;
+  int restored = 0;
+  esp_err_t err = nvs_open("storage", NVS_READONLY, &nvs_handle);
+  if (err == ESP_ERR_NVS_NOT_FOUND) { ESP_LOGI(TAG_MB_READ, "--  Energy: NO checkpoint in NVS yet, start at 0"); }
+  else if (err != ESP_OK) { ESP_LOGE(TAG_MB_READ, "--  ❌ Energy: NVS NOT opened, checkpoint NOT restored: %s", esp_err_to_name(err)); }
+  if (err == ESP_OK) {
+      if (nvs_get_blob(nvs_handle, PRM_ENERGY_NVS_KEY, &blob, &len) == ESP_OK && blob.magic == PRM_ENERGY_NVS_MAGIC &&
+          blob.num <= PRM_ENERGY_MAX_CH && len == PRM_ENERGY_NVS_LEN(blob.num)) {
+          for (int c = 0; c < powermeter_EnergyNum; c++) {
+              powermeter_energy_ch_t *ch = &powermeter_EnergyCh[c];
+              const powermeter_device_t *dev = &powermeter_Devices[powermeter_RegDevice[ch->cid]];
+              for (int k = 0; k < blob.num; k++) {
+                  if (blob.ch[k].slaveId != dev->slaveId || blob.ch[k].bus != dev->bus ||
+                      strncmp(blob.ch[k].name, powermeter_Regs[ch->cid]->topicName, sizeof(blob.ch[k].name)) != 0) { continue; }
+                  ch->importWh     = blob.ch[k].importWh;
+                  ch->exportWh     = blob.ch[k].exportWh;
+                  ch->gapS         = blob.ch[k].gapS;
+                  ch->meterBaseKWh = blob.ch[k].meterBaseKWh;
+                  powermeter_EnergySavedWh += ch->importWh + ch->exportWh;
+                  restored++;
+                  break; } } }
+      nvs_close(nvs_handle); }
+  powermeter_EnergySaved_us = esp_timer_get_time();
+  powermeter_EnergySaveMutex = xSemaphoreCreateMutex();
+  powermeter_EnergyMutex     = xSemaphoreCreateMutex();
+  esp_register_shutdown_handler(PowerMeter_Energy_Shutdown);           // Last checkpoint before every restart (OTA, reboot button, ...)
+  ESP_LOGI(TAG_MB_READ, "--  ✅ Energy integration of %d power registers ('%s'), %d restored from NVS", 
+           powermeter_EnergyNum, CONFIG_PRM_ENERGY_REGISTERS, restored);
+}
+
+/*--------------------------------------------------------------------------------------------------
+  PowerMeter_Energy_Add: Integrate a read power value (or note the energy register of the meter)
+  used by: PowerMeter_Update_Value
+----------------------------------------------------------------------------------------------------*/
+static void PowerMeter_Energy_Add(int i, float value, int64_t now_us)
+{ if (powermeter_EnergyMutex == NULL || isnan(value)) { return; }
+  int d = powermeter_RegDevice[i];
+  if (i == powermeter_EnergyMeterCid[d]) {                              // Energy register of the meter >> cross-check
+      xSemaphoreTake(powermeter_EnergyMutex, portMAX_DELAY);
+      for (int c = 0; c < powermeter_EnergyNum; c++) {
+          powermeter_energy_ch_t *ch = &powermeter_EnergyCh[c];
+          if (powermeter_RegDevice[ch->cid] != d) { continue; }
+          if (isnan(ch->meterBaseKWh)) { ch->meterBaseKWh = value - ch->importWh / 1000.0; } // Start of the comparison: as if the meter had counted along
+          ch->meterKWh = value; }
+      xSemaphoreGive(powermeter_EnergyMutex);
+      return; }
+  int c = powermeter_EnergyOfCid[i];
+  if (c < 0) { return; }                                                // Not integrated
+  powermeter_energy_ch_t *ch = &powermeter_EnergyCh[c];
+  xSemaphoreTake(powermeter_EnergyMutex, portMAX_DELAY);
+  if (ch->last_us != 0 && now_us > ch->last_us) {
+      double dt_s = (now_us - ch->last_us) / 1e6;
+      if (dt_s <= CONFIG_PRM_ENERGY_MAX_GAP_S) { PowerMeter_Energy_Trapezoid(ch->lastW, value, dt_s, &ch->importWh, &ch->exportWh); }
+      else                                     { ch->gapS += dt_s; } }    // Gap: NOT bridged, only counted
+  ch->lastW   = value;
+  ch->last_us = now_us;
+  xSemaphoreGive(powermeter_EnergyMutex);
+}
+
+/*--------------------------------------------------------------------------------------------------
+  PowerMeter_Energy_Read: Copy of the channels
+  Answer: Number of channels (0 = integration OFF)
+  used by: Task_MQTT_PowerMeter_Publish & Interface_ModbusValues_to_WebServer_SDMValues
+----------------------------------------------------------------------------------------------------*/
+int PowerMeter_Energy_Read(powermeter_energy_ch_t *out)
+{ if (powermeter_EnergyMutex == NULL) { return 0; }
+  xSemaphoreTake(powermeter_EnergyMutex, portMAX_DELAY);
+  memcpy(out, powermeter_EnergyCh, powermeter_EnergyNum * sizeof(out[0]));
+  xSemaphoreGive(powermeter_EnergyMutex);
+  return powermeter_EnergyNum;
+}
+#endif
+
+/*--------------------------------------------------------------------------------------------------
+  PowerMeter_Reg_Hash: Fold ONE register (bus/slave/name) into a FNV-1a hash >> id of a register map
+  used by: PowerMeter_FlashLog_Setup, PowerMeter_SnF_Setup, MQTT_Bin_Schema
+----------------------------------------------------------------------------------------------------*/
+#define PRM_REG_HASH_INIT  (2166136261u)    // Start of the hash (FNV-1a offset)
+static inline uint32_t PowerMeter_Reg_Hash(uint32_t hash, int i)
+{ const powermeter_device_t *dev = &powermeter_Devices[powermeter_RegDevice[i]];
+  char key[48];
+  int len = snprintf(key, sizeof(key), "%u/%u/%s;", dev->bus, dev->slaveId, powermeter_Regs[i]->topicName);
+  for (int k = 0; k < len && k < (int)sizeof(key) - 1; k++) { hash = (hash ^ (uint8_t)key[k]) * 16777619u; }
+  return hash;
+}
+
+#if CONFIG_PRM_FLASH_LOG_ENABLE || CONFIG_PRM_SNF_ENABLE
+/*---------------------------------------------------------------------------------------------------------
+  STORAGE BUDGET: flash log & spill file share the 'storage' partition (LittleFS) with the web files
+  ---------------------------------------------------------------------------------------------------------
+  * The partition is small (partitions.csv). LittleFS needs free blocks for its metadata and copy-on-write:
+    a full partition fails ALL writes (ENOSPC), also the ones of the web files.
+  * Budget = partition - PRM_STORAGE_RESERVE_PCT - the other files (log & spill file stay within their size).
+  * Both get their menuconfig size; if the sum does not fit, both are cut by the same ratio.
+  * HOST target: a directory of the host >> the menuconfig sizes.
+  used by: PowerMeter_FlashLog_Setup & PowerMeter_SnF_Setup
+----------------------------------------------------------------------------------------------------------*/
+#define PRM_FLASH_LOG_DIR       RT_FILES_PATH "/log"     // Folder of the segment files of the flash log
+#define PRM_SNF_FILE            RT_FILES_PATH "/snf.bin" // Spill file of store & forward
+#define PRM_STORAGE_RESERVE_PCT (25)                     // Of the partition, kept free for LittleFS itself
+#if CONFIG_PRM_FLASH_LOG_ENABLE
+#define PRM_FLASH_LOG_WANT      ((size_t)CONFIG_PRM_FLASH_LOG_KB * 1024)
+#else
+#define PRM_FLASH_LOG_WANT      ((size_t)0)
+#endif
+#if CONFIG_PRM_SNF_ENABLE
+#define PRM_SNF_FILE_WANT       ((size_t)CONFIG_PRM_SNF_FILE_KB * 1024)
+#else
+#define PRM_SNF_FILE_WANT       ((size_t)0)
+#endif
+static size_t powermeter_FlashLogMaxBytes = PRM_FLASH_LOG_WANT;  // Max. size of the flash log  (after the budget)
+static size_t powermeter_SnfFileMaxBytes  = PRM_SNF_FILE_WANT;   // Max. size of the spill file (after the budget)
+
+#if !CONFIG_IDF_TARGET_LINUX
+/*--------------------------------
+  Bytes of a file, or of the files of a folder (0 = not there)
+----------------------------------*/ 
+static size_t PowerMeter_Storage_Bytes(const char *path) {
+  struct stat st;
+  if (stat(path, &st) != 0) { return 0; }
+  if (!S_ISDIR(st.st_mode)) { return st.st_size; }
+  size_t bytes = 0;
+  char file[128];
+  struct dirent *e;
+  DIR *d = opendir(path);
+  while (d && (e = readdir(d)) != NULL) {
+      snprintf(file, sizeof(file), "%s/%s", path, e->d_name);
+      if (stat(file, &st) == 0 && S_ISREG(st.st_mode)) { bytes += st.st_size; } }
+  if (d) { closedir(d); }
+  return bytes;
+}
+#endif
+
+/*--------------------------------------------------------------------------------------------------
+  PowerMeter_Storage_Budget: Cut the max. sizes of flash log & spill file to the free space (ONCE)
+----------------------------------------------------------------------------------------------------*/
+static void PowerMeter_Storage_Budget(void) {
+#if !CONFIG_IDF_TARGET_LINUX
+  static bool done = false;
+  if (done) { return; }
+  done = true;
+  size_t total = 0, used = 0;
+  esp_err_t err = esp_littlefs_info("storage", &total, &used);
+  if (err != ESP_OK) {
+      ESP_LOGE(TAG_MB_READ, "--  ❌ Storage: NO LittleFS info (%s) >> flash log & spill file OFF", esp_err_to_name(err));
+      powermeter_FlashLogMaxBytes = powermeter_SnfFileMaxBytes = 0;
+      return; }
+  size_t own     = PowerMeter_Storage_Bytes(PRM_FLASH_LOG_DIR) + PowerMeter_Storage_Bytes(PRM_SNF_FILE);
+  size_t others  = (used > own) ? used - own : 0;                      // Web files, register map, LittleFS metadata
+  size_t reserve = total * PRM_STORAGE_RESERVE_PCT / 100;
+  size_t budget  = (total > others + reserve) ? total - others - reserve : 0;
+  size_t want    = PRM_FLASH_LOG_WANT + PRM_SNF_FILE_WANT;
+  if (want <= budget) {
+      ESP_LOGI(TAG_MB_READ, "--  ✅ Storage: %u kB for flash log & spill file, %u kB wanted", (unsigned)(budget / 1024), (unsigned)(want / 1024));
+      return; }
+  powermeter_FlashLogMaxBytes = (size_t)((uint64_t)budget * PRM_FLASH_LOG_WANT / want);
+  powermeter_SnfFileMaxBytes  = budget - powermeter_FlashLogMaxBytes;
+  ESP_LOGW(TAG_MB_READ, "--  ⚠️ Storage: only %u of %u kB left for flash log & spill file (%u kB partition, %u kB other files) >> cut to %u + %u kB",
+           (unsigned)(budget / 1024), (unsigned)(want / 1024), (unsigned)(total / 1024), (unsigned)(others / 1024),
+           (unsigned)(powermeter_FlashLogMaxBytes / 1024), (unsigned)(powermeter_SnfFileMaxBytes / 1024));
+#endif
+}
+#endif
+
+#if CONFIG_PRM_FLASH_LOG_ENABLE
+/*---------------------------------------------------------------------------------------------------------
+  FLASH LOG of the window statistics: mean, min & max per closed window, survives restarts
+  ---------------------------------------------------------------------------------------------------------
+  * When a tumbling window closes (see WINDOW STATISTICS) ONE record is appended to the log
+    (component TimeSeries_Log): time = end of the window (epoch ms), per register of
+    CONFIG_PRM_FLASH_LOG_REGISTERS (of every meter) 3 columns: mean, min, max (NAN = no value).
+  * Before NTP sync there is no wall-clock time >> NOT logged.
+  * The log collects the records in RAM and writes whole pages to RT_FILES_PATH "/log" (LittleFS);
+    a page is written at least every CONFIG_PRM_FLASH_LOG_FLUSH_MIN and before every restart.
+  * A changed list of registers is another schema: the old log is deleted at the start.
+----------------------------------------------------------------------------------------------------------*/
+#define PRM_FLASH_LOG_MAX_REGS (TS_LOG_MAX_COLS / 3)    // Registers of ONE record (3 columns each)
+
+ts_log_handle_t powermeter_FlashLog = NULL;                             // NULL = no flash log
+static int16_t  powermeter_FlashLogCid[PRM_FLASH_LOG_MAX_REGS];         // Registers of a record
+static int      powermeter_FlashLogNum = 0;                             // Number of them
+static int64_t  powermeter_FlashLogFlushed_us = 0;                      // Time of the last page written
+
+static void PowerMeter_FlashLog_Shutdown(void) { if (powermeter_FlashLog) { TS_Log_Flush(powermeter_FlashLog); } } // Page in RAM would get lost
+
+/*--------------------------------------------------------------------------------------------------
+  PowerMeter_FlashLog_Setup: Find the registers, open (& recover) the log
+  used by: app_main
+----------------------------------------------------------------------------------------------------*/
+void PowerMeter_FlashLog_Setup(void)
+{ char list[] = CONFIG_PRM_FLASH_LOG_REGISTERS;
+  char *rest = list, *name;
+  uint32_t schema = PRM_REG_HASH_INIT;                                  // FNV-1a of the columns: meter & name of each register
+  while ((name = strsep(&rest, ",")) != NULL) {
+      while (*name == ' ') { name++; }
+      for (int i = 0; i < powermeter_NumCids; i++) {
+          if (strcmp(powermeter_Regs[i]->topicName, name) != 0) { continue; }
+          if (powermeter_FlashLogNum >= PRM_FLASH_LOG_MAX_REGS) { ESP_LOGW(TAG_MB_READ, "--  ⚠️ Flash log: max. %d registers, '%s' left out", PRM_FLASH_LOG_MAX_REGS, name); break; }
+          schema = PowerMeter_Reg_Hash(schema, i);
+          powermeter_FlashLogCid[powermeter_FlashLogNum++] = i; } }
+  if (powermeter_FlashLogNum == 0) { ESP_LOGW(TAG_MB_READ, "--  ⚠️ Flash log: none of '%s' is read, log OFF", CONFIG_PRM_FLASH_LOG_REGISTERS); return; }
+  PowerMeter_Storage_Budget();                                          // Max. size that fits the 'storage' partition
+  ts_log_config_t cfg = {
+      .dir           = PRM_FLASH_LOG_DIR,
+      .num_cols      = 3 * powermeter_FlashLogNum,
+      .schema        = schema,
+      .segment_bytes = (size_t)CONFIG_PRM_FLASH_LOG_SEGMENT_KB * 1024,
+      .max_segments  = powermeter_FlashLogMaxBytes / ((size_t)CONFIG_PRM_FLASH_LOG_SEGMENT_KB * 1024) };
+  if (cfg.max_segments < 2) {                                           // Ring needs 2 segments: NEVER more than the budget
+      ESP_LOGE(TAG_MB_READ, "--  ❌ Flash log: %u kB hold NOT 2 segments of %d kB (%s), log OFF", (unsigned)(powermeter_FlashLogMaxBytes / 1024),
+               CONFIG_PRM_FLASH_LOG_SEGMENT_KB, (powermeter_FlashLogMaxBytes < PRM_FLASH_LOG_WANT) ? "free in 'storage'" : "PRM_FLASH_LOG_KB");
+      return; }
+  powermeter_FlashLogMaxBytes = cfg.max_segments * cfg.segment_bytes;  // Whole segments
+  if (TS_Log_Open(&cfg, &powermeter_FlashLog) != ESP_OK) {
+      ESP_LOGE(TAG_MB_READ, "--  ❌ Flash log: can't open '%s', log OFF", PRM_FLASH_LOG_DIR);
+      powermeter_FlashLog = NULL;
+      return; }
+  powermeter_FlashLogFlushed_us = esp_timer_get_time();
+  esp_register_shutdown_handler(PowerMeter_FlashLog_Shutdown);         // Page in RAM to flash before every restart (OTA, reboot button, ...)
+  ESP_LOGI(TAG_MB_READ, "--  ✅ Flash log of %d registers ('%s'), max. %u kB", powermeter_FlashLogNum, CONFIG_PRM_FLASH_LOG_REGISTERS,
+           (unsigned)(powermeter_FlashLogMaxBytes / 1024));
+}
+
+/*--------------------------------------------------------------------------------------------------
+  PowerMeter_FlashLog_Add: ONE record of the window just closed, write the page when due
+  used by: Task_MQTT_PowerMeter_Publish
+----------------------------------------------------------------------------------------------------*/
+static void PowerMeter_FlashLog_Add(const powermeter_stats_result_t *res)
+{ if (powermeter_FlashLog == NULL) { return; }
+  int64_t end_ms = getEpochMs_of_Timer(res->endUs);                    // 0 = no NTP time yet
+  if (end_ms != 0) {
+      float values[TS_LOG_MAX_COLS];
+      for (int k = 0; k < powermeter_FlashLogNum; k++) {
+          const powermeter_window_t *w = &res->last[powermeter_FlashLogCid[k]];
+          values[3 * k]     = w->n ? (float)w->mean : NAN;
+          values[3 * k + 1] = w->n ? w->min : NAN;
+          values[3 * k + 2] = w->n ? w->max : NAN; }
+      TS_Log_Append(powermeter_FlashLog, end_ms, values); }
+  int64_t now_us = esp_timer_get_time();
+  if (now_us - powermeter_FlashLogFlushed_us >= (int64_t)CONFIG_PRM_FLASH_LOG_FLUSH_MIN * 60 * 1000000) { // Page not full, but old enough
+      TS_Log_Flush(powermeter_FlashLog);
+      powermeter_FlashLogFlushed_us = now_us; }
+}
+#endif
+
+/*---------------------------------------------------------------------------------------------------------
+  PowerMeter_Update_Value: Store a new read value & flag it for MQTT if changed significantly
+  ---------------------------------------------------------------------------------------------------------
+  Also sets the next deadline of the register (see 'Modbus_Build_ReadPlan_PowerMeter').
+  used by: Task_Modbus_SDM_Poll_RegisterValues 
+----------------------------------------------------------------------------------------------------------*/
+static void PowerMeter_Update_Value(int i, float value, int64_t now_us) {
+  if (esp_log_level_get(TAG_MB_READ) >= ESP_LOG_DEBUG) {   // Format the value ONLY if the level is on (ESP_LOGD evaluates its arguments anyway)
+      char value_txt[PW_FIXED_MAX];
+      ESP_LOGD(TAG_MB_READ, "--  ✅ Updated %s = %s [%s]", powermeter_Regs[i]->topicName, PW_Fixed_Str(value_txt, value, powermeter_Regs[i]->digits), powermeter_Regs[i]->unitOfValue); }
+  //.......................................................................
+  // CHECK if value has changed significantly and needs re-publish to MQTT
+  //.......................................................................
+  // Is there an not conducted MQTT-Publish alraday? >> Then not check if the value has changed
+  if (!powermeter_Regs[i]->updateMQTT ) // NO former UPDATE PENDING then do it
+  { // Check if the value has changed significantly for MQTT re-publish
+    powermeter_Regs[i]->updateMQTT= (                                             // Set the flag according to the following condition
+        roundf(powermeter_Regs[i]->currVal * powf(10, powermeter_Regs[i]->digits))  // Round the current value
+        !=                                                                           // NOT SAME?
+        roundf(value *  powf(10, powermeter_Regs[i]->digits)));                   // Round the new value
+    if (powermeter_Regs[i]->updateMQTT) { powermeter_Regs[i]->changeSeq++; }       // A NEW change to publish
+    powermeter_Regs[i]->currVal = value;   // Update the current value of the register
+    powermeter_Regs[i]->sample_us = now_us; // ... and when it was acquired
+  }
+  if (powermeter_Regs[i]->failStreak >= MB_BREAKER_THRESHOLD) { // Breaker was open >> close it again
+      ESP_LOGW(TAG_MB_READ, "--  ✅ '%s' answers again, circuit breaker closed", powermeter_Regs[i]->topicName);
+      Modbus_Set_CID_Readable(i, true);                          // Planner may bridge it again
+      powermeter_Regs[i]->updateErrMQTT = true; }
+  powermeter_Regs[i]->failStreak = 0;
+#if CONFIG_PRM_STATS_ENABLE
+  PowerMeter_Stats_Add(i, value, now_us);   // EVERY value counts for the window statistics (also the ones not published)
+#endif
+#if CONFIG_PRM_ENERGY_ENABLE
+  PowerMeter_Energy_Add(i, value, now_us);  // Power registers: integrate to energy
+#endif
+#if CONFIG_PRM_HISTORY_ENABLE
+  if (powermeter_History && !isnan(value)) { TS_Store_Append(powermeter_History, i, now_us / 1000, value); } // History (compressed)
+#endif
+  //.......................................................................
+  // Set NEXT deadline on a fixed grid (multiples of the period) >> drift-free
+  //.......................................................................
+  int64_t period_us = (int64_t)powermeter_Regs[i]->refreshMs * 1000;
+  int64_t due_us = powermeter_Regs[i]->nextDue_us;
+  if (now_us < due_us - (int64_t)MB_SCHED_FOLD_AHEAD_MS * 1000) { return; } // Read for free, long before its deadline >> keep the deadline 
+  cadence_stats_t *st = &powermeter_PollCadence[powermeter_Devices[powermeter_RegDevice[i]].bus];
+  if (due_us != 0) {                                                    // Not the very first read
+      Cadence_Record(st, now_us - due_us);
+      if (now_us - due_us >= period_us) {                               // OVERRUN: whole periods were missed
+          st->overruns++; 
+          st->skipped += (uint32_t)((now_us - due_us) / period_us); } }
+  int64_t base_us = (now_us > due_us) ? now_us : due_us;                // Early read (fold-ahead) >> its deadline counts
+  powermeter_Regs[i]->nextDue_us = (base_us / period_us + 1) * period_us; // Next point of the grid (phase = since boot, also after a back-off)
+}
+
+/*---------------------------------------------------------------------------------------------------------
+  PowerMeter_Register_Failed: Count a failed read of a register & back it off
+  ---------------------------------------------------------------------------------------------------------
+  ONLY for errors of the register itself: a Modbus exception (MB_ERR_EXCEPTION), or its single read fails
+  while others of the block succeed (a meter that does not answer at all is backed off as a whole: PowerMeter_Device_Failed).
+  * Every failure doubles the time until the register is tried again (MB_BACKOFF_BASE_MS .. MB_BACKOFF_MAX_MS).
+  * After MB_BREAKER_THRESHOLD failures in a row the circuit breaker opens: the register is dropped from 
+    the plan for MB_BREAKER_OPEN_MS, then it is tried once again (a success closes the breaker).
+    While open, the planner does not bridge the register with the block reads of its neighbours.
+  So a missing or flaky register does not slow down all the others.
+  used by: Task_Modbus_SDM_Poll_RegisterValues 
+----------------------------------------------------------------------------------------------------------*/
+static void PowerMeter_Register_Failed(int i, esp_err_t err, int64_t now_us) {
+  volatile powermeter_struct *reg = powermeter_Regs[i];
+  int64_t backoff_ms;
+  reg->errCount++;
+  if (reg->failStreak < UINT8_MAX) { reg->failStreak++; }
+  reg->updateErrMQTT = true;
+  if (reg->failStreak >= MB_BREAKER_THRESHOLD) {                  // Persistent failure >> OPEN the breaker
+      backoff_ms = MB_BREAKER_OPEN_MS;
+      if (reg->failStreak == MB_BREAKER_THRESHOLD) {
+          Modbus_Set_CID_Readable(i, false);                      // Keep it out of the gaps of block reads
+          ESP_LOGW(TAG_MB_READ, "--  ⚠️ '%s' failed %d times (%s), circuit breaker open for %d s", 
+                   reg->topicName, MB_BREAKER_THRESHOLD, esp_err_to_name(err), MB_BREAKER_OPEN_MS/1000); }
+  } else {                                                        // Exponential back-off
+      backoff_ms = (int64_t)MB_BACKOFF_BASE_MS << (reg->failStreak - 1);
+      if (backoff_ms > MB_BACKOFF_MAX_MS) { backoff_ms = MB_BACKOFF_MAX_MS; }
+  }
+  reg->nextDue_us = now_us + backoff_ms * 1000;
+}
+
+/*--------------------------------
+  Read of a register missed, because its meter did not answer: counted, but NO back-off of the register
+----------------------------------*/ 
+static inline void PowerMeter_Register_Missed(int i) {
+  powermeter_Regs[i]->errCount++;
+  powermeter_Regs[i]->updateErrMQTT = true;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+  PowerMeter_Device_Failed: The meter did NOT answer (timeout, bus noise) >> back off the whole meter
+  ---------------------------------------------------------------------------------------------------------
+  * Every failure doubles the time until the meter is tried again (MB_BACKOFF_BASE_MS .. MB_DEVICE_BACKOFF_MAX_MS),
+    its registers stay due and are read with the first answer.
+  * NO circuit breaker & NO failure of its registers: a reboot of the meter or a noisy bus must not drop
+    registers from the plan for MB_BREAKER_OPEN_MS.
+  used by: Task_Modbus_SDM_Poll_RegisterValues 
+----------------------------------------------------------------------------------------------------------*/
+static void PowerMeter_Device_Failed(int d, esp_err_t err, int64_t now_us) {
+  powermeter_device_t *dev = &powermeter_Devices[d];
+  if (dev->failStreak < UINT8_MAX) { dev->failStreak++; }
+  int shift = (dev->failStreak <= 8) ? dev->failStreak - 1 : 7;
+  int64_t backoff_ms = (int64_t)MB_BACKOFF_BASE_MS << shift;
+  if (backoff_ms > MB_DEVICE_BACKOFF_MAX_MS) { backoff_ms = MB_DEVICE_BACKOFF_MAX_MS; }
+  dev->backoffUntil_us = now_us + backoff_ms * 1000;
+  ESP_LOGD(TAG_MB_READ, "--  ⚠️ Slave %d does not answer (%s, %d times), next try in %d ms", 
+           dev->slaveId, esp_err_to_name(err), dev->failStreak, (int)backoff_ms);
+}
+
+/*--------------------------------
+  The meter answered: end its back-off
+----------------------------------*/ 
+static inline void PowerMeter_Device_Answered(int d) {
+  powermeter_device_t *dev = &powermeter_Devices[d];
+  if (dev->failStreak == 0) { return; }
+  ESP_LOGW(TAG_MB_READ, "--  ✅ Slave %d answers again (after %d failures)", dev->slaveId, dev->failStreak);
+  dev->failStreak      = 0;
+  dev->backoffUntil_us = 0;
+}
+
+#if CONFIG_PRM_FASTPATH_ENABLE
+/*---------------------------------------------------------------------------------------------------------
+  FAST PATH: A few registers (e.g. 'Power-Total' for zero-export control) polled back-to-back
+  ---------------------------------------------------------------------------------------------------------
+  * The registers named in menuconfig (PRM_FASTPATH_REGISTERS) are read every PRM_FASTPATH_PERIOD_MS on a
+    drift-free grid, in between the block reads of the regular plan (that goes on at its own, lower rate).
+  * Each sample is handed over to 'Task_MQTT_FastPath_Publish' with a queue >> the poll task never waits for MQTT.
+  * Failures count like the ones of the regular reads, a register with OPEN circuit breaker is skipped.
+  used by: Task_Modbus_SDM_Poll_RegisterValues & Task_MQTT_FastPath_Publish
+----------------------------------------------------------------------------------------------------------*/
+#define PRM_FAST_MAX_REGS            (4)       // Max. registers of the fast path (over all meters)
+#define PRM_FAST_QUEUE_LEN           (4)       // Samples waiting to be published, when full the OLDEST is dropped
+
+typedef struct {
+  uint16_t cid;                         // CID of the register
+  char     topic[96];                   // 'Power-Meter/FAST/Power-Total' (with sub-topic of the meter)
+} powermeter_fast_reg_t;
+
+typedef struct {                        // ONE sample of the fast registers of a bus
+  int64_t  sample_us;                   // Acquisition time (esp_timer µs) = answer of the meter received
+  uint8_t  num;                         // Number of values
+  uint8_t  slot[PRM_FAST_MAX_REGS];     // Index in powermeter_FastRegs
+  float    value[PRM_FAST_MAX_REGS];
+} powermeter_fast_sample_t;
+
+typedef struct {                        // Statistics of the fast path (web & MQTT), single words: read without lock
+                                        // COUNTERs written by the poll tasks of ALL buses: atomic increments
+  volatile uint32_t samples;            // COUNTER of samples read
+  volatile uint32_t errors;             // COUNTER of failed reads
+  volatile uint32_t skipped;            // COUNTER of grid slots missed (bus was busy with a regular block)
+  volatile uint32_t dropped;            // COUNTER of samples dropped (MQTT too slow)
+  volatile uint32_t published;          // COUNTER of samples published
+  volatile float    rateHz;             // Achieved sample rate (last second)
+  volatile uint32_t readMs;             // Duration of the last read (request >> answer)
+  volatile uint32_t latMs;              // Latency of the last sample (answer of the meter >> published)
+  volatile uint32_t latMaxMs;           // Max. latency in the last second
+} powermeter_fast_stats_t;
+
+powermeter_fast_reg_t   powermeter_FastRegs[PRM_FAST_MAX_REGS];          // Registers of the fast path
+size_t                  powermeter_FastNum = 0;                          // Number of them
+powermeter_fast_stats_t powermeter_FastStats = { 0 };
+static uint16_t         powermeter_FastOrder[MB_NUM_BUSES][PRM_FAST_MAX_REGS];  // CIDs of each bus (sorted by the planner)
+static mb_block_read_t  powermeter_FastPlan[MB_NUM_BUSES][PRM_FAST_MAX_REGS];   // Block reads of each bus
+static size_t           powermeter_FastNumBlocks[MB_NUM_BUSES] = { 0 };
+static int64_t          powermeter_FastNext_us[MB_NUM_BUSES] = { 0 };   // Next slot on the grid of each bus
+static QueueHandle_t    powermeter_FastQueue = NULL;                    // Poll tasks >> Task_MQTT_FastPath_Publish
+
+/*--------------------------------------------------------------------------------------------------
+  PowerMeter_FastPath_Setup: Find the registers & plan their block reads (after Modbus_Build_ParaDescriptors_PowerMeter)
+----------------------------------------------------------------------------------------------------*/
+void PowerMeter_FastPath_Setup(void)
+{ char names[] = CONFIG_PRM_FASTPATH_REGISTERS;          // 'Power-Total,Power-L1'
+  char *rest = names;
+  for (char *name = strsep(&rest, ","); name != NULL; name = strsep(&rest, ",")) {
+      while (*name == ' ') { name++; }
+      if (*name == '\0') { continue; }
+      bool found = false;
+      for (int i = 0; i < powermeter_NumCids; i++) {    // Same name at several meters >> all of them
+          if (strcmp(powermeter_Regs[i]->topicName, name) != 0) { continue; }
+          found = true;
+          if (powermeter_FastNum >= PRM_FAST_MAX_REGS) { ESP_LOGW(TAG, "--     ⚠️ Fast path: max. %d registers, '%s' left out", PRM_FAST_MAX_REGS, name); break; }
+          const char *dev_topic = powermeter_Devices[powermeter_RegDevice[i]].subTopic;
+          powermeter_fast_reg_t *f = &powermeter_FastRegs[powermeter_FastNum++];
+          f->cid = i;
+          snprintf(f->topic, sizeof(f->topic), "%s/%s/%s%s%s", CONFIG_MQTT_ROOT_TOPIC, CONFIG_PRM_FASTPATH_SUB_TOPIC,
+                   dev_topic, (dev_topic[0] ? "/" : ""), name); }
+      if (!found) { ESP_LOGW(TAG, "--     ⚠️ Fast path: no register '%s'", name); } }
+  for (int bus = 0; bus < MB_NUM_BUSES; bus++) {
+      size_t n = 0;
+      for (size_t k = 0; k < powermeter_FastNum; k++) {
+          if (powermeter_Devices[powermeter_RegDevice[powermeter_FastRegs[k].cid]].bus == bus) { powermeter_FastOrder[bus][n++] = powermeter_FastRegs[k].cid; } }
+      powermeter_FastNumBlocks[bus] = Modbus_Plan_Block_Reads(bus, powermeter_FastOrder[bus], n, powermeter_FastPlan[bus], PRM_FAST_MAX_REGS);
+      if (n) { ESP_LOGI(TAG, "--     ✅ Fast path bus %d: %d registers with %d block reads every %d ms", bus, n, powermeter_FastNumBlocks[bus], CONFIG_PRM_FASTPATH_PERIOD_MS); } }
+  if (powermeter_FastNum) { powermeter_FastQueue = xQueueCreate(PRM_FAST_QUEUE_LEN, sizeof(powermeter_fast_sample_t)); }
+}
+
+static int PowerMeter_FastPath_Slot(uint16_t cid)
+{ for (size_t k = 0; k < powermeter_FastNum; k++) { if (powermeter_FastRegs[k].cid == cid) { return k; } }
+  return 0;
+}
+
+/*--------------------------------------------------------------------------------------------------
+  PowerMeter_FastPath_Poll: Read the fast registers of the bus, if their slot on the grid has come
+  Answer: Time (esp_timer µs) of the next slot
+----------------------------------------------------------------------------------------------------*/
+static int64_t PowerMeter_FastPath_Poll(uint8_t bus, uint16_t *block_regs, float *block_vals)
+{ if (powermeter_FastNumBlocks[bus] == 0) { return INT64_MAX; }
+  int64_t now_us = esp_timer_get_time();
+  if (now_us < powermeter_FastNext_us[bus]) { return powermeter_FastNext_us[bus]; }  // NOT yet
+  //-------------------------------------------------
+  // Next slot on the grid, the slots missed while the bus was busy are skipped (NOT caught up)
+  //-------------------------------------------------
+  int64_t period_us = (int64_t)CONFIG_PRM_FASTPATH_PERIOD_MS * 1000;
+  if (powermeter_FastNext_us[bus] == 0) { powermeter_FastNext_us[bus] = now_us; }  // First slot: start the grid
+  powermeter_FastNext_us[bus] += period_us;
+  if (powermeter_FastNext_us[bus] <= now_us) {
+      int64_t missed = (now_us - powermeter_FastNext_us[bus]) / period_us + 1;
+      __atomic_fetch_add(&powermeter_FastStats.skipped, (uint32_t)missed, __ATOMIC_RELAXED);
+      powermeter_FastNext_us[bus] += missed * period_us; }
+  //-------------------------------------------------
+  // Read the blocks
+  //-------------------------------------------------
+  const uint16_t *order = powermeter_FastOrder[bus];
+  powermeter_fast_sample_t sample = { .num = 0 };
+  for (size_t b = 0; b < powermeter_FastNumBlocks[bus]; b++) {
+      const mb_block_read_t *blk = &powermeter_FastPlan[bus][b];
+      volatile powermeter_struct *first = powermeter_Regs[order[blk->first]];
+      int d = powermeter_RegDevice[order[blk->first]];
+      if (first->failStreak >= MB_BREAKER_THRESHOLD && first->nextDue_us > now_us) { continue; } // Breaker OPEN >> left to the regular plan
+      if (powermeter_Devices[d].backoffUntil_us > now_us) { continue; }                          // Meter does not answer >> backed off
+      int64_t request_us = esp_timer_get_time();
+      esp_err_t err = Modbus_Read_Block(blk, block_regs);
+      int64_t read_us = esp_timer_get_time();
+      powermeter_FastStats.readMs = (read_us - request_us) / 1000;
+      if (err != ESP_OK) {
+          __atomic_fetch_add(&powermeter_FastStats.errors, 1, __ATOMIC_RELAXED);                // Poll tasks of ALL buses count here
+          if (err == MB_ERR_EXCEPTION && blk->num_cids == 1) { PowerMeter_Register_Failed(order[blk->first], err, read_us); continue; } // Exception: THIS register
+          if (err != MB_ERR_EXCEPTION) { PowerMeter_Device_Failed(d, err, read_us); }           // Timeout, noise >> the METER
+          for (int c = blk->first; c < blk->first + blk->num_cids; c++) { PowerMeter_Register_Missed(order[c]); } // Regular plan isolates a bad one
+          continue; }
+      PowerMeter_Device_Answered(d);
+      Modbus_Decode_Floats_CDAB(block_regs, blk->reg_count / 2, block_vals);
+      for (int c = blk->first; c < blk->first + blk->num_cids; c++) {
+          int i = order[c];
+          uint16_t ofs = Modbus_Get_CID_Offset(i, blk);
+          float value = (ofs & 1) ? Modbus_Decode_Float_CDAB(&block_regs[ofs]) : block_vals[ofs / 2];
+          PowerMeter_Update_Value(i, value, read_us);            // Web page & regular MQTT get it as well
+          sample.slot[sample.num]  = PowerMeter_FastPath_Slot(i);
+          sample.value[sample.num] = value;
+          sample.num++; }
+      sample.sample_us = read_us;
+  }
+  //-------------------------------------------------
+  // Hand over to MQTT: a newer sample beats an older one
+  //-------------------------------------------------
+  if (sample.num == 0) { return powermeter_FastNext_us[bus]; }
+  __atomic_fetch_add(&powermeter_FastStats.samples, 1, __ATOMIC_RELAXED);
+  if (xQueueSend(powermeter_FastQueue, &sample, 0) != pdTRUE) {
+      powermeter_fast_sample_t oldest;
+      if (xQueueReceive(powermeter_FastQueue, &oldest, 0) == pdTRUE) { __atomic_fetch_add(&powermeter_FastStats.dropped, 1, __ATOMIC_RELAXED); }
+      xQueueSend(powermeter_FastQueue, &sample, 0); }
+  return powermeter_FastNext_us[bus];
+}
+#endif
+
+/*---------------------------------------------------------------------------------------------------------
+  PowerMeter_Poll_Idle: Sleep until the next register of the bus is due (or the next slot of the fast path)
+  used by: Task_Modbus_SDM_Poll_RegisterValues 
+----------------------------------------------------------------------------------------------------------*/
+static void PowerMeter_Poll_Idle(uint8_t bus, bool after_error, uint16_t *block_regs, float *block_vals) {
+  int64_t next_due = INT64_MAX;                 // Earliest deadline of all registers >> wake up then
+  for (int i = 0; i < powermeter_NumCids; i++) {
+      if (powermeter_Devices[powermeter_RegDevice[i]].bus != bus) { continue; } // Other bus
+      if (PowerMeter_Due_us(i) < next_due) { next_due = PowerMeter_Due_us(i); } }
+  int64_t sleep_us = next_due - esp_timer_get_time();                 // Time until earliest deadline
+  if (after_error || sleep_us < MB_SCHED_MIN_SLEEP_MS * 1000) { sleep_us = MB_SCHED_MIN_SLEEP_MS * 1000; } // Give the bus & other tasks a break
+#if CONFIG_PRM_FASTPATH_ENABLE
+  int64_t fast_us = PowerMeter_FastPath_Poll(bus, block_regs, block_vals) - esp_timer_get_time(); // Fast registers are due earlier?
+  if (fast_us < sleep_us) { sleep_us = (fast_us > 0) ? fast_us : 0; }
+#else
+  (void)block_regs; (void)block_vals;
+#endif
+  int64_t tick_us = (int64_t)portTICK_PERIOD_MS * 1000;
+  vTaskDelay((TickType_t)((sleep_us + tick_us - 1) / tick_us));       // Wait until the deadline (rounded UP to ticks: never too early)
+}
+
 /*================================================================================
    Task_Modbus_SDM_Poll_RegisterValues():
-   Poll the SDM registers and update the values in the powermeter_RegArray
+   Poll the DUE SDM registers and update the values of the meters' registers (powermeter_Devices)
+   ONE task per bus, the bus number is handed over with 'arg'.
    used by: app_main 
 =================================================================================*/
 void Task_Modbus_SDM_Poll_RegisterValues(void *arg) {
+  uint8_t bus = (uint8_t)(uintptr_t)arg;        // Bus polled by THIS task
+  const uint16_t *order = powermeter_ReadOrder[bus];
   float value = 0.0f;                           // Define & Init value to read the register
-  uint8_t type = 0;                             // Define & Init type to read the register
+  uint16_t block_regs[MB_FC04_MAX_REGS];        // Buffer for the registers of ONE block read
+  float    block_vals[MB_FC04_MAX_REGS / 2];    // Decoded floats of ONE block read (register offset / 2)
   esp_err_t err= ESP_OK;                        // Define & Init error code
   int64_t start_time;                           // Define Start time for the task
   int64_t elapsed_time;                         // Define Time spend with reading the registers
+  int regs_read;                                // Number of registers updated in this cycle
   bool flag_Cycle_Read_Error;                   // Error-Flag, when at least one Register fails
+  int retry_budget;                             // Single-register retries left in this cycle
+  esp_err_t cycle_err;                          // First error of the cycle (a later success must not hide it)
+  bool dev_failed[PRM_NUM_DEVICES];             // Per meter: a block failed in this cycle >> skip its other blocks
+  bool dev_polled[PRM_NUM_DEVICES];             // Per meter: at least one block was read in this cycle
+  unsigned long dev_time_ms[PRM_NUM_DEVICES];   // Per meter: bus time in this cycle
   // * COUNTERS                         (never resets)
   //   - powermeter_reads_success       of Successful read cycles
   //   - powermeter_reads_error         of num of times reads with error 
@@ -463,38 +1962,104 @@ void Task_Modbus_SDM_Poll_RegisterValues(void *arg) {
           vTaskDelay(pdMS_TO_TICKS(MB_READ_INTERVAL_MS)); // Just Wait
           continue; }                   // Skip the rest of the loop and check again
       //--------------------------------------------------
-      // START of the cycle
+      // START of the cycle: Plan the DUE registers
       //--------------------------------------------------
       flag_Cycle_Read_Error = false;        // Reset the error flag 
+      cycle_err = ESP_OK;                   // Reset the error of the cycle
+      regs_read = 0;                        // Reset the number of read registers
+      retry_budget = MB_RETRY_BUDGET_PER_CYCLE; // Refill the retry budget
+      memset(dev_failed, 0, sizeof(dev_failed));
+      memset(dev_polled, 0, sizeof(dev_polled));
+      memset(dev_time_ms, 0, sizeof(dev_time_ms));
       start_time = esp_timer_get_time();    // Get the Start-Time of reading in microseconds
+      Modbus_Build_ReadPlan_PowerMeter(bus, start_time); // Which registers are due? >> Block reads
+#if CONFIG_PRM_FASTPATH_ENABLE
+      if (powermeter_NumBlocks[bus] == 0 && powermeter_FastNumBlocks[bus] > 0) { // Woken for the fast path only >> NO regular cycle
+          PowerMeter_Poll_Idle(bus, false, block_regs, block_vals);
+          continue; }
+#endif
       //========================================== 
-      // START CYCLE (loop) through all registers
+      // START CYCLE (loop) through all block reads
       //==========================================
-      for (int i = 0; i < MBREG; i++) { 
-          err = mbc_master_get_parameter(handle_to_Modbus_MasterController, powermeter_param_descriptors[i].cid, (uint8_t*)&value, &type); // Read NEXT register   
+      for (int b = 0; b < powermeter_NumBlocks[bus]; b++) { 
+#if CONFIG_PRM_FASTPATH_ENABLE
+          PowerMeter_FastPath_Poll(bus, block_regs, block_vals);  // Fast registers take turns with the blocks of the plan
+#endif
+          const mb_block_read_t *blk = &powermeter_ReadPlan[bus][b];
+          int d = powermeter_RegDevice[order[blk->first]];  // Meter of this block
+          powermeter_device_t *dev = &powermeter_Devices[d];
+          if (dev_failed[d]) {              // Meter does not answer in this cycle >> don't waste bus time on it (registers stay due)
+              for (int c = blk->first; c < blk->first + blk->num_cids; c++) { PowerMeter_Register_Missed(order[c]); }
+              continue; }
+          int64_t block_start = esp_timer_get_time();
+          err = Modbus_Read_Block(blk, block_regs); // Read NEXT block of registers with ONE request
+          int64_t read_time = esp_timer_get_time();
+          dev_time_ms[d] += (read_time - block_start)/1000;
+          dev_polled[d] = true;
           // Check if the current read was successful
           if (err == ESP_OK ) { 
-              // SUCCESSFUL ✅
-              ESP_LOGD(TAG_MB_READ, "--  ✅ Updated %s = %.2f [%s]", powermeter_RegArray[i].topicName,  value,  powermeter_RegArray[i].unitOfValue);
-              //.......................................................................
-              // CHECK if value has changed significantly and needs re-publish to MQTT
-              //.......................................................................
-              // Is there an not conducted MQTT-Publish alraday? >> Then not check if the value has changed
-              if (!powermeter_RegArray[i].updateMQTT ) // NO former UPDATE PENDING then do it
-              { // Check if the value has changed significantly for MQTT re-publish
-                powermeter_RegArray[i].updateMQTT= (                                             // Set the flag according to the following condition
-                    roundf(powermeter_RegArray[i].currVal * powf(10, powermeter_RegArray[i].digits))  // Round the current value
-                    !=                                                                           // NOT SAME?
-                    roundf(value *  powf(10, powermeter_RegArray[i].digits)));                   // Round the new value
-                powermeter_RegArray[i].currVal = value;   // Update the current value in the powermeter_RegArray
+              // SUCCESSFUL ✅ >> Decode the block in ONE pass, then take ALL registers of the meter within the block,
+              //                  also the NOT due ones (come for free)
+              PowerMeter_Device_Answered(d);
+              Modbus_Decode_Floats_CDAB(block_regs, blk->reg_count / 2, block_vals);
+              for (int i = dev->firstCid; i < dev->firstCid + dev->numRegs && i < powermeter_NumCids; i++) {
+                  uint16_t reg = powermeter_Regs[i]->registerHex;
+                  if (reg < blk->reg_start || reg + PARAM_SIZE_FLOAT/2 > blk->reg_start + blk->reg_count) { continue; } // Not in block
+                  uint16_t ofs = Modbus_Get_CID_Offset(i, blk);          // Register offset in the block
+                  value = (ofs & 1) ? Modbus_Decode_Float_CDAB(&block_regs[ofs]) : block_vals[ofs / 2]; // Odd offset: not in the batch
+                  PowerMeter_Update_Value(i, value, read_time);
+                  regs_read++;
               }
           } else {
               // ERROR ❌ 
+              if (!flag_Cycle_Read_Error) { cycle_err = err; }      // Keep the first error of the cycle
               flag_Cycle_Read_Error = true;                         // Set the error flag
-              powermeter_reads_error++;                             // Increment the error counter
-              ESP_LOGE(TAG_MB_READ, "--  ⚠️ Failed reading CID %d (%s): %s", powermeter_param_descriptors[i].cid, powermeter_RegArray[i].topicName, esp_err_to_name(err) );
-              break;}; // STOP the Cycle, no further register will be read        
+              dev->lastErr = err;
+              ESP_LOGE(TAG_MB_READ, "--  ⚠️ Failed reading block 0x%04X..0x%04X of slave %d (%s, ...): %s", blk->reg_start, blk->reg_start + blk->reg_count - 1,
+                  blk->slave_addr, powermeter_Regs[order[blk->first]]->topicName, esp_err_to_name(err) );
+              if (err == ESP_ERR_TIMEOUT) {                         // Meter does NOT answer at all >> back off the METER, not its registers
+                  dev_failed[d] = true;                             // STOP reading this meter, the other meters go on
+                  PowerMeter_Device_Failed(d, err, read_time);
+                  for (int c = blk->first; c < blk->first + blk->num_cids; c++) { PowerMeter_Register_Missed(order[c]); }
+                  continue; }
+              // Meter answers, but not this block >> Isolate the bad register(s): Retry the due registers one by one
+              int      num_ok = 0, num_exc = 0, num_bad = 0;        // Single reads of the block: succeeded / exception / failed otherwise
+              uint16_t bad[MB_MAX_CIDS];                            // ... the otherwise failed ones: a register error only if others answer
+              esp_err_t bad_err = ESP_OK;
+              for (int c = blk->first; c < blk->first + blk->num_cids; c++) {
+                  int i = order[c];
+                  if (retry_budget <= 0) { break; }                 // Budget used up >> Rest stays due for the next cycle
+                  retry_budget--;
+                  mb_block_read_t single = { .bus = blk->bus, .slave_addr = blk->slave_addr, .reg_start = powermeter_Regs[i]->registerHex,
+                                             .reg_count = PARAM_SIZE_FLOAT/2, .first = c, .num_cids = 1 };
+                  block_start = esp_timer_get_time();
+                  err = Modbus_Read_Block(&single, block_regs);
+                  read_time = esp_timer_get_time();
+                  dev_time_ms[d] += (read_time - block_start)/1000;
+                  if (err == ESP_OK) { PowerMeter_Update_Value(i, Modbus_Decode_Float_CDAB(block_regs), read_time); regs_read++; num_ok++; }
+                  else if (err == MB_ERR_EXCEPTION) { PowerMeter_Register_Failed(i, err, read_time); num_exc++; } // The meter rejects THIS register
+                  else if (err == ESP_ERR_TIMEOUT) { PowerMeter_Register_Missed(i); break; }             // Meter gone in the middle >> see below
+                  else { bad[num_bad++] = i; bad_err = err; }
+              }
+              if (num_ok || num_exc) { PowerMeter_Device_Answered(d); }
+              for (int k = 0; k < num_bad; k++) {                   // Others answered >> the register is bad, else the meter or the bus
+                  if (num_ok || num_exc) { PowerMeter_Register_Failed(bad[k], bad_err, read_time); } else { PowerMeter_Register_Missed(bad[k]); } }
+              if (err == ESP_ERR_TIMEOUT || (num_bad && !num_ok && !num_exc)) { // Meter gone or only noise >> back off the METER
+                  dev_failed[d] = true;
+                  PowerMeter_Device_Failed(d, (err == ESP_ERR_TIMEOUT) ? err : bad_err, read_time); }
+              };
       }; 
+      //------------------------------------------
+      // Statistics per meter
+      //------------------------------------------
+      for (int d = 0; d < PRM_NUM_DEVICES; d++) {
+          if (!dev_polled[d]) { continue; }                         // Nothing was due at this meter
+          powermeter_Devices[d].busTimeMs = dev_time_ms[d];
+          if (dev_failed[d]) { powermeter_Devices[d].readsErr++; }
+          else               { powermeter_Devices[d].readsOk++; powermeter_Devices[d].lastErr = ESP_OK; }
+      }
+      err = cycle_err;                      // The error processing below works on the first error of the cycle
+      xSemaphoreTake(powermeter_CycleMutex, portMAX_DELAY); // Results below are shared by the tasks of all buses
       //==========================================
       // CYCLE END
       //==========================================
@@ -502,6 +2067,7 @@ void Task_Modbus_SDM_Poll_RegisterValues(void *arg) {
       //------------------------------------------
       if (flag_Cycle_Read_Error) {
           // ERROR ❌ 
+          powermeter_reads_error++;                                   // Increment the error counter
           // Check if exactly 'this'-error already occures before?
           if (err!=ErrorCode_RegisterRead) {
               // * NO *  : First time 'this' error occurs
@@ -510,7 +2076,8 @@ void Task_Modbus_SDM_Poll_RegisterValues(void *arg) {
               str_Error_RegisterRead = esp_err_to_name(err);          // Save the error message
               ESP_LOGE(TAG_MB_READ, "--  ❌ NEW Error occoured: %s", str_Error_RegisterRead);
               if (err==ESP_ERR_TIMEOUT) { // Check if the last read was a timeout
-              ESP_LOGE(TAG_MB_READ, "--     >> Consider to increase time-out by using menconfig. Currently is %d ms.", CONFIG_MY_MB_REGISTER_REPONSE_TIMEOUT);
+              ESP_LOGE(TAG_MB_READ, "--     >> Consider to increase time-out by using menconfig. Currently is %"PRIu32" ms (max. %d ms).", 
+                       Modbus_Get_Response_Timeout(bus), CONFIG_MY_MB_REGISTER_REPONSE_TIMEOUT);
               };
 
           } else {
@@ -528,12 +2095,20 @@ void Task_Modbus_SDM_Poll_RegisterValues(void *arg) {
       // Get Cycle time needed to read Registers
       //------------------------------------------
       elapsed_time = (esp_timer_get_time()-start_time)/1000;          // Time spend with reading the registers
-      readDataSetTime = elapsed_time;                                 // Save the time to showed by the WebServer
-      ESP_LOGD(TAG_MB_READ, "--  Needed time to read all registers: %lld ms", elapsed_time);
+      if (regs_read > 0) {                                            // Only cycles that read something
+          readDataSetTime = elapsed_time;                             // Save the time to showed by the WebServer
+          readDataSetRegs = regs_read; }                              // ... and the number of registers read with it
+      PowerMeter_Snapshot_Poll_Results();                             // Hand over the results of THIS cycle to WebServer & MQTT
+      xSemaphoreGive(powermeter_CycleMutex);
+      ESP_LOGD(TAG_MB_READ, "--  Bus %d needed time to read %d due registers with %d blocks: %lld ms", bus, regs_read, powermeter_NumBlocks[bus], elapsed_time);
       //------------------------------------------
-      // Idle to the end of the cycle-time
+      // Adapt the response timeout to the measured latency (only now and then)
+      //------------------------------------------
+      Modbus_Tune_Response_Timeout(bus);
       //------------------------------------------
-      vTaskDelay(pdMS_TO_TICKS(MB_READ_INTERVAL_MS-elapsed_time));    // Wait until start next cycle
+      // Idle until the next register is due
+      //------------------------------------------
+      PowerMeter_Poll_Idle(bus, flag_Cycle_Read_Error, block_regs, block_vals);
     }; // END of the infinite loop
 }; // END of the Task-Function
 
@@ -541,70 +2116,681 @@ void Task_Modbus_SDM_Poll_RegisterValues(void *arg) {
    MQTT   MQTT   MQTT   MQTT   MQTT   MQTT   MQTT   MQTT   MQTT   MQTT   MQTT   MQTT   MQTT   MQTT   MQTT   MQTT   MQTT   MQTT 
 ##################################################################################################################################*/
 
+#if CONFIG_PRM_MQTT_FORMAT_BINARY
+/*---------------------------------------------------------------------------------------------------------
+  BINARY payload of the values: versioned packed struct, little-endian, NO float printing
+  ---------------------------------------------------------------------------------------------------------
+  Every message = ONE head + 'count' x value, same topics as JSON:
+    head  (24 bytes): u8 version | u8 type | u16 count | u32 schema | u32 seq | u32 cycle | i64 ts
+    value ( 8 bytes): u16 id | u16 ageMs | f32 value
+  * type   = 1 value ('<root>/MEA/<name>'), 2 document of the cycle ('<root>/MEA'), 3 replayed value.
+  * schema = hash of the register map: decode only with the schema of the same hash (see SCHEMA below).
+  * ts     = acquisition time of the NEWEST value (epoch ms, 0 = no NTP time), ageMs = how much older
+             the value is (saturates at 65535).
+  * id     = CID of the register in the schema.
+----------------------------------------------------------------------------------------------------------*/
+#define PRM_BIN_VERSION      (1)
+#define PRM_BIN_TYPE_VALUE   (1)
+#define PRM_BIN_TYPE_BATCH   (2)
+#define PRM_BIN_TYPE_REPLAY  (3)
+typedef struct __attribute__((packed)) {
+  uint8_t  version;                     // PRM_BIN_VERSION
+  uint8_t  type;                        // PRM_BIN_TYPE_...
+  uint16_t count;                       // Values behind the head
+  uint32_t schema;                      // Hash of the register map
+  uint32_t seq;                         // Number of the document (0 = single value)
+  uint32_t cycle;                       // Poll cycle of the values (0 = unknown)
+  int64_t  tsMs;                        // Acquisition time of the newest value
+} powermeter_bin_head_t;
+typedef struct __attribute__((packed)) {
+  uint16_t id;                          // CID
+  uint16_t ageMs;                       // tsMs - acquisition time of this value
+  float    value;
+} powermeter_bin_value_t;
+_Static_assert(sizeof(powermeter_bin_head_t) == 24 && sizeof(powermeter_bin_value_t) == 8, "Binary payload layout changed");
+
+static uint32_t powermeter_BinSchema = 0;   // Hash of the register map (0 = not yet known)
+#define MQTT_SCHEMA_TOPIC  "Schema"         // '<root>/PRM/Schema'
+
+/*--------------------------------
+  Hash of the register map (fixed after the start >> computed once)
+----------------------------------*/
+static uint32_t MQTT_Bin_Schema(void) {
+  if (powermeter_BinSchema == 0) {
+      uint32_t schema = PRM_REG_HASH_INIT;
+      for (int i = 0; i < powermeter_NumCids; i++) { schema = PowerMeter_Reg_Hash(schema, i); }
+      powermeter_BinSchema = schema; }
+  return powermeter_BinSchema;
+}
+
+
+/*--------------------------------
+  Head of a binary message
+----------------------------------*/
+static void MQTT_Bin_Head(powermeter_bin_head_t *h, uint8_t type, uint16_t count, uint32_t seq, uint32_t cycle, int64_t ts_ms) {
+  h->version = PRM_BIN_VERSION;
+  h->type    = type;
+  h->count   = count;
+  h->schema  = MQTT_Bin_Schema();
+  h->seq     = seq;
+  h->cycle   = cycle;
+  h->tsMs    = ts_ms;
+}
+
+/*--------------------------------
+  ONE value of a binary message; 'newest_ms' = ts of the head
+----------------------------------*/
+static void MQTT_Bin_Value(powermeter_bin_value_t *v, int i, float value, int64_t sample_ms, int64_t newest_ms) {
+  int64_t age = (sample_ms && newest_ms > sample_ms) ? newest_ms - sample_ms : 0;
+  v->id    = (uint16_t)i;
+  v->ageMs = (uint16_t)(age > UINT16_MAX ? UINT16_MAX : age);
+  v->value = value;
+}
+
+/*---------------------------------------------------------------------------------------------------------
+  SCHEMA of the register map, retained on '<root>/PRM/Schema' (JSON, published once per connection):
+    {"version":1,"schema":3735928559,"registers":[
+       {"id":0,"name":"Power-Total","meter":"","unit":"W","digits":1}, ...]}
+  * Consumers map the 'id' of the binary values to name & unit; 'schema' changes with the register map.
+----------------------------------------------------------------------------------------------------------*/
+
+/** ------------------------------------------------------------------------------------------------
+ * @brief  Publish the schema of the register map (retained), see SCHEMA above.
+ * 
+ * @return     esp_err_t   `ESP_OK` on success, `ESP_ERR_NO_MEM` or `ESP_FAIL` on failure.
+ * @note
+ *   used by `Task_MQTT_PowerMeter_Publish()`.
+ *  -----------------------------------------------------------------------------------------------*/
+esp_err_t MQTT_Publish_PWR_Schema(void) {
+  uint32_t schema = MQTT_Bin_Schema();
+  size_t size = 128 + (size_t)powermeter_NumCids * 128;      // ONE time (per connection) >> heap
+  char *doc = malloc(size);
+  if (doc == NULL) { return ESP_ERR_NO_MEM; }
+  pw_writer_t w;
+  PW_Init(&w, doc, size);
+  PW_Json_Object(&w, NULL);
+  PW_Json_Int(&w, "version", PRM_BIN_VERSION);
+  PW_Json_Int(&w, "schema", schema);
+  PW_Json_Array(&w, "registers");
+  for (int i = 0; i < powermeter_NumCids; i++) {
+      volatile powermeter_struct *reg = powermeter_Regs[i];
+      PW_Json_Object(&w, NULL);
+      PW_Json_Int(&w, "id", i);
+      PW_Json_Str(&w, "name", reg->topicName);
+      PW_Json_Str(&w, "meter", powermeter_Devices[powermeter_RegDevice[i]].subTopic);
+      PW_Json_Str(&w, "unit", reg->unitOfValue);
+      PW_Json_Int(&w, "digits", reg->digits);
+      PW_Json_Close(&w); }
+  PW_Json_Close(&w);
+  PW_Json_Close(&w);
+  if (!PW_Ok(&w)) { free(doc); return ESP_FAIL; }           // Did not fit
+  char topic[96];
+  snprintf(topic, sizeof(topic), "%s/%s/%s", CONFIG_MQTT_ROOT_TOPIC, MQTT_PRM_SUB_TOPIC, MQTT_SCHEMA_TOPIC);
+  int msg_id = esp_mqtt_client_publish(handle_to_MQTT_client, topic, doc, (int)w.len, CONFIG_MQTT_QOS_DEFAULT, 1); // Retained: for consumers coming later
+  free(doc);
+  if (msg_id < 0) { return ESP_FAIL; }
+  ESP_LOGI(TAG_MB_PUBL, "--  ✅ Published schema %08lx of %d registers", (unsigned long)schema, (int)powermeter_NumCids);
+  return ESP_OK;
+}  // END of the MQTT_Publish_PWR_Schema
+#endif
+
 /** ------------------------------------------------------------------------------------------------
  * @brief  Publish the PowerMeter values to MQTT.
  * 
- * Build the MQTT payload from the current values in `powermeter_RegArray` 
+ * Build the MQTT payload from the current values of the registers `powermeter_Regs` 
  * and publish it to the MQTT broker.
  * 
- * @param[in]  i           Index of the public `powermeter_RegArray` to define value to publish.
- * @param[in]  publish_TS  Pointer to a string containing the timestamp of the last update.
+ * @param[in]  i           Index of the CID, see `powermeter_Regs`, to define value to publish.
+ * @param[in]  value       Value to publish (from the snapshot of the publish cycle).
+ * @param[in]  sample_us   Acquisition time of the value (esp_timer µs) >> age of the value.
+ * @param[in]  sample_ms   Acquisition time of the value as wall-clock (epoch ms, 0 = unknown).
  * @return     esp_err_t   Returns the status of the publish operation.
  *                         e.g., `ESP_OK` on success, `ESP_FAIL` on failure, etc.
  * @note
  *   used by `Task_MQTT_PowerMeter_Publish()`.
  *  -----------------------------------------------------------------------------------------------*/
-esp_err_t MQTT_Publish_PWR_Values(int i /* index of arrray */, const char *publish_TS) {
+esp_err_t MQTT_Publish_PWR_Values(int i /* index of arrray */, float value, int64_t sample_us, int64_t sample_ms) {
   int msg_id;                                         // Define & Init message ID
   esp_err_t err= ESP_OK;                              // Define & Init error code
+  volatile powermeter_struct *reg = powermeter_Regs[i];
+#if CONFIG_PRM_MQTT_FORMAT_BINARY
+  /*........................................................................................
+     Build the Payload to be send: head + ONE value (32 bytes), see BINARY above
+  ..........................................................................................*/
+  struct __attribute__((packed)) { powermeter_bin_head_t head; powermeter_bin_value_t v; } msg_bin;
+  MQTT_Bin_Head(&msg_bin.head, PRM_BIN_TYPE_VALUE, 1, 0, 0, sample_ms);
+  MQTT_Bin_Value(&msg_bin.v, i, value, sample_ms, sample_ms);
+  const char *msg_payload = (const char *)&msg_bin;
+  int msg_len = sizeof(msg_bin);
+  (void)sample_us;
+#else
   char msg_payload[256];                              // Define & Init the message to be sent
+  char sample_TS[SHRORT_TS_LEN + 4];                  // Time-Stamp of the acquisition with ms
+  if (sample_ms) { getShortTimesStamp_ms(sample_ms, sample_TS, sizeof(sample_TS)); }
+  else           { strcpy(sample_TS, "-no time-"); }  // No NTP time yet
   /*........................................................................................
      Build the Payload to be send
-     {"value":"0.77","unit":"A","comment":"Current-L3","lastUpdate":"2025-05-14@19:31:24"}
+     {"value":0.77,"unit":"A","comment":"Current-L3","lastUpdate":"2025-05-14@19:31:24.123","ts":1747243884123,"ageMs":312}
+       lastUpdate/ts = when the meter answered (NOT when published), ageMs = age of the value when published
+     The part from 'unit' to 'lastUpdate' is constant: generated (powermeter_RegArray) or joined here (register map file)
   ..........................................................................................*/
-  strcpy(msg_payload, "{\"value\":\"");               // JSON-Value 
-  sprintf(msg_payload+strlen(msg_payload), "%.*f",    // Add Value
-      powermeter_RegArray[i].digits,
-      powermeter_RegArray[i].currVal); 
-  strcat(msg_payload, "\",\"unit\":\"");              // JSON-Unit
-  strcat(msg_payload, powermeter_RegArray[i].unitOfValue); // Add Unit
-  strcat(msg_payload, "\",\"comment\":\"");           // JSON-comment
-  strcat(msg_payload, powermeter_RegArray[i].topicName);   // Add comment
-  strcat(msg_payload, "\",\"lastUpdate\":\"");        // JSON-Last update
-  strcat(msg_payload, publish_TS);                    // Add Last update
-  strcat(msg_payload, "\"}");                         // JSON- closing bracket
+  pw_writer_t w;
+  PW_Init(&w, msg_payload, sizeof(msg_payload));
+  PW_Json_Object(&w, NULL);
+  PW_Json_Fixed(&w, "value", value, reg->digits);     // Value with the digits of the register
+  if (reg->payloadMid) {                              // Unit & comment: generated fragment up to the time-stamp
+      PW_Append_Str(&w, reg->payloadMid);
+      PW_Append_Str(&w, sample_TS);
+      PW_Append(&w, "\"", 1);
+  } else {
+      PW_Json_Str(&w, "unit", reg->unitOfValue);
+      PW_Json_Str(&w, "comment", reg->topicName);
+      PW_Json_Str(&w, "lastUpdate", sample_TS); }     // Last update (acquisition time)
+  PW_Json_Int(&w, "ts", sample_ms);                   // Epoch ms & age
+  PW_Json_Int(&w, "ageMs", (esp_timer_get_time() - sample_us) / 1000);
+  PW_Json_Close(&w);
+  if (!PW_Ok(&w)) { return ESP_FAIL; }
+  int msg_len = (int)w.len;
+#endif
   /*........................................................................................
     Build the Topic
-    'Power-Meter/MEA/Current-L3'
+    'Power-Meter/MEA/Current-L3' or with sub-topic of the meter 'Power-Meter/MEA/Meter-2/Current-L3'
+    Pre-joined (generated) for meters without sub-topic
   ..........................................................................................*/
-  char topic[128];                                    // Define & Init the topic to be sent
-  snprintf(topic, sizeof(topic), "%s/%s/%s",     
+  char topic_buf[128];                                // Topic, when NOT pre-joined
+  const char *dev_topic = powermeter_Devices[powermeter_RegDevice[i]].subTopic; // Sub-Topic of the meter
+  const char *topic = reg->topicFull;
+  if (topic == NULL || dev_topic[0]) {
+      snprintf(topic_buf, sizeof(topic_buf), "%s/%s/%s%s%s",     
          CONFIG_MQTT_ROOT_TOPIC,                      // Root-Topic from MQTT menuconfig
          MQTT_MEASUREMENT_SUB_TOPIC,                  // Sub-Topic for Measurement definend here
-         powermeter_RegArray[i].topicName);           // Topic name from the Measurement
+         dev_topic, (dev_topic[0] ? "/" : ""),        // Sub-Topic of the meter (if any)
+         reg->topicName);                             // Topic name from the Measurement
+      topic = topic_buf; }
   /*........................................................................................
     Publish the message to MQTT
   ..........................................................................................*/
   msg_id = esp_mqtt_client_publish(handle_to_MQTT_client,// MQTT client handle
          topic,                                       // Topic to publish
          msg_payload,                                 // Payload to send
-         0,                                           // Message ID (0 for no response)
+         msg_len,                                     // Length of the payload (0 = string)
          CONFIG_MQTT_QOS_DEFAULT,                     // QoS level
          CONFIG_MQTT_RETAIN_DEFAULT);                 // Retain flag
   if (msg_id >= 0) { // Check if the publish was successful
      err = ESP_OK;
-      ESP_LOGD(TAG_MB_PUBL, "--  ✅ Published '%s' = %.*f[%s] - %s", 
-         powermeter_RegArray[i].topicName, 
-         powermeter_RegArray[i].digits, 
-         powermeter_RegArray[i].currVal,
-         powermeter_RegArray[i].unitOfValue,
-         publish_TS); // Publish the value to MQTT
+      if (esp_log_level_get(TAG_MB_PUBL) >= ESP_LOG_DEBUG) { // Format the value ONLY if the level is on
+          char value_txt[PW_FIXED_MAX];
+          ESP_LOGD(TAG_MB_PUBL, "--  ✅ Published '%s' = %s[%s] - %lld", 
+             powermeter_Regs[i]->topicName, 
+             PW_Fixed_Str(value_txt, value, powermeter_Regs[i]->digits),
+             powermeter_Regs[i]->unitOfValue,
+             (long long)sample_ms); } // Publish the value to MQTT
   }  else { 
       err = ESP_FAIL; 
   } 
   return err;
 }  // END of the MQTT_Publish_PWR_Values
 
+#if CONFIG_PRM_MQTT_MODE_BATCH || CONFIG_PRM_MQTT_MODE_BOTH
+/*---------------------------------------------------------------------------------------------------------
+  BATCH: ONE document per publish cycle with ALL changed values on '<root>/MEA'
+  ---------------------------------------------------------------------------------------------------------
+    {"seq":812,"cycle":40321,"ts":1747243884123,"spanMs":840,"lastUpdate":"2025-05-14@19:31:24.123",
+     "v":{"Power-Total":1234.5,"Current-L1":0.77,"Meter-2/Power-Total":88.0}}
+  * seq    = number of the document (gaps >> documents lost), cycle = poll cycle of the snapshot.
+  * ts     = acquisition time of the NEWEST value, spanMs = how much older the oldest value is.
+  * Keys   = topic name, with the sub-topic of the meter (if any) in front.
+  The values are written behind a reserved room, the envelope is put in front of them when published:
+  NO copy, NO heap. A full document is published and the next one started (same cycle, next seq).
+  With the BINARY format the document is a head + the values, see BINARY (same seq, cycle & ts).
+----------------------------------------------------------------------------------------------------------*/
+#define PRM_BATCH_DOC_BYTES   (3072)    // ONE document
+#define PRM_BATCH_HEAD_BYTES  (160)     // Room for the envelope in front of the values
+typedef struct {
+  uint32_t       seq;                   // Documents published
+  int            num;                   // Values in the document
+  uint16_t       cids[MB_MAX_CIDS];     // Their registers (update flags are reset when published)
+  uint32_t       changeSeqs[MB_MAX_CIDS]; // ... and the change of each (a newer change keeps its flag)
+  int64_t        newestMs;              // Acquisition time of the newest value
+  int64_t        oldestMs;              // ... of the oldest value
+  size_t         len;                   // End of the values in 'doc'
+#if CONFIG_PRM_MQTT_FORMAT_BINARY
+  int64_t        sampleMs[MB_MAX_CIDS]; // Acquisition time of each value (>> ageMs when published)
+#endif
+  char           doc[PRM_BATCH_DOC_BYTES];
+} powermeter_batch_t;
+#if CONFIG_PRM_MQTT_FORMAT_BINARY
+_Static_assert(sizeof(powermeter_bin_head_t) + MB_MAX_CIDS * sizeof(powermeter_bin_value_t) <= PRM_BATCH_DOC_BYTES, "Binary document does not fit");
+#endif
+
+static void MQTT_Batch_Reset(powermeter_batch_t *b) {
+  b->num      = 0;
+  b->newestMs = 0;
+  b->oldestMs = INT64_MAX;
+#if CONFIG_PRM_MQTT_FORMAT_BINARY
+  b->len      = sizeof(powermeter_bin_head_t);
+#else
+  b->len      = PRM_BATCH_HEAD_BYTES;
+#endif
+}
+
+/*--------------------------------
+  Add ONE value of the snapshot; Answer: false = document full (publish it first)
+----------------------------------*/ 
+static bool MQTT_Batch_Add(powermeter_batch_t *b, int i, const powermeter_snapshot_t *snap) {
+  float   value     = snap->values[i];
+  int64_t sample_ms = snap->sampleEpochMs[i];
+#if CONFIG_PRM_MQTT_FORMAT_BINARY
+  if (b->len + sizeof(powermeter_bin_value_t) > sizeof(b->doc)) { return false; }
+  powermeter_bin_value_t v = { .id = (uint16_t)i, .ageMs = 0, .value = value };  // ageMs set when published
+  memcpy(&b->doc[b->len], &v, sizeof(v));
+  b->len += sizeof(v);
+  b->sampleMs[b->num] = sample_ms;
+#else
+  volatile powermeter_struct *reg = powermeter_Regs[i];
+  const char *dev_topic = powermeter_Devices[powermeter_RegDevice[i]].subTopic; // Sub-Topic of the meter
+  pw_writer_t w;                                       // Behind the values, keep room for '}}'
+  PW_Init(&w, &b->doc[b->len], sizeof(b->doc) - 2 - b->len);
+  PW_Append(&w, (b->num ? ",\"" : "\""), (b->num ? 2 : 1));
+  if (dev_topic[0]) { PW_Append_Escaped(&w, dev_topic); PW_Append(&w, "/", 1); }
+  PW_Append_Escaped(&w, reg->topicName);
+  PW_Append(&w, "\":", 2);
+  PW_Append_Fixed(&w, value, reg->digits);
+  if (!PW_Ok(&w)) { return false; }
+  b->len += w.len;
+#endif
+  b->cids[b->num]       = i;
+  b->changeSeqs[b->num++] = snap->changeSeq[i];
+  if (sample_ms > b->newestMs) { b->newestMs = sample_ms; }
+  if (sample_ms && sample_ms < b->oldestMs) { b->oldestMs = sample_ms; }
+  return true;
+}
+
+/** ------------------------------------------------------------------------------------------------
+ * @brief  Publish the batch document of the cycle to MQTT, see BATCH above.
+ * 
+ * @param[in]  b           The document with its values (left empty, for the next one).
+ * @param[in]  cycle       Poll cycle of the snapshot the values are of.
+ * @return     esp_err_t   `ESP_OK` on success (update flags of the values reset), `ESP_FAIL` on failure.
+ * @note
+ *   used by `Task_MQTT_PowerMeter_Publish()`.
+ *  -----------------------------------------------------------------------------------------------*/
+esp_err_t MQTT_Publish_PWR_Batch(powermeter_batch_t *b, uint32_t cycle) {
+  if (b->num == 0) { return ESP_OK; }
+#if CONFIG_PRM_MQTT_FORMAT_BINARY
+  powermeter_bin_head_t head;
+  MQTT_Bin_Head(&head, PRM_BIN_TYPE_BATCH, (uint16_t)b->num, b->seq + 1, cycle, b->newestMs);
+  memcpy(b->doc, &head, sizeof(head));
+  for (int k = 0; k < b->num; k++) {                  // Age of each value vs. the newest one
+      powermeter_bin_value_t *v = (powermeter_bin_value_t *)&b->doc[sizeof(head) + k * sizeof(*v)];
+      MQTT_Bin_Value(v, b->cids[k], v->value, b->sampleMs[k], b->newestMs); }
+  const char *payload = b->doc;
+  int payload_len = (int)b->len;
+#else
+  char head[PRM_BATCH_HEAD_BYTES];
+  char sample_TS[SHRORT_TS_LEN + 4];                  // Time-Stamp of the newest acquisition with ms
+  if (b->newestMs) { getShortTimesStamp_ms(b->newestMs, sample_TS, sizeof(sample_TS)); }
+  else             { strcpy(sample_TS, "-no time-"); } // No NTP time yet
+  pw_writer_t w;
+  PW_Init(&w, head, sizeof(head));
+  PW_Json_Object(&w, NULL);
+  PW_Json_Int(&w, "seq", b->seq + 1);
+  PW_Json_Int(&w, "cycle", cycle);
+  PW_Json_Int(&w, "ts", b->newestMs);
+  PW_Json_Int(&w, "spanMs", (b->newestMs && b->oldestMs != INT64_MAX) ? b->newestMs - b->oldestMs : 0);
+  PW_Json_Str(&w, "lastUpdate", sample_TS);
+  PW_Json_Object(&w, "v");                            // Left open: the values follow
+  if (w.overflow) { MQTT_Batch_Reset(b); return ESP_FAIL; }
+  int n = (int)w.len;
+  char *payload = &b->doc[PRM_BATCH_HEAD_BYTES - n];  // Envelope right in front of the values
+  memcpy(payload, head, n);
+  memcpy(&b->doc[b->len], "}}", 3);
+  int payload_len = (int)(b->len + 2 - (PRM_BATCH_HEAD_BYTES - n));
+#endif
+  char topic[96];
+  snprintf(topic, sizeof(topic), "%s/%s", CONFIG_MQTT_ROOT_TOPIC, MQTT_MEASUREMENT_SUB_TOPIC);
+  int msg_id = esp_mqtt_client_publish(handle_to_MQTT_client, topic, payload, payload_len,
+                                       CONFIG_MQTT_QOS_DEFAULT, CONFIG_MQTT_RETAIN_DEFAULT);
+#if CONFIG_PRM_MQTT_MODE_BATCH                        // Counters of the values: here only when NOT published one by one too
+  if (msg_id < 0) { powermeter_published_error += b->num; }
+  else            { powermeter_published_success += b->num; }
+#endif
+  if (msg_id < 0) {
+      MQTT_Batch_Reset(b);                              // Update flags stay set: the values go with the next document
+      return ESP_FAIL; }
+  for (int k = 0; k < b->num; k++) {                  // Clear ONLY the change published (the poll task may have set a newer one since)
+      volatile powermeter_struct *reg = powermeter_Regs[b->cids[k]];
+      if (reg->updateMQTT && reg->changeSeq == b->changeSeqs[k]) { reg->updateMQTT = false; } }
+  b->seq++;
+  ESP_LOGD(TAG_MB_PUBL, "--  ✅ Published document %lu with %d values (%d bytes)", (unsigned long)b->seq, b->num, payload_len);
+  MQTT_Batch_Reset(b);
+  return ESP_OK;
+}  // END of the MQTT_Publish_PWR_Batch
+#endif
+
+/** ------------------------------------------------------------------------------------------------
+ * @brief  Publish the read errors of ONE PowerMeter register to MQTT.
+ * 
+ * Topic 'Power-Meter/ERR/Current-L3' (with sub-topic of the meter, like the values), payload:
+ *   {"errors":3,"breaker":"closed","comment":"Current-L3","lastUpdate":"2025-05-14@19:31:24"}
+ * 
+ * @param[in]  i           Index of the CID, see `powermeter_Regs`.
+ * @param[in]  snap        Snapshot of the publish cycle.
+ * @param[in]  publish_TS  Pointer to a string containing the timestamp of the publish cycle.
+ * @return     esp_err_t   `ESP_OK` on success, `ESP_FAIL` on failure.
+ * @note
+ *   used by `Task_MQTT_PowerMeter_Publish()`.
+ *  -----------------------------------------------------------------------------------------------*/
+esp_err_t MQTT_Publish_PWR_Errors(int i, const powermeter_snapshot_t *snap, const char *publish_TS) {
+  char msg_payload[160];                              // Define & Init the message to be sent
+  char topic[128];                                    // Define & Init the topic to be sent
+  const char *dev_topic = powermeter_Devices[powermeter_RegDevice[i]].subTopic; // Sub-Topic of the meter
+  pw_writer_t w;
+  PW_Init(&w, msg_payload, sizeof(msg_payload));
+  PW_Json_Object(&w, NULL);
+  PW_Json_Int(&w, "errors", snap->errCount[i]);
+  PW_Json_Str(&w, "breaker", snap->breakerOpen[i] ? "open" : "closed");
+  PW_Json_Str(&w, "comment", powermeter_Regs[i]->topicName);
+  PW_Json_Str(&w, "lastUpdate", publish_TS);
+  PW_Json_Close(&w);
+  if (!PW_Ok(&w)) { return ESP_FAIL; }
+  snprintf(topic, sizeof(topic), "%s/%s/%s%s%s", CONFIG_MQTT_ROOT_TOPIC, MQTT_ERROR_SUB_TOPIC,
+         dev_topic, (dev_topic[0] ? "/" : ""), powermeter_Regs[i]->topicName);
+  int msg_id = esp_mqtt_client_publish(handle_to_MQTT_client, topic, msg_payload, (int)w.len, CONFIG_MQTT_QOS_DEFAULT, CONFIG_MQTT_RETAIN_DEFAULT);
+  if (msg_id < 0) { return ESP_FAIL; }
+  ESP_LOGD(TAG_MB_PUBL, "--  ✅ Published errors of '%s' = %lu", powermeter_Regs[i]->topicName, (unsigned long)snap->errCount[i]);
+  return ESP_OK;
+}  // END of the MQTT_Publish_PWR_Errors
+
+#if CONFIG_PRM_ENERGY_ENABLE
+/** ------------------------------------------------------------------------------------------------
+ * @brief  Publish the integrated energy of ONE power register to MQTT.
+ * 
+ * Topic 'Power-Meter/NRG/Power-Total' (with sub-topic of the meter, like the values), payload:
+ *   {"import":12.345,"export":0.678,"unit":"kWh","gapS":120,"meter":12.301,"deviation":0.36,"lastUpdate":"2025-05-14@19:31:24"}
+ * meter/deviation (%) only for the cross-check channel of a meter with an energy register.
+ * 
+ * @param[in]  ch          The channel, see `PowerMeter_Energy_Read()`.
+ * @param[in]  publish_TS  Pointer to a string containing the timestamp of the publish cycle.
+ * @return     esp_err_t   `ESP_OK` on success, `ESP_FAIL` on failure.
+ * @note
+ *   used by `Task_MQTT_PowerMeter_Publish()`.
+ *  -----------------------------------------------------------------------------------------------*/
+esp_err_t MQTT_Publish_PWR_Energy(const powermeter_energy_ch_t *ch, const char *publish_TS) {
+  char msg_payload[240];                              // Define & Init the message to be sent
+  char topic[128];                                    // Define & Init the topic to be sent
+  const char *dev_topic = powermeter_Devices[powermeter_RegDevice[ch->cid]].subTopic; // Sub-Topic of the meter
+  pw_writer_t w;
+  PW_Init(&w, msg_payload, sizeof(msg_payload));
+  PW_Json_Object(&w, NULL);
+  PW_Json_Fixed(&w, "import", ch->importWh / 1000.0, 3);
+  PW_Json_Fixed(&w, "export", ch->exportWh / 1000.0, 3);
+  PW_Json_Str(&w, "unit", "kWh");
+  PW_Json_Fixed(&w, "gapS", ch->gapS, 0);
+  if (ch->isCheck && !isnan(ch->meterKWh)) {            // Cross-check with the meter
+      double meter_kwh = ch->meterKWh - ch->meterBaseKWh; // Counted by the meter since the start of the accumulators
+      PW_Json_Fixed(&w, "meter", meter_kwh, 3);
+      PW_Json_Fixed(&w, "deviation", (meter_kwh > 0) ? (ch->importWh / 1000.0 - meter_kwh) * 100.0 / meter_kwh : 0.0, 2); }
+  PW_Json_Str(&w, "lastUpdate", publish_TS);
+  PW_Json_Close(&w);
+  if (!PW_Ok(&w)) { return ESP_FAIL; }
+  snprintf(topic, sizeof(topic), "%s/%s/%s%s%s", CONFIG_MQTT_ROOT_TOPIC, MQTT_ENERGY_SUB_TOPIC,
+         dev_topic, (dev_topic[0] ? "/" : ""), powermeter_Regs[ch->cid]->topicName);
+  int msg_id = esp_mqtt_client_publish(handle_to_MQTT_client, topic, msg_payload, (int)w.len, CONFIG_MQTT_QOS_DEFAULT, CONFIG_MQTT_RETAIN_DEFAULT);
+  if (msg_id < 0) { return ESP_FAIL; }
+  ESP_LOGD(TAG_MB_PUBL, "--  ✅ Published energy of '%s' = %.3f / %.3f kWh", powermeter_Regs[ch->cid]->topicName, ch->importWh / 1000.0, ch->exportWh / 1000.0);
+  return ESP_OK;
+}  // END of the MQTT_Publish_PWR_Energy
+#endif
+
+#if CONFIG_PRM_STATS_ENABLE
+/** ------------------------------------------------------------------------------------------------
+ * @brief  Publish the window statistics of ONE PowerMeter register to MQTT.
+ * 
+ * Topic 'Power-Meter/STAT/Power-Total' (with sub-topic of the meter, like the values), payload:
+ *   {"unit":"W","window":60,"n":58,"min":-512,"max":3120,"mean":1022.4,"sd":812.0,"first":980,"last":1002,
+ *    "start":1747243860000,"end":1747243920000,"rolling":{"window":900,"n":871,...,"start":1747243020000}}
+ * start/end = epoch ms of the window (0 = no NTP time yet).
+ * 
+ * @param[in]  i     Index of the CID, see `powermeter_Regs`.
+ * @param[in]  res   Results of the last window close, see `PowerMeter_Stats_Read()`.
+ * @return     esp_err_t   `ESP_OK` on success, `ESP_FAIL` on failure.
+ * @note
+ *   used by `Task_MQTT_PowerMeter_Publish()`.
+ *  -----------------------------------------------------------------------------------------------*/
+esp_err_t MQTT_Publish_PWR_Stats(int i, const powermeter_stats_result_t *res) {
+  char msg_payload[600];                              // Define & Init the message to be sent
+  char topic[128];                                    // Define & Init the topic to be sent
+  volatile powermeter_struct *reg = powermeter_Regs[i];
+  const char *dev_topic = powermeter_Devices[powermeter_RegDevice[i]].subTopic; // Sub-Topic of the meter
+  pw_writer_t w;
+  PW_Init(&w, msg_payload, sizeof(msg_payload));
+  PW_Json_Object(&w, NULL);
+  PW_Json_Str(&w, "unit", reg->unitOfValue);
+  PW_Json_Int(&w, "window", CONFIG_PRM_STATS_WINDOW_S);
+  PowerMeter_Stats_Format(&w, &res->last[i], reg->digits);
+  PW_Json_Int(&w, "start", getEpochMs_of_Timer(res->startUs));
+  PW_Json_Int(&w, "end", getEpochMs_of_Timer(res->endUs));
+  PW_Json_Object(&w, "rolling");
+  PW_Json_Int(&w, "window", (res->endUs - res->rollStartUs) / 1000000);
+  PowerMeter_Stats_Format(&w, &res->roll[i], reg->digits);
+  PW_Json_Int(&w, "start", getEpochMs_of_Timer(res->rollStartUs));
+  PW_Json_Close(&w);
+  PW_Json_Close(&w);
+  if (!PW_Ok(&w)) { ESP_LOGE(TAG_MB_PUBL, "--  ❌ Statistics of '%s' too long", reg->topicName); return ESP_FAIL; }
+  snprintf(topic, sizeof(topic), "%s/%s/%s%s%s", CONFIG_MQTT_ROOT_TOPIC, MQTT_STATS_SUB_TOPIC,
+         dev_topic, (dev_topic[0] ? "/" : ""), reg->topicName);
+  int msg_id = esp_mqtt_client_publish(handle_to_MQTT_client, topic, msg_payload, (int)w.len, CONFIG_MQTT_QOS_DEFAULT, CONFIG_MQTT_RETAIN_DEFAULT);
+  if (msg_id < 0) { return ESP_FAIL; }
+  ESP_LOGD(TAG_MB_PUBL, "--  ✅ Published statistics of '%s' (%lu values)", reg->topicName, (unsigned long)res->last[i].n);
+  return ESP_OK;
+}  // END of the MQTT_Publish_PWR_Stats
+#endif
+
+#if CONFIG_PRM_SNF_ENABLE
+/*---------------------------------------------------------------------------------------------------------
+  STORE & FORWARD of the values while the broker is NOT reachable
+  ---------------------------------------------------------------------------------------------------------
+  * Without MQTT connection the publish task buffers each value it would have published (same PRIO /
+    significant-change rules), with its acquisition time (epoch ms), instead of keeping only the latest.
+  * RAM ring of CONFIG_PRM_SNF_RAM_SAMPLES. A full ring spills as ONE write to RT_FILES_PATH "/snf.bin"
+    (max. CONFIG_PRM_SNF_FILE_KB, cut to the STORAGE BUDGET, kept over a restart). Ring & file full >> the oldest of the ring is dropped
+    (so the start of an outage is kept in the file, its end in RAM).
+  * Connected again: replayed oldest first, max. CONFIG_PRM_SNF_REPLAY_PER_CYCLE per publish cycle, on
+    '<root>/<CONFIG_PRM_SNF_SUB_TOPIC>/[<meter>/]<name>' (NOT retained), payload like the values.
+  * At-least-once: a restart while replaying the file replays it again from its start.
+  * Only the publish task uses the buffer >> no lock (the WebServer reads the counters only).
+----------------------------------------------------------------------------------------------------------*/
+#define PRM_SNF_MAGIC      (0x31464E53)                 // 'SNF1' >> layout of the spill file
+typedef struct {                        // ONE buffered value (16 bytes)
+  int64_t        epochMs;               // Acquisition time (wall-clock)
+  float          value;                 // Value
+  uint16_t       cid;                   // Register
+  uint16_t       reserved;
+} powermeter_snf_sample_t;
+typedef struct {                        // Header of the spill file
+  uint32_t       magic;                 // PRM_SNF_MAGIC
+  uint32_t       mapHash;               // Hash of the registers (CID >> meter & name): other map >> file dropped
+} powermeter_snf_hdr_t;
+typedef struct {                        // COUNTERS since boot (shown on the WebServer)
+  uint32_t       buffered;              // Values buffered
+  uint32_t       replayed;              // Values replayed
+  uint32_t       dropped;               // Values lost (buffer full, no time, file error)
+  uint32_t       spills;                // Writes of the ring to the file
+} powermeter_snf_stats_t;
+
+static powermeter_snf_sample_t *powermeter_SnfRing = NULL;  // RAM ring (heap)
+static size_t                  powermeter_SnfHead = 0;      // Slot of the NEXT buffered value
+static size_t                  powermeter_SnfCount = 0;     // Values in the ring
+static uint32_t                powermeter_SnfFileCount = 0; // Values in the spill file
+static uint32_t                powermeter_SnfFileRead = 0;  // ... of them replayed
+static uint32_t                powermeter_SnfMapHash = 0;   // Hash of the register map
+powermeter_snf_stats_t         powermeter_SnfStats;         // COUNTERS
+#define PRM_SNF_FILE_MAX   ((powermeter_SnfFileMaxBytes > sizeof(powermeter_snf_hdr_t)) ? \
+                            (uint32_t)((powermeter_SnfFileMaxBytes - sizeof(powermeter_snf_hdr_t)) / sizeof(powermeter_snf_sample_t)) : 0) // Values in the file
+
+/** ------------------------------------------------------------------------------------------------
+ * @brief  Publish ONE buffered value to MQTT (replay).
+ * 
+ * Topic 'Power-Meter/REPLAY/Power-Total' (with sub-topic of the meter, like the values), payload like the values:
+ *   {"value":1234.5,"unit":"W","comment":"Power-Total","lastUpdate":"2025-05-14@19:31:24.123","ts":1747243884123,"ageMs":95012}
+ *   or with the BINARY format a value of type 3 (replayed).
+ * NOT retained: the retained message of a topic stays the latest value.
+ * 
+ * @param[in]  s           The buffered value.
+ * @return     esp_err_t   `ESP_OK` on success, `ESP_FAIL` on failure.
+ * @note
+ *   used by `PowerMeter_SnF_Replay()`.
+ *  -----------------------------------------------------------------------------------------------*/
+esp_err_t MQTT_Publish_PWR_Replay(const powermeter_snf_sample_t *s) {
+  char topic[128];                                    // Define & Init the topic to be sent
+  volatile powermeter_struct *reg = powermeter_Regs[s->cid];
+  const char *dev_topic = powermeter_Devices[powermeter_RegDevice[s->cid]].subTopic; // Sub-Topic of the meter
+#if CONFIG_PRM_MQTT_FORMAT_BINARY
+  struct __attribute__((packed)) { powermeter_bin_head_t head; powermeter_bin_value_t v; } msg_bin; // See BINARY
+  MQTT_Bin_Head(&msg_bin.head, PRM_BIN_TYPE_REPLAY, 1, 0, 0, s->epochMs);
+  MQTT_Bin_Value(&msg_bin.v, s->cid, s->value, s->epochMs, s->epochMs);
+  const char *msg_payload = (const char *)&msg_bin;
+  int msg_len = sizeof(msg_bin);
+#else
+  char msg_payload[256];                              // Define & Init the message to be sent
+  char sample_TS[SHRORT_TS_LEN + 4];                  // Time-Stamp of the acquisition with ms
+  int64_t now_ms = getEpochMs_of_Timer(esp_timer_get_time());
+  getShortTimesStamp_ms(s->epochMs, sample_TS, sizeof(sample_TS));
+  pw_writer_t w;
+  PW_Init(&w, msg_payload, sizeof(msg_payload));
+  PW_Json_Object(&w, NULL);
+  PW_Json_Fixed(&w, "value", s->value, reg->digits);
+  PW_Json_Str(&w, "unit", reg->unitOfValue);
+  PW_Json_Str(&w, "comment", reg->topicName);
+  PW_Json_Str(&w, "lastUpdate", sample_TS);
+  PW_Json_Int(&w, "ts", s->epochMs);
+  PW_Json_Int(&w, "ageMs", now_ms ? now_ms - s->epochMs : 0);
+  PW_Json_Close(&w);
+  if (!PW_Ok(&w)) { return ESP_FAIL; }
+  int msg_len = (int)w.len;
+#endif
+  snprintf(topic, sizeof(topic), "%s/%s/%s%s%s", CONFIG_MQTT_ROOT_TOPIC, CONFIG_PRM_SNF_SUB_TOPIC,
+         dev_topic, (dev_topic[0] ? "/" : ""), reg->topicName);
+  int msg_id = esp_mqtt_client_publish(handle_to_MQTT_client, topic, msg_payload, msg_len, CONFIG_MQTT_QOS_DEFAULT, 0);
+  if (msg_id < 0) { return ESP_FAIL; }
+  if (esp_log_level_get(TAG_MB_PUBL) >= ESP_LOG_DEBUG) {   // Format the value ONLY if the level is on
+      char value_txt[PW_FIXED_MAX];
+      ESP_LOGD(TAG_MB_PUBL, "--  ✅ Replayed '%s' = %s - %lld", reg->topicName, PW_Fixed_Str(value_txt, s->value, reg->digits), (long long)s->epochMs); }
+  return ESP_OK;
+}  // END of the MQTT_Publish_PWR_Replay
+
+/*--------------------------------------------------------------------------------------------------
+  PowerMeter_SnF_Setup: RAM ring, spill file of the last run (if it fits the register map)
+  used by: app_main
+----------------------------------------------------------------------------------------------------*/
+void PowerMeter_SnF_Setup(void)
+{ powermeter_SnfRing = calloc(CONFIG_PRM_SNF_RAM_SAMPLES, sizeof(powermeter_snf_sample_t));
+  if (powermeter_SnfRing == NULL) { ESP_LOGE(TAG_MB_PUBL, "--  ❌ Store & forward: no memory, OFF"); return; }
+  powermeter_SnfMapHash = PRM_REG_HASH_INIT;                            // FNV-1a of meter & name of each CID
+  for (int i = 0; i < powermeter_NumCids; i++) { powermeter_SnfMapHash = PowerMeter_Reg_Hash(powermeter_SnfMapHash, i); }
+  PowerMeter_Storage_Budget();                                          // Max. size of the file that fits the 'storage' partition
+  //..................................................
+  // Spill file of the last run: replay what is left (a torn last value is cut off)
+  //..................................................
+  FILE *f = fopen(PRM_SNF_FILE, "rb");
+  if (f) {
+      powermeter_snf_hdr_t hdr;
+      bool ok = fread(&hdr, sizeof(hdr), 1, f) == 1 && hdr.magic == PRM_SNF_MAGIC && hdr.mapHash == powermeter_SnfMapHash
+                && fseek(f, 0, SEEK_END) == 0;
+      long size = ok ? ftell(f) : 0;
+      fclose(f);
+      if (ok && size >= (long)sizeof(hdr)) {
+          powermeter_SnfFileCount = (size - sizeof(hdr)) / sizeof(powermeter_snf_sample_t);
+          if (powermeter_SnfFileCount > PRM_SNF_FILE_MAX) { powermeter_SnfFileCount = PRM_SNF_FILE_MAX; }
+          if (size != (long)(sizeof(hdr) + powermeter_SnfFileCount * sizeof(powermeter_snf_sample_t))) { // Torn write: appending goes on aligned
+              truncate(PRM_SNF_FILE, sizeof(hdr) + powermeter_SnfFileCount * sizeof(powermeter_snf_sample_t)); }
+          if (powermeter_SnfFileCount == 0) { remove(PRM_SNF_FILE); }
+      } else {
+          ESP_LOGW(TAG_MB_PUBL, "!!     ⚠️ Store & forward: '%s' of another register map >> deleted", PRM_SNF_FILE);
+          remove(PRM_SNF_FILE); } }
+  ESP_LOGI(TAG_MB_PUBL, "--  ✅ Store & forward: %d values in RAM, %lu in '%s' (%lu left of the last run)", CONFIG_PRM_SNF_RAM_SAMPLES,
+           (unsigned long)PRM_SNF_FILE_MAX, PRM_SNF_FILE, (unsigned long)powermeter_SnfFileCount);
+}
+
+/*--------------------------------------------------------------------------------------------------
+  PowerMeter_SnF_Spill: The whole ring >> spill file (ONE write), ring empty
+  Answer: false = no room in the file / file error
+----------------------------------------------------------------------------------------------------*/
+static bool PowerMeter_SnF_Spill(void)
+{ if (powermeter_SnfFileCount + powermeter_SnfCount > PRM_SNF_FILE_MAX) { return false; }
+  FILE *f = fopen(PRM_SNF_FILE, powermeter_SnfFileCount ? "ab" : "wb");
+  if (f == NULL) { return false; }
+  bool ok = true;
+  if (powermeter_SnfFileCount == 0) {
+      powermeter_snf_hdr_t hdr = { .magic = PRM_SNF_MAGIC, .mapHash = powermeter_SnfMapHash };
+      ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1; }
+  const size_t n = CONFIG_PRM_SNF_RAM_SAMPLES;
+  size_t oldest = (powermeter_SnfHead + n - powermeter_SnfCount) % n;
+  size_t first  = (oldest + powermeter_SnfCount <= n) ? powermeter_SnfCount : n - oldest; // The ring may wrap: 2 parts
+  ok = ok && fwrite(&powermeter_SnfRing[oldest], sizeof(powermeter_snf_sample_t), first, f) == first;
+  ok = ok && fwrite(&powermeter_SnfRing[0], sizeof(powermeter_snf_sample_t), powermeter_SnfCount - first, f) == powermeter_SnfCount - first;
+  ok = (fclose(f) == 0) && ok;
+  if (!ok) { ESP_LOGE(TAG_MB_PUBL, "--  ❌ Store & forward: can't write '%s'", PRM_SNF_FILE); return false; }
+  powermeter_SnfFileCount += powermeter_SnfCount;
+  powermeter_SnfCount = 0;
+  powermeter_SnfStats.spills++;
+  return true;
+}
+
+/*--------------------------------------------------------------------------------------------------
+  PowerMeter_SnF_Push: Buffer ONE value that can't be published (no MQTT connection)
+  used by: Task_MQTT_PowerMeter_Publish
+----------------------------------------------------------------------------------------------------*/
+static void PowerMeter_SnF_Push(int i, float value, int64_t sample_us, int64_t sample_ms)
+{ if (powermeter_SnfRing == NULL) { return; }
+  if (sample_ms == 0) { sample_ms = getEpochMs_of_Timer(sample_us); }   // NTP time came after the acquisition?
+  if (sample_ms == 0 || isnan(value)) { powermeter_SnfStats.dropped++; return; } // No time: useless for a replay
+  if (powermeter_SnfCount == CONFIG_PRM_SNF_RAM_SAMPLES && !PowerMeter_SnF_Spill()) {
+      powermeter_SnfCount--;                                            // Ring & file full: drop the oldest of the ring
+      powermeter_SnfStats.dropped++; }
+  powermeter_SnfRing[powermeter_SnfHead] = (powermeter_snf_sample_t){ .epochMs = sample_ms, .value = value, .cid = (uint16_t)i };
+  powermeter_SnfHead = (powermeter_SnfHead + 1) % CONFIG_PRM_SNF_RAM_SAMPLES;
+  powermeter_SnfCount++;
+  powermeter_SnfStats.buffered++;
+}
+
+/*--------------------------------------------------------------------------------------------------
+  PowerMeter_SnF_Replay: Publish buffered values, oldest first (file, then ring), rate-limited
+  used by: Task_MQTT_PowerMeter_Publish (connected)
+----------------------------------------------------------------------------------------------------*/
+static void PowerMeter_SnF_Replay(void)
+{ int budget = CONFIG_PRM_SNF_REPLAY_PER_CYCLE;
+  if (powermeter_SnfFileRead < powermeter_SnfFileCount) {
+      FILE *f = fopen(PRM_SNF_FILE, "rb");
+      powermeter_snf_sample_t s;
+      if (f == NULL || fseek(f, sizeof(powermeter_snf_hdr_t) + powermeter_SnfFileRead * sizeof(s), SEEK_SET) != 0) {
+          ESP_LOGE(TAG_MB_PUBL, "--  ❌ Store & forward: can't read '%s', %lu values lost", PRM_SNF_FILE,
+                   (unsigned long)(powermeter_SnfFileCount - powermeter_SnfFileRead));
+          powermeter_SnfStats.dropped += powermeter_SnfFileCount - powermeter_SnfFileRead;
+          powermeter_SnfFileRead = powermeter_SnfFileCount; }
+      else {
+          while (budget > 0 && powermeter_SnfFileRead < powermeter_SnfFileCount && fread(&s, sizeof(s), 1, f) == 1) {
+              if (s.cid < powermeter_NumCids && MQTT_Publish_PWR_Replay(&s) != ESP_OK) { break; } // Try again next cycle
+              powermeter_SnfFileRead++;
+              powermeter_SnfStats.replayed++;
+              budget--; } }
+      if (f) { fclose(f); }
+      if (powermeter_SnfFileRead >= powermeter_SnfFileCount) {      // File done
+          remove(PRM_SNF_FILE);
+          powermeter_SnfFileRead = powermeter_SnfFileCount = 0; } }
+  while (budget > 0 && powermeter_SnfFileCount == 0 && powermeter_SnfCount > 0) { // Then the ring (newer)
+      const size_t n = CONFIG_PRM_SNF_RAM_SAMPLES;
+      const powermeter_snf_sample_t *s = &powermeter_SnfRing[(powermeter_SnfHead + n - powermeter_SnfCount) % n];
+      if (MQTT_Publish_PWR_Replay(s) != ESP_OK) { break; }
+      powermeter_SnfCount--;
+      powermeter_SnfStats.replayed++;
+      budget--; }
+}
+
+static inline uint32_t PowerMeter_SnF_Pending(void) { return powermeter_SnfCount + powermeter_SnfFileCount - powermeter_SnfFileRead; }
+#endif
+
 /** ------------------------------------------------------------------------------------------------
  * @brief  Publish One-Time PowerMeter measure to MQTT.
  * 
@@ -628,11 +2814,13 @@ esp_err_t MQTT_Publish_OneTime_Measure(const char *sub_topic, const char *elemen
      Build the Payload to be send
      {"value":"will be the payload string", "comment":"Last-Boot-Time"}
   ..........................................................................................*/
-  strcpy(msg_payload, "{\"value\":\"");       // JSON-Value
-  strcat(msg_payload, element_payload_str);   // Add the payload string
-  strcat(msg_payload, "\",\"comment\":\"");   // JSON-comment
-  strcat(msg_payload, element_topic);         // Add comment
-  strcat(msg_payload, "\"}");                 // JSON- closing bracket
+  pw_writer_t w;
+  PW_Init(&w, msg_payload, sizeof(msg_payload));
+  PW_Json_Object(&w, NULL);
+  PW_Json_Str(&w, "value", element_payload_str);      // JSON-Value: the payload string
+  PW_Json_Str(&w, "comment", element_topic);          // JSON-comment
+  PW_Json_Close(&w);
+  if (!PW_Ok(&w)) { return ESP_FAIL; }                // Did not fit
   /*........................................................................................
     Build the Topic
     'Power-Meter/<sub_topic>/<element_topic>'
@@ -648,7 +2836,7 @@ esp_err_t MQTT_Publish_OneTime_Measure(const char *sub_topic, const char *elemen
   msg_id = esp_mqtt_client_publish(handle_to_MQTT_client,// MQTT client handle
          topic,                               // Topic to publish
          msg_payload,                         // Payload to send
-         0,                                   // Message ID (0 for no response)
+         (int)w.len,                          // Length of the payload
          CONFIG_MQTT_QOS_DEFAULT,             // QoS level
          CONFIG_MQTT_RETAIN_DEFAULT);         // Retain flag
   if (msg_id >= 0) { // Check if the publish was successful
@@ -675,18 +2863,17 @@ esp_err_t MQTT_publish_ESP_freeHeap() {
   char msg_payload[256];                              // Define & Init the message to be sent
   /*........................................................................................
      Build the Payload to be send
-     {"value":"114488","unit":"byte","comment":"ESP-freeHeap","lastUpdate":"2025-05-14@19:31:24"}
+     {"value":114488,"unit":"byte","comment":"ESP-freeHeap","ESP-uptime":"   0d:01:02:03"}
   ..........................................................................................*/
-  strcpy(msg_payload, "{\"value\":\"");               // JSON-Value 
-  sprintf(msg_payload+strlen(msg_payload), "%ld",      // Add Value: ESP's free heap size
-         esp_get_free_heap_size()); 
-  strcat(msg_payload, "\",\"unit\":\"");              // JSON-Unit
-  strcat(msg_payload, "byte");                        // Add Unit
-  strcat(msg_payload, "\",\"comment\":\"");           // JSON-comment
-  strcat(msg_payload, "ESP-freeHeap");                // Add comment
-  strcat(msg_payload, "\",\"ESP-uptime\":\"");        // JSON-Last update
-  strcat(msg_payload, get_ESP_Uptime());              // Get the ESP uptime as string
-  strcat(msg_payload, "\"}");                         // JSON- closing bracket  
+  pw_writer_t w;
+  PW_Init(&w, msg_payload, sizeof(msg_payload));
+  PW_Json_Object(&w, NULL);
+  PW_Json_Int(&w, "value", esp_get_free_heap_size()); // JSON-Value: ESP's free heap size
+  PW_Json_Str(&w, "unit", "byte");                    // JSON-Unit
+  PW_Json_Str(&w, "comment", "ESP-freeHeap");         // JSON-comment
+  PW_Json_Str(&w, "ESP-uptime", get_ESP_Uptime());    // ESP uptime as string
+  PW_Json_Close(&w);
+  if (!PW_Ok(&w)) { return ESP_FAIL; }                // Did not fit
    /*........................................................................................
     Build the Topic
     'Power-Meter/MEA/ESP_freeHeap'
@@ -702,7 +2889,7 @@ esp_err_t MQTT_publish_ESP_freeHeap() {
   int msg_id = esp_mqtt_client_publish(handle_to_MQTT_client,// MQTT client handle
          topic,                                       // Topic to publish
          msg_payload,                                 // Payload to send
-         0,                                           // Message ID (0 for no response)
+         (int)w.len,                                  // Length of the payload
          CONFIG_MQTT_QOS_DEFAULT,                     // QoS level
          CONFIG_MQTT_RETAIN_DEFAULT);                 // Retain flag
   if (msg_id == 0) { // Check if the publish was successful
@@ -789,10 +2976,125 @@ void Task_MQTT_publish_ESP_freeHeap(void *arg) {
   } // End of the infinite loop 
 } // END of the Task-Function  
 
+/** ------------------------------------------------------------------------------------------------
+ * @brief  Publish cadence statistics (jitter histogram, overruns, skipped cycles) to MQTT.
+ * 
+ * Topic 'Power-Meter/ESP/Timing-Poll', payload:
+ *   {"cycles":1234,"overruns":0,"skipped":0,"maxJitterMs":12.3,"hist":"<1ms:1200 <2ms:30 ... >500ms:0"}
+ * 
+ * @param[in]  name  Element-Topic, e.g. "Timing-Poll".
+ * @param[in]  st    Statistics to publish.
+ * @note
+ *    used by `Task_MQTT_PowerMeter_Publish()`
+ *  -----------------------------------------------------------------------------------------------*/
+esp_err_t MQTT_Publish_Timing(const char *name, const cadence_stats_t *st) {
+  char hist[160];                                     // Histogram as text
+  char msg_payload[300];                              // Define & Init the message to be sent
+  char topic[128];                                    // Define & Init the topic to be sent
+  Cadence_Format_Hist(st, hist, sizeof(hist));
+  pw_writer_t w;
+  PW_Init(&w, msg_payload, sizeof(msg_payload));
+  PW_Json_Object(&w, NULL);
+  PW_Json_Int(&w, "cycles", st->cycles);
+  PW_Json_Int(&w, "overruns", st->overruns);
+  PW_Json_Int(&w, "skipped", st->skipped);
+  PW_Json_Fixed(&w, "maxJitterMs", st->maxJitterUs / 1000.0, 1);
+  PW_Json_Str(&w, "hist", hist);
+  PW_Json_Close(&w);
+  snprintf(topic, sizeof(topic), "%s/%s/%s", CONFIG_MQTT_ROOT_TOPIC, MQTT_ESP_SUB_TOPIC, name);
+  if (!PW_Ok(&w)) { ESP_LOGE(TAG_ESP_PUBL, "--  ❌ '%s' too long", topic); return ESP_FAIL; }
+  int msg_id = esp_mqtt_client_publish(handle_to_MQTT_client, topic, msg_payload, (int)w.len, CONFIG_MQTT_QOS_DEFAULT, CONFIG_MQTT_RETAIN_DEFAULT);
+  if (msg_id < 0) { ESP_LOGE(TAG_ESP_PUBL, "--  ❌ Failed to Publish '%s'", topic); return ESP_FAIL; }
+  return ESP_OK;
+} // END of the MQTT_Publish_Timing
+
+#if CONFIG_PRM_FASTPATH_ENABLE
+/** ------------------------------------------------------------------------------------------------
+ * @brief  TASK-Handler to publish the samples of the fast path at once (low latency).
+ * 
+ * Topic 'Power-Meter/FAST/Power-Total', QoS 0 & NOT retained, payload:
+ *   {"value":-512,"ts":1747243884123,"ageMs":14}
+ * Once per second the achieved sample rate & max. latency are computed.
+ * 
+ * @note
+ *    created by `app_main()`, fed by `PowerMeter_FastPath_Poll()`
+ *  -----------------------------------------------------------------------------------------------*/
+void Task_MQTT_FastPath_Publish(void *arg) {
+  powermeter_fast_sample_t sample;
+  char msg_payload[96];                               // Define & Init the message to be sent
+  uint32_t win_samples = powermeter_FastStats.samples;// Samples at the start of the window
+  uint32_t win_lat_max = 0;                           // Max. latency in the window
+  int64_t  win_start   = esp_timer_get_time();        // Start of the window (1 s)
+  while (1) {
+      if (xQueueReceive(powermeter_FastQueue, &sample, pdMS_TO_TICKS(1000)) == pdTRUE &&
+          is_mqtt_connected() && !is_ota_update_in_progress()) {
+          int64_t sample_ms = getEpochMs_of_Timer(sample.sample_us);
+          for (int k = 0; k < sample.num; k++) {
+              volatile powermeter_struct *reg = powermeter_Regs[powermeter_FastRegs[sample.slot[k]].cid];
+              pw_writer_t w;
+              PW_Init(&w, msg_payload, sizeof(msg_payload));
+              PW_Json_Object(&w, NULL);
+              PW_Json_Fixed(&w, "value", sample.value[k], reg->digits);
+              PW_Json_Int(&w, "ts", sample_ms);
+              PW_Json_Int(&w, "ageMs", (esp_timer_get_time() - sample.sample_us) / 1000);
+              PW_Json_Close(&w);
+              if (!PW_Ok(&w)) { continue; }             // Absurd value: left out
+              esp_mqtt_client_publish(handle_to_MQTT_client, powermeter_FastRegs[sample.slot[k]].topic, msg_payload, (int)w.len,
+                                      0,                // QoS 0: no handshake, lowest latency (a lost sample is replaced by the next)
+                                      0); }             // NOT retained: an old value must not steer the control
+          uint32_t lat_ms = (esp_timer_get_time() - sample.sample_us) / 1000;
+          powermeter_FastStats.latMs = lat_ms;
+          powermeter_FastStats.published++;
+          if (lat_ms > win_lat_max) { win_lat_max = lat_ms; } }
+      //------------------------------------------
+      // Once per second: achieved rate & max. latency
+      //------------------------------------------
+      int64_t now_us = esp_timer_get_time();
+      if (now_us - win_start >= 1000000) {
+          powermeter_FastStats.rateHz   = (powermeter_FastStats.samples - win_samples) * 1e6f / (now_us - win_start);
+          powermeter_FastStats.latMaxMs = win_lat_max;
+          win_samples = powermeter_FastStats.samples;
+          win_lat_max = 0;
+          win_start   = now_us; }
+  }
+}
+
+/** ------------------------------------------------------------------------------------------------
+ * @brief  Publish the statistics of the fast path to MQTT.
+ * 
+ * Topic 'Power-Meter/ESP/FastPath', payload:
+ *   {"rateHz":9.8,"latMs":12,"latMaxMs":31,"readMs":24,"samples":1234,"errors":0,"skipped":3,"dropped":0}
+ * @note
+ *    used by `Task_MQTT_PowerMeter_Publish()`
+ *  -----------------------------------------------------------------------------------------------*/
+esp_err_t MQTT_Publish_FastPath_Stats(void) {
+  char msg_payload[200];                              // Define & Init the message to be sent
+  char topic[128];                                    // Define & Init the topic to be sent
+  const powermeter_fast_stats_t *st = &powermeter_FastStats;
+  pw_writer_t w;
+  PW_Init(&w, msg_payload, sizeof(msg_payload));
+  PW_Json_Object(&w, NULL);
+  PW_Json_Fixed(&w, "rateHz", st->rateHz, 1);
+  PW_Json_Int(&w, "latMs", st->latMs);
+  PW_Json_Int(&w, "latMaxMs", st->latMaxMs);
+  PW_Json_Int(&w, "readMs", st->readMs);
+  PW_Json_Int(&w, "samples", st->samples);
+  PW_Json_Int(&w, "errors", st->errors);
+  PW_Json_Int(&w, "skipped", st->skipped);
+  PW_Json_Int(&w, "dropped", st->dropped);
+  PW_Json_Close(&w);
+  if (!PW_Ok(&w)) { return ESP_FAIL; }
+  snprintf(topic, sizeof(topic), "%s/%s/%s", CONFIG_MQTT_ROOT_TOPIC, MQTT_ESP_SUB_TOPIC, "FastPath");
+  int msg_id = esp_mqtt_client_publish(handle_to_MQTT_client, topic, msg_payload, (int)w.len, CONFIG_MQTT_QOS_DEFAULT, CONFIG_MQTT_RETAIN_DEFAULT);
+  if (msg_id < 0) { ESP_LOGE(TAG_ESP_PUBL, "--  ❌ Failed to Publish '%s'", topic); return ESP_FAIL; }
+  return ESP_OK;
+}
+#endif
+
 /** ------------------------------------------------------------------------------------------------
  * @brief  TASK-Handler to check received PowerMeter-values and publish to MQTT if needed.
  * 
- * This function is called periodically to check the values in `powermeter_RegArray`
+ * This function is called periodically to check the values of the registers `powermeter_Regs`
  * and publish them to MQTT if they have changed significantly.
  * 
  * @note
@@ -806,18 +3108,36 @@ void Task_MQTT_PowerMeter_Publish(void *arg) {
   bool flag_Cycle_Publ_Error;                   // Error-Flag, when at least one Register fails
   u_int8_t counterForNonePrioCycle = CONFIG_MQTT_PUBLISH_NORMAL_FCT-1;  // Init: That means >> First cycle is a NONE-PRIO-Cycle
   char publish_TS[22];                          // Time-Stamp used to publish measurements to MQTT
+  UBaseType_t stack_free_min = UINT32_MAX;      // Lowest high-water mark of the stack so far (bytes never used)
+  static powermeter_snapshot_t snap;            // Values of ONE poll cycle to publish (static: keep it off the task stack)
+#if CONFIG_PRM_ENERGY_ENABLE
+  static powermeter_energy_ch_t energy[PRM_ENERGY_MAX_CH]; // Integrated energy (static: keep it off the task stack)
+#endif
+#if CONFIG_PRM_MQTT_MODE_BATCH || CONFIG_PRM_MQTT_MODE_BOTH
+  static powermeter_batch_t batch;              // ONE document with the changed values of the cycle (static: keep it off the task stack)
+  MQTT_Batch_Reset(&batch);
+#endif
+#if CONFIG_PRM_STATS_ENABLE
+  static powermeter_stats_result_t stats;       // Results of the last window close (static: keep it off the task stack)
+  uint32_t stats_published = 0;                 // Closed windows published so far
+#endif
+#if CONFIG_PRM_MQTT_FORMAT_BINARY
+  bool schema_published = false;                // Schema of the binary values published on this connection?
+#endif
   strcpy(publish_TS, "2020-01-01@00:00:00");    // Init the time-stamp
   // .....................................................................................
   // INITAL wait time until the first publish cycle
   // This is makes sure that there holpefuly PowerMeter-Values are ready to be published
   // .....................................................................................
   vTaskDelay(pdMS_TO_TICKS(CONFIG_MQTT_PUBLISH_INTERVAL_PWR)); // Delay start of endless loop for 1x the publish interval
+  int64_t next_us = esp_timer_get_time();       // Deadline of the cycle: fixed grid from here on (drift-free)
   while (1) { // Infinite loop of this task
       //--------------------------------------------------
       // If OTA is in progress, just do nothing and wait
       //--------------------------------------------------
       if (is_ota_update_in_progress()) { // Check if an OTA update is in progress
           vTaskDelay(pdMS_TO_TICKS(CONFIG_MQTT_PUBLISH_INTERVAL_PWR)); // Just wait for reboot of failed OTA
+          next_us = esp_timer_get_time();                              // Restart the grid (no overrun)
           continue; }                    // Skip the rest of the loop and check again
       //--------------------------------------------------
       // START of the cycle
@@ -825,6 +3145,11 @@ void Task_MQTT_PowerMeter_Publish(void *arg) {
       start_time = esp_timer_get_time();        // Get the Start-Time of reading in microseconds
       flag_Cycle_Publ_Error = false;            // Reset the error flag 
       getShortTimesStamp(publish_TS, sizeof(publish_TS)); // Generate the time-stamp used when publishing measurements to MQTT in this cycle
+      PowerMeter_Snapshot_Read(&snap);          // Coherent values of the last poll cycle
+#if CONFIG_PRM_MQTT_FORMAT_BINARY
+      if (!is_mqtt_connected()) { schema_published = false; }    // Publish it again after a reconnect (broker may have lost it)
+      else if (!schema_published) { schema_published = (MQTT_Publish_PWR_Schema() == ESP_OK); }
+#endif
       // Determine if next is as NORMAL-Cycle to publish ALL Registers including without PRIO
       counterForNonePrioCycle++;                // Increment Cycle-counter PRIO's
       isNonePrioCycle = (counterForNonePrioCycle >= CONFIG_MQTT_PUBLISH_NORMAL_FCT); // Check if this is a NONE-PRIO-Cycle
@@ -839,34 +3164,87 @@ void Task_MQTT_PowerMeter_Publish(void *arg) {
       //========================================== 
       // START CYCLE (loop) through ALL registers
       //==========================================
-      for (int i = 0; i < MBREG; i++) { 
+      for (int i = 0; i < powermeter_NumCids; i++) { 
           // For EACH SDM Value
           //........................
+          // Read errors changed? (published with the NONE-PRIO-Cycle)
+          //........................
+          if (isNonePrioCycle && powermeter_Regs[i]->updateErrMQTT) {
+              if (MQTT_Publish_PWR_Errors(i, &snap, publish_TS) == ESP_OK) { powermeter_Regs[i]->updateErrMQTT = false; } 
+              else { ESP_LOGE(TAG_MB_PUBL, "--  ❌ Failed to Publish Errors of = '%s'", powermeter_Regs[i]->topicName); } }
+          //........................
           // Check SKIPP conditions
           //........................
           // NOT a NONE-PRIO-Cycle but Register not have set the .hasPrio-Flag?
-          if (!isNonePrioCycle && !powermeter_RegArray[i].hasPrio) { continue; } // SKIP this register as it has no PRIO-Flag
+          if (!isNonePrioCycle && !powermeter_Regs[i]->hasPrio) { continue; } // SKIP this register as it has no PRIO-Flag
           // Value not changed significantly changed from last publish?
-          if (!powermeter_RegArray[i].updateMQTT) { continue; }                  // SKIP this register as it has no update-Flag
+          if (!PowerMeter_Snapshot_Update_Pending(i, &snap)) { continue; }    // SKIP: no update-Flag in the snapshot (a change after it: next cycle)
+#if CONFIG_PRM_SNF_ENABLE
+          if (!is_mqtt_connected()) {                                         // Broker NOT reachable: buffer the value for a replay
+              PowerMeter_SnF_Push(i, snap.values[i], snap.sampleUs[i], snap.sampleEpochMs[i]);
+              powermeter_Regs[i]->updateMQTT = false;                         // Buffered = the change of the snapshot (pending checked above); next change is buffered too
+              flag_Cycle_Publ_Error = true;                                   // NOT published (yet)
+              continue; }
+#endif
           // ........................................................
           // PUBLISH-Section 
           // ........................................................
           //    only reached if conctions above not lead to > 'SKIP'
           // ........................................................
-          err = MQTT_Publish_PWR_Values(i, publish_TS); // Publish the value to MQTT
+#if CONFIG_PRM_MQTT_MODE_BATCH || CONFIG_PRM_MQTT_MODE_BOTH
+          if (!MQTT_Batch_Add(&batch, i, &snap)) {                             // Document full: publish it, start the next
+              if (MQTT_Publish_PWR_Batch(&batch, snap.cycle) != ESP_OK) { flag_Cycle_Publ_Error = true; }
+              MQTT_Batch_Add(&batch, i, &snap); }
+#endif
+#if CONFIG_PRM_MQTT_MODE_BATCH
+          continue;                                                           // Update flag is reset when the document is published
+#else
+          err = MQTT_Publish_PWR_Values(i, snap.values[i], snap.sampleUs[i], snap.sampleEpochMs[i]); // Publish the value to MQTT
+#endif
           // Check if the publish was successful
           if (err == ESP_OK ) { 
               // SUCCESSFUL ✅
-              powermeter_RegArray[i].updateMQTT= false; // Reset the update-Flag
+              powermeter_Regs[i]->updateMQTT= false; // Reset the update-Flag
               // Log-Message on sucess is integrated in the Publish-SDM-Function
               powermeter_published_success++;                              // Increment counter
           } else {
               // ERROR ❌ 
               powermeter_published_error++;                                // Increment counter
-              ESP_LOGE(TAG_MB_PUBL, "--  ❌ Failed to Publish Value of = '%s'", powermeter_RegArray[i].topicName);
+              ESP_LOGE(TAG_MB_PUBL, "--  ❌ Failed to Publish Value of = '%s'", powermeter_Regs[i]->topicName);
               flag_Cycle_Publ_Error = true;                         // Set the error flag
           };      
       }; 
+#if CONFIG_PRM_MQTT_MODE_BATCH || CONFIG_PRM_MQTT_MODE_BOTH
+      //------------------------------------------
+      // ONE document with ALL changed values of the cycle
+      //------------------------------------------
+      if (MQTT_Publish_PWR_Batch(&batch, snap.cycle) != ESP_OK) {
+          ESP_LOGE(TAG_MB_PUBL, "--  ❌ Failed to Publish the document of the cycle");
+          flag_Cycle_Publ_Error = true; }
+#endif
+#if CONFIG_PRM_SNF_ENABLE
+      //------------------------------------------
+      // Connected again? >> Replay the buffered values (rate-limited, after the current ones)
+      //------------------------------------------
+      if (PowerMeter_SnF_Pending() && is_mqtt_connected()) { PowerMeter_SnF_Replay(); }
+#endif
+#if CONFIG_PRM_STATS_ENABLE
+      //------------------------------------------
+      // Window closed? >> Publish the statistics of ALL registers ONCE
+      //------------------------------------------
+      PowerMeter_Stats_Tick();                  // Close the window also when no value came in
+      if (powermeter_StatsResult.closed != stats_published && PowerMeter_Stats_Read(&stats) != stats_published) {
+          for (int i = 0; i < powermeter_NumCids; i++) {
+              if (stats.last[i].n == 0 && stats.roll[i].n == 0) { continue; } // Never read
+              if (MQTT_Publish_PWR_Stats(i, &stats) != ESP_OK) {
+                  ESP_LOGE(TAG_MB_PUBL, "--  ❌ Failed to Publish Statistics of = '%s'", powermeter_Regs[i]->topicName);
+                  flag_Cycle_Publ_Error = true; } }
+          stats_published = stats.closed;
+#if CONFIG_PRM_FLASH_LOG_ENABLE
+          PowerMeter_FlashLog_Add(&stats);      // Mean, min & max of the window >> log on flash
+#endif
+      }
+#endif
       //==========================================
       // CYCLE END
       //==========================================
@@ -882,6 +3260,9 @@ void Task_MQTT_PowerMeter_Publish(void *arg) {
           // SUCCESS ✅ 
           strcpy(powermeter_PublishSuccess_TS, publish_TS);   // Save the time-stamp of last successful publish
       };
+      xSemaphoreTake(powermeter_CycleMutex, portMAX_DELAY);
+      PowerMeter_Snapshot_Publish_Results();                  // Hand over the results to the WebServer
+      xSemaphoreGive(powermeter_CycleMutex);
       //-----------------------------------------------
       // Get Cycle time needed to re-publish Registers
       //-----------------------------------------------       
@@ -889,9 +3270,34 @@ void Task_MQTT_PowerMeter_Publish(void *arg) {
       publishDataSetTime = elapsed_time;                            // Save the time to showed by the WebServer
       ESP_LOGD(TAG, "--  Needed time to re-Publish all registers: %lld ms", elapsed_time);   
       //------------------------------------------
-      // Idle to the end of the cycle-time
+      // Publish the timing statistics (with NONE-PRIO-Cycle)
+      //------------------------------------------
+      if (isNonePrioCycle) {
+          MQTT_Publish_Timing("Timing-Poll",    &snap.pollCadence);
+          MQTT_Publish_Timing("Timing-Publish", &powermeter_PublCadence);
+#if CONFIG_PRM_FASTPATH_ENABLE
+          if (powermeter_FastNum) { MQTT_Publish_FastPath_Stats(); }
+#endif
+#if CONFIG_PRM_ENERGY_ENABLE
+          int num_energy = PowerMeter_Energy_Read(energy);
+          for (int c = 0; c < num_energy; c++) {
+              if (MQTT_Publish_PWR_Energy(&energy[c], publish_TS) != ESP_OK) { 
+                  ESP_LOGE(TAG_MB_PUBL, "--  ❌ Failed to Publish Energy of = '%s'", powermeter_Regs[energy[c].cid]->topicName); } }
+          PowerMeter_Energy_Checkpoint(false);  // To NVS, when due
+#endif
+      }
+      //------------------------------------------
+      // Stack: bytes never used so far (new low >> logged, too low >> warning)
+      //------------------------------------------
+      UBaseType_t stack_free = uxTaskGetStackHighWaterMark(NULL);
+      if (stack_free < stack_free_min) {
+          stack_free_min = stack_free;
+          if (stack_free < PRM_PUBLISH_STACK_WARN_BYTES) { ESP_LOGW(TAG_MB_PUBL, "--  ⚠️ Publish task: only %u of %d bytes stack left", (unsigned)stack_free, PRM_PUBLISH_STACK_BYTES); }
+          else { ESP_LOGD(TAG_MB_PUBL, "--  Publish task: %u of %d bytes stack never used", (unsigned)stack_free, PRM_PUBLISH_STACK_BYTES); } }
+      //------------------------------------------
+      // Idle to the next deadline of the grid (overruns skip periods)
       //------------------------------------------
-      vTaskDelay(pdMS_TO_TICKS(CONFIG_MQTT_PUBLISH_INTERVAL_PWR-elapsed_time)); // Wait until start next cycle
+      Cadence_Wait_Next(&powermeter_PublCadence, &next_us, (int64_t)CONFIG_MQTT_PUBLISH_INTERVAL_PWR * 1000); // Wait until start next cycle
   } // END of the infinite loop
 } // END of the Task-Function
 
@@ -1003,48 +3409,179 @@ void Task_is_webserver_connection_loss_then_reboot(void *arg) {
   used by: Handle_WebServer_SDM_Values_PUT
 * Updates all values of the selected SDM registers and others @Website of WebServer
 =================================================================================*/
+#define PRM_XML_TAG_OPEN(idx, open, close)  open,
+#define PRM_XML_TAG_CLOSE(idx, open, close) close,
+static const char *const powermeter_XmlTagOpen[PRM_GEN_NUM_XML_TAGS]  = { PRM_GEN_XML_TAGS(PRM_XML_TAG_OPEN) };  // '<response0>' ..
+static const char *const powermeter_XmlTagClose[PRM_GEN_NUM_XML_TAGS] = { PRM_GEN_XML_TAGS(PRM_XML_TAG_CLOSE) }; // '</response0>' ..
+_Static_assert(PRM_GEN_NUM_XML_TAGS >= MB_MAX_CIDS, "Generate more XML tags (gen_register_tables.py: XML_TAGS)");
+#define PRM_XML_BYTES_FIXED    (4096)   // Size of the XML answer: common part
+#define PRM_XML_BYTES_PER_REG  (512)    // ... per register
+#define PRM_XML_BYTES_PER_DEV  (384)    // ... per meter
 static char* Interface_ModbusValues_to_WebServer_SDMValues() {
     ESP_LOGD(TAG, "--  BUILD answer:");
-    char *xml = NULL; // Declares a empty Pointer for the XML string     
+    size_t xml_size = PRM_XML_BYTES_FIXED + powermeter_NumCids * PRM_XML_BYTES_PER_REG + PRM_NUM_DEVICES * PRM_XML_BYTES_PER_DEV;
+    char *xml = malloc(xml_size); // ONE buffer for the XML string (written by the payload writer)
+    powermeter_snapshot_t *snap = malloc(sizeof(powermeter_snapshot_t)); // ALL values of ONE poll cycle
+    if (xml == NULL || snap == NULL) { free(xml); free(snap); return NULL; }
+    pw_writer_t w;
+    PW_Init(&w, xml, xml_size);
+    PowerMeter_Snapshot_Read(snap);
+#if CONFIG_PRM_STATS_ENABLE
+    powermeter_stats_result_t *stats = malloc(sizeof(powermeter_stats_result_t)); // Last closed window of ALL registers
+    if (stats == NULL) { free(snap); free(xml); return NULL; }
+    PowerMeter_Stats_Read(stats);
+#endif
+    int64_t now_us = esp_timer_get_time();              // >> Age of the values
+    char sample_TS[SHRORT_TS_LEN + 4];                  // Acquisition time with ms
     // Open XML-Tag 
     ESP_LOGD(TAG, "--   (1) Start: With openig TAG <xml>"); 
-    Helper_AppendTo_String(&xml, "<xml>"); // Start with opening tag
+    PW_Appendf(&w, "<xml>"); // Start with opening tag
     // Add measured electrical values to response
     ESP_LOGD(TAG, "--   (2) Add: Frequent measured electrical values");
-    for (int i = 0; i < MBREG; i++) {
-        Helper_AppendTo_String(&xml, "<response%d>" , i);                             // TAG opening <response%d> 
-        Helper_AppendTo_String(&xml, "%.*f", powermeter_RegArray[i].digits, powermeter_RegArray[i].currVal ); // SMD Resigter Value WITH right Digits
-        Helper_AppendTo_String(&xml, "</response%d>", i);                             // TAG closing <response%d> 
+    for (int i = 0; i < powermeter_NumCids; i++) {
+        PW_Append_Str(&w, powermeter_XmlTagOpen[i]);                                  // TAG <response%d> (generated)
+        PW_Append_Fixed(&w, snap->values[i], powermeter_Regs[i]->digits);            // SMD Resigter Value WITH right Digits
+        PW_Append_Str(&w, powermeter_XmlTagClose[i]);
+        PW_Appendf(&w, "<rerr%d>%lu</rerr%d>", i, (unsigned long)snap->errCount[i], i); // Read errors of the register
+        PW_Appendf(&w, "<rbrk%d>%d</rbrk%d>",  i, snap->breakerOpen[i], i);             // 1 = Circuit breaker open
+        if (snap->sampleEpochMs[i]) { getShortTimesStamp_ms(snap->sampleEpochMs[i], sample_TS, sizeof(sample_TS)); }
+        else                        { strcpy(sample_TS, "-"); }
+        PW_Appendf(&w, "<rts%d>%s</rts%d>",    i, sample_TS, i);                        // Acquisition time of the value
+        PW_Appendf(&w, "<rage%d>%lld</rage%d>", i, snap->sampleUs[i] ? (long long)((now_us - snap->sampleUs[i]) / 1000) : -1LL, i); // Age in ms (-1 = never read)
+        PW_Appendf(&w, "<rname%d>%s</rname%d>", i, powermeter_Regs[i]->topicName, i);   // Name & unit of the register (register map)
+        PW_Appendf(&w, "<runit%d>%s</runit%d>", i, powermeter_Regs[i]->unitOfValue, i);
+#if CONFIG_PRM_STATS_ENABLE
+        if (stats->last[i].n) {                                                                       // Min / mean / max of the last window
+            PW_Appendf(&w, "<rstat%d>", i);
+            PW_Append_Fixed(&w, stats->last[i].min, powermeter_Regs[i]->digits);
+            PW_Append(&w, " / ", 3);
+            PW_Append_Fixed(&w, stats->last[i].mean, powermeter_Regs[i]->digits);
+            PW_Append(&w, " / ", 3);
+            PW_Append_Fixed(&w, stats->last[i].max, powermeter_Regs[i]->digits);
+            PW_Appendf(&w, "</rstat%d>", i); }
+        else { PW_Appendf(&w, "<rstat%d>-</rstat%d>", i, i); }
+#endif
     }
     // Add Meta-data & others to response
     ESP_LOGD(TAG, "--   (3) Add: Meta Data of measuments & others");
+    PW_Appendf(&w, "<numregs>%d</numregs>", (int)powermeter_NumCids);     // Number of registers          </numregs>"
+    PW_Appendf(&w, "<regmap>%s</regmap>",   powermeter_RegMapSource);       // Source of the register sets  </regmap>"
     // TITLE with PowerMeter-Name
-    Helper_AppendTo_String(&xml, "<prmname>%s</prmname>", PRM_Name);                       // Write PowerMeter- Name      </prmname>"
+    PW_Appendf(&w, "<prmname>%s</prmname>", PRM_Name);                       // Write PowerMeter- Name      </prmname>"
     // MODBUS
-    Helper_AppendTo_String(&xml, "<sdmcnt>%d</sdmcnt>",    powermeter_reads_success);     // Counts sucess                </sdmcnt>" 
-    Helper_AppendTo_String(&xml, "<errtotal>%d</errtotal>",powermeter_reads_error);       // Counts error                 </errtotal>"
-    Helper_AppendTo_String(&xml, "<timest>%s</timest>",    powermeter_SuccessUpdateDS_TS);// Last successful time-stamp  </timest>"
-    Helper_AppendTo_String(&xml, "<errorts>%s</errorts>",  powermeter_ErrorRead_TS);      // Last error time-stamp        </errorts>"
-    Helper_AppendTo_String(&xml, "<lasterrtxt>%s</lasterrtxt>", str_Error_RegisterRead);  // Last 'this' error time-st.   </lasterrtxt>"
+    PW_Appendf(&w, "<cycle>%lu</cycle>",     (unsigned long)snap->cycle);   // Poll cycle of ALL values     </cycle>"
+    PW_Appendf(&w, "<sdmcnt>%lu</sdmcnt>",   (unsigned long)snap->readsSuccess); // Counts sucess           </sdmcnt>" 
+    PW_Appendf(&w, "<errtotal>%lu</errtotal>",(unsigned long)snap->readsError);  // Counts error            </errtotal>"
+    PW_Appendf(&w, "<timest>%s</timest>",    snap->successTS);              // Last successful time-stamp  </timest>"
+    PW_Appendf(&w, "<errorts>%s</errorts>",  snap->errorTS);                // Last error time-stamp        </errorts>"
+    PW_Appendf(&w, "<lasterrtxt>%s</lasterrtxt>", snap->lastErrTxt);        // Last 'this' error time-st.   </lasterrtxt>"
+    // MODBUS per meter
+    PW_Appendf(&w, "<devices>%d</devices>",  (int)PRM_NUM_DEVICES);            // Number of meters             </devices>"
+    for (int d = 0; d < PRM_NUM_DEVICES; d++) {
+        PW_Appendf(&w, "<dev%dname>%s (ID %d)</dev%dname>", d, powermeter_Devices[d].model, powermeter_Devices[d].slaveId, d); // Name & Slave ID
+        PW_Appendf(&w, "<dev%dok>%lu</dev%dok>",   d, (unsigned long)snap->devReadsOk[d],  d);  // Counts sucess
+        PW_Appendf(&w, "<dev%derr>%lu</dev%derr>", d, (unsigned long)snap->devReadsErr[d], d);  // Counts error
+        PW_Appendf(&w, "<dev%dtm>%lu</dev%dtm>",   d, snap->devBusTimeMs[d], d);                 // Bus time of last cycle in ms
+        PW_Appendf(&w, "<dev%dlerr>%s</dev%dlerr>",d, esp_err_to_name(snap->devLastErr[d]), d); // Last error
+        PW_Appendf(&w, "<dev%dp99>%lu</dev%dp99>", d, (unsigned long)Modbus_Get_Latency_Percentile(    // 99% of answers within (ms)
+                         powermeter_Devices[d].bus, powermeter_Devices[d].slaveId, 99), d);
+        PW_Appendf(&w, "<dev%dtout>%lu</dev%dtout>", d, (unsigned long)Modbus_Get_Response_Timeout(powermeter_Devices[d].bus), d); // Timeout of its bus
+    }
     // MQTT
-    Helper_AppendTo_String(&xml, "<mqttcnts>%d</mqttcnts>",powermeter_published_success); // Counts sucess                </mqttcnts>"
-    Helper_AppendTo_String(&xml, "<mqttcnte>%d</mqttcnte>",powermeter_published_error);   // Counts error                 </mqttcnte>
-    Helper_AppendTo_String(&xml, "<mqtttss>%s</mqtttss>",  powermeter_SuccessUpdateDS_TS);// Last successful time-stamp   </mqtttss>"
-    Helper_AppendTo_String(&xml, "<mqtttse>%s</mqtttse>",  powermeter_PublishError_TS);   // Last successful time-stamp   </mqtttse>"
+    PW_Appendf(&w, "<mqttcnts>%lu</mqttcnts>",(unsigned long)snap->publSuccess); // Counts sucess           </mqttcnts>"
+    PW_Appendf(&w, "<mqttcnte>%lu</mqttcnte>",(unsigned long)snap->publError);   // Counts error            </mqttcnte>
+    PW_Appendf(&w, "<mqtttss>%s</mqtttss>",  snap->publSuccessTS);          // Last successful time-stamp   </mqtttss>"
+    PW_Appendf(&w, "<mqtttse>%s</mqtttse>",  snap->publErrorTS);            // Last successful time-stamp   </mqtttse>"
     // ESP
-    Helper_AppendTo_String(&xml, "<upt>%s</upt>", get_ESP_Uptime());                      // Uptime of this               </upt>"    
+    PW_Appendf(&w, "<upt>%s</upt>", get_ESP_Uptime());                      // Uptime of this               </upt>"    
     u_int32_t hSize = esp_get_free_heap_size(); 
-    Helper_AppendTo_String(&xml, "<freeh>%d.%03d</freeh>",  hSize/1000,hSize%1000);       // Check the left HEAP memory   </freeh>"
-    Helper_AppendTo_String(&xml, "<rganswtm>%d</rganswtm>", readDataSetTime/MBREG);       // Average Reg.-Read-Time       </rganswtm>"
-    Helper_AppendTo_String(&xml, "<dsreadtm>%d</dsreadtm>", readDataSetTime);             // Cycle time over Regs         </dsreadtm>"
+    PW_Appendf(&w, "<freeh>%d.%03d</freeh>",  hSize/1000,hSize%1000);       // Check the left HEAP memory   </freeh>"
+    PW_Appendf(&w, "<rganswtm>%lu</rganswtm>", snap->readDataSetTime/snap->readDataSetRegs); // Average Reg.-Read-Time </rganswtm>"
+    PW_Appendf(&w, "<dsreadtm>%lu</dsreadtm>", snap->readDataSetTime);      // Cycle time over Regs         </dsreadtm>"
+    // TIMING: Jitter & overruns of poll and publish
+    char hist[160];
+    Cadence_Format_Hist(&snap->pollCadence, hist, sizeof(hist));
+#if CONFIG_PRM_FASTPATH_ENABLE
+    if (powermeter_FastNum) {
+        PW_Appendf(&w, "<frate>%.1f Hz / %d ms</frate>", powermeter_FastStats.rateHz, CONFIG_PRM_FASTPATH_PERIOD_MS); // Fast path: achieved rate / period
+        PW_Appendf(&w, "<flat>%lu / %lu</flat>", (unsigned long)powermeter_FastStats.latMs, (unsigned long)powermeter_FastStats.latMaxMs); // Latency last / max
+        PW_Appendf(&w, "<fcnt>samples %lu, errors %lu, skipped %lu, dropped %lu, read %lu ms</fcnt>",
+                   (unsigned long)powermeter_FastStats.samples, (unsigned long)powermeter_FastStats.errors, (unsigned long)powermeter_FastStats.skipped,
+                   (unsigned long)powermeter_FastStats.dropped, (unsigned long)powermeter_FastStats.readMs);
+    } else
+#endif
+    {   PW_Appendf(&w, "<frate>off</frate><flat>-</flat><fcnt>-</fcnt>"); } // Fast path not used
+#if CONFIG_PRM_ENERGY_ENABLE
+    powermeter_energy_ch_t *energy = malloc(PRM_ENERGY_MAX_CH * sizeof(powermeter_energy_ch_t));
+    int num_energy = energy ? PowerMeter_Energy_Read(energy) : 0;
+    PW_Appendf(&w, "<nrg>");                                                 // Integrated energy: import / export per channel
+    for (int c = 0; c < num_energy; c++) {
+        PW_Appendf(&w, "%s%s +%.3f / -%.3f", (c ? "; " : ""), powermeter_Regs[energy[c].cid]->topicName,
+                   energy[c].importWh / 1000.0, energy[c].exportWh / 1000.0); }
+    PW_Appendf(&w, "%s</nrg><nrgchk>", num_energy ? "" : "off");
+    for (int c = 0; c < num_energy; c++) {                                                 // Cross-check with the meter (tooltip)
+        if (!energy[c].isCheck || isnan(energy[c].meterKWh)) { continue; }
+        PW_Appendf(&w, "%s: meter %.3f kWh since start, not integrated %.0f s. ", powermeter_Regs[energy[c].cid]->topicName,
+                   energy[c].meterKWh - energy[c].meterBaseKWh, energy[c].gapS); }
+    PW_Appendf(&w, "checkpoints: %lu</nrgchk>", (unsigned long)powermeter_EnergySaves);
+    free(energy);
+#else
+    PW_Appendf(&w, "<nrg>off</nrg><nrgchk>-</nrgchk>");
+#endif
+#if CONFIG_PRM_HISTORY_ENABLE
+    ts_store_info_t hist_info;                                                             // History in RAM / PSRAM
+    if (powermeter_History && TS_Store_Get_Info(powermeter_History, TS_STORE_ALL_SERIES, &hist_info) == ESP_OK && hist_info.samples) {
+        PW_Appendf(&w, "<hist>%lu values, %lu min</hist>", (unsigned long)hist_info.samples,
+                   (unsigned long)((esp_timer_get_time() / 1000 - hist_info.first_t_ms) / 60000));
+        PW_Appendf(&w, "<histmem>%s: %u of %u kB used, %.1f bytes per value, %lu values appended</histmem>", hist_info.in_psram ? "PSRAM" : "RAM",
+                   (unsigned)(hist_info.bytes_used / 1024), (unsigned)(hist_info.bytes_total / 1024),
+                   (double)hist_info.bytes_used / hist_info.samples, (unsigned long)hist_info.appended);
+    } else
+#endif
+    {   PW_Appendf(&w, "<hist>off</hist><histmem>-</histmem>"); }           // No history (yet)
+#if CONFIG_PRM_FLASH_LOG_ENABLE
+    ts_log_info_t flog_info;                                                               // Log of the window statistics on flash
+    if (powermeter_FlashLog && TS_Log_Get_Info(powermeter_FlashLog, &flog_info) == ESP_OK && flog_info.records) {
+        PW_Appendf(&w, "<flog>%lu records, %lu h</flog>", (unsigned long)flog_info.records,
+                   (unsigned long)((flog_info.last_t_ms - flog_info.first_t_ms) / 3600000));
+        PW_Appendf(&w, "<flogmem>%u of %u kB in %u segments, %lu pages written since start</flogmem>",
+                   (unsigned)(flog_info.bytes / 1024), (unsigned)(powermeter_FlashLogMaxBytes / 1024), (unsigned)flog_info.segments,
+                   (unsigned long)flog_info.pages_written);
+    } else
+#endif
+    {   PW_Appendf(&w, "<flog>off</flog><flogmem>-</flogmem>"); }           // No flash log (yet)
+#if CONFIG_PRM_SNF_ENABLE
+    PW_Appendf(&w, "<snf>%lu / %lu / %lu</snf>", (unsigned long)PowerMeter_SnF_Pending(), // Store & forward: pending / replayed / dropped
+                           (unsigned long)powermeter_SnfStats.replayed, (unsigned long)powermeter_SnfStats.dropped);
+#else
+    PW_Appendf(&w, "<snf>off</snf>");
+#endif
+#if CONFIG_PRM_STATS_ENABLE
+    PW_Appendf(&w, "<swin>%d s / %lld s (%lu closed)</swin>", CONFIG_PRM_STATS_WINDOW_S,  // Window statistics: tumbling / rolling
+                           stats->closed ? (long long)((stats->endUs - stats->rollStartUs) / 1000000) : 0LL, (unsigned long)stats->closed);
+#else
+    PW_Appendf(&w, "<swin>off</swin>");
+#endif
+    PW_Appendf(&w, "<pjit>%.1f</pjit>",       snap->pollCadence.maxJitterUs / 1000.0); // Max. jitter of poll  </pjit>"
+    PW_Appendf(&w, "<povr>%lu / %lu</povr>",  (unsigned long)snap->pollCadence.overruns, (unsigned long)snap->pollCadence.skipped);
+    PW_Appendf(&w, "<phist>%s</phist>",       hist);                        // Jitter histogram of poll     </phist>"
+    Cadence_Format_Hist(&snap->publCadence, hist, sizeof(hist));
+    PW_Appendf(&w, "<mjit>%.1f</mjit>",       snap->publCadence.maxJitterUs / 1000.0); // Max. jitter of publish </mjit>"
+    PW_Appendf(&w, "<movr>%lu / %lu</movr>",  (unsigned long)snap->publCadence.overruns, (unsigned long)snap->publCadence.skipped);
+    PW_Appendf(&w, "<mhist>%s</mhist>",       hist);                        // Jitter histogram of publish  </mhist>"
     // Running FIRMWARE
-    Helper_AppendTo_String(&xml, "<fwname>%s</fwname>",      project_name);               // Firmware-Name               </fwname>"
-    Helper_AppendTo_String(&xml, "<fwver>%s</fwver>",        firmware_version);           // Firmware-Version            </fwver>"
-    Helper_AppendTo_String(&xml, "<fwbuildts>%s</fwbuildts>",firmware_build_ts);          // Firmware-Build              </fwbuildts>"
-    Helper_AppendTo_String(&xml, "<chipname>%s</chipname>",  CONFIG_IDF_TARGET);          // Chip-Name                   </chipname>"   
+    PW_Appendf(&w, "<fwname>%s</fwname>",      project_name);               // Firmware-Name               </fwname>"
+    PW_Appendf(&w, "<fwver>%s</fwver>",        firmware_version);           // Firmware-Version            </fwver>"
+    PW_Appendf(&w, "<fwbuildts>%s</fwbuildts>",firmware_build_ts);          // Firmware-Build              </fwbuildts>"
+    PW_Appendf(&w, "<chipname>%s</chipname>",  CONFIG_IDF_TARGET);          // Chip-Name                   </chipname>"   
     // Closing of XML-tag
     ESP_LOGD(TAG, "--   (4) End: With closing TAG </xml>"); 
-    Helper_AppendTo_String(&xml, "</xml>");
+    PW_Appendf(&w, "</xml>");
+#if CONFIG_PRM_STATS_ENABLE
+    free(stats);
+#endif
+    free(snap);
+    if (!PW_Ok(&w)) { ESP_LOGE(TAG, "--  ❌ XML answer does not fit %u bytes", (unsigned)xml_size); free(xml); return NULL; }
     return xml; // remember: caller must free(xml)
 }
 
@@ -1057,7 +3594,7 @@ static esp_err_t Handle_WebServer_SDM_Index_GET(httpd_req_t *req) {
     //-----------------------------------------------
     // Open File from LittleFS
     //-----------------------------------------------
-    FILE *f = fopen("/rt_files/prm_webserver.html", "r"); // Read the WebPage from LittleFS-Drive
+    FILE *f = fopen(RT_FILES_PATH "/prm_webserver.html", "r"); // Read the WebPage from LittleFS-Drive
     if (!f) {  // Check if the file was opened successfully
       ESP_LOGE(TAG_WS, "--  ❌ Failed to read 'prm_webserver.html' from LittleFS."); 
       httpd_resp_send_404(req); return ESP_FAIL; }
@@ -1080,7 +3617,7 @@ static esp_err_t Handle_WebServer_SDM_Index_GET(httpd_req_t *req) {
 static esp_err_t Handle_WebServer_SDM_Values_PUT(httpd_req_t *req) {
     ESP_LOGV(TAG_WS, "--  Received: XML PUT-Request");
     char *xml_str = Interface_ModbusValues_to_WebServer_SDMValues();
-    if (xml_str == NULL) {httpd_resp_send_500(req);  } // Internal Server Errorreturn ESP_FAIL;
+    if (xml_str == NULL) {httpd_resp_send_500(req); return ESP_FAIL; } // Internal Server Error
     // SEND the XML response
     size_t xml_len = strlen(xml_str); // Get the byte-length of the XML string
     httpd_resp_set_type(req, "text/xml");
@@ -1091,6 +3628,180 @@ static esp_err_t Handle_WebServer_SDM_Values_PUT(httpd_req_t *req) {
     return ESP_OK;
 }
 
+#if CONFIG_PRM_STATS_ENABLE
+/*================================================================================
+  Handle_WebServer_Stats_GET: Window statistics of ALL registers as JSON  "/stats"
+    {"window":60,"closed":42,"start":...,"end":...,"rolling":{"window":900,"start":...},
+     "registers":[{"name":"Power-Total","unit":"W","last":{"n":58,"min":-512,...},"rolling":{"n":871,...}}, ...]}
+  Same numbers as published on MQTT ('STAT'), updated when a window closes.
+  used by: start_PowerMeter_WebServer
+=================================================================================*/
+static esp_err_t Handle_WebServer_Stats_GET(httpd_req_t *req) {
+    powermeter_stats_result_t *res = malloc(sizeof(powermeter_stats_result_t)); // Too big for the stack of the httpd task
+    if (res == NULL) { httpd_resp_send_500(req); return ESP_FAIL; }
+    PowerMeter_Stats_Read(res);
+    size_t json_size = 256 + powermeter_NumCids * 512;  // ONE buffer for the answer
+    char *json = malloc(json_size);
+    if (json == NULL) { free(res); httpd_resp_send_500(req); return ESP_FAIL; }
+    pw_writer_t w;
+    PW_Init(&w, json, json_size);
+    PW_Json_Object(&w, NULL);
+    PW_Json_Int(&w, "window", CONFIG_PRM_STATS_WINDOW_S);
+    PW_Json_Int(&w, "closed", res->closed);
+    PW_Json_Int(&w, "start", res->closed ? getEpochMs_of_Timer(res->startUs) : 0);
+    PW_Json_Int(&w, "end", res->closed ? getEpochMs_of_Timer(res->endUs) : 0);
+    PW_Json_Object(&w, "rolling");
+    PW_Json_Int(&w, "window", (res->endUs - res->rollStartUs) / 1000000);
+    PW_Json_Int(&w, "start", res->closed ? getEpochMs_of_Timer(res->rollStartUs) : 0);
+    PW_Json_Close(&w);
+    PW_Json_Array(&w, "registers");
+    for (int i = 0; i < powermeter_NumCids; i++) {
+        PW_Json_Object(&w, NULL);
+        PW_Json_Str(&w, "name", powermeter_Regs[i]->topicName);
+        PW_Json_Str(&w, "unit", powermeter_Regs[i]->unitOfValue);
+        PW_Json_Object(&w, "last");
+        PowerMeter_Stats_Format(&w, &res->last[i], powermeter_Regs[i]->digits);
+        PW_Json_Close(&w);
+        PW_Json_Object(&w, "rolling");
+        PowerMeter_Stats_Format(&w, &res->roll[i], powermeter_Regs[i]->digits);
+        PW_Json_Close(&w);
+        PW_Json_Close(&w);
+    }
+    PW_Json_Close(&w);
+    PW_Json_Close(&w);
+    free(res);
+    if (!PW_Ok(&w)) { free(json); httpd_resp_send_500(req); return ESP_FAIL; }
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, json, w.len);
+    free(json);
+    return ESP_OK;
+}
+#endif
+
+#if CONFIG_PRM_HISTORY_ENABLE
+/*================================================================================
+  Handle_WebServer_History_GET: History of ONE register, streamed  "/api/history"
+    ?reg=Power-Total   Topic name of the register (required)
+    &meter=0           Index of the meter with this register (default: the first one)
+    &from= &to=        Epoch ms; <= 0 = seconds back from now (e.g. from=-86400, max. 10 years); default: ALL
+    &step=60000        Bucket in ms: value = mean, with min & max (default 0 = every value)
+    &fmt=csv | bin
+  CSV:  't_ms,value,min,max,n' then one line per point
+  BIN:  little endian, 16 bytes header: "PRH1", uint16 columns (4), uint16 flags (bit 0: 1 = epoch ms,
+        0 = ms since boot, no NTP time), int64 t0_ms; then per point 4 x float32: t - t0 in s, value, min, max
+        >> JavaScript: new Float32Array(buf, 16)
+  The points go from the store iterator into ONE chunk buffer (sent when full), nothing else is held.
+  used by: start_PowerMeter_WebServer
+=================================================================================*/
+#define PRM_HISTORY_CHUNK_BYTES (1024)              // Chunk sent to the client
+#define PRM_HISTORY_MAX_BACK_S  (10LL * 365 * 86400)  // from/to in seconds back: max. 10 years
+typedef struct {                                    // State of ONE streamed query
+  httpd_req_t    *req;
+  bool           bin;                               // Format: binary (else CSV)
+  int            digits;                            // Digits of the register (CSV)
+  int64_t        offset_ms;                         // Store time (ms since boot) >> output time
+  int64_t        t0_ms;                             // Time base of the binary format
+  bool           failed;                            // Client gone: stop the query
+  size_t         len;                               // Bytes in 'buf'
+  char           buf[PRM_HISTORY_CHUNK_BYTES];
+} powermeter_history_stream_t;
+
+static bool History_Stream_Send(powermeter_history_stream_t *hs) {
+  if (hs->len && httpd_resp_send_chunk(hs->req, hs->buf, hs->len) != ESP_OK) { hs->failed = true; }
+  hs->len = 0;
+  return !hs->failed;
+}
+
+static bool History_Stream_Point(void *ctx, const ts_point_t *p) {   // Callback of TS_Store_Query
+  powermeter_history_stream_t *hs = ctx;
+  if (sizeof(hs->buf) - hs->len < 128 && !History_Stream_Send(hs)) { return false; } // Room for ONE point
+  int64_t t_ms = p->t_ms + hs->offset_ms;
+  if (hs->bin) {
+      float rec[4] = { (t_ms - hs->t0_ms) / 1000.0f, p->value, p->min, p->max };
+      memcpy(&hs->buf[hs->len], rec, sizeof(rec));            // ESP32 & host: little endian
+      hs->len += sizeof(rec);
+  } else {
+      pw_writer_t w;                                            // ONE line behind the others
+      PW_Init(&w, &hs->buf[hs->len], sizeof(hs->buf) - hs->len);
+      PW_Append_Int(&w, t_ms);
+      PW_Append(&w, ",", 1);
+      PW_Append_Fixed(&w, p->value, hs->digits);
+      PW_Append(&w, ",", 1);
+      PW_Append_Fixed(&w, p->min, hs->digits);
+      PW_Append(&w, ",", 1);
+      PW_Append_Fixed(&w, p->max, hs->digits);
+      PW_Append(&w, ",", 1);
+      PW_Append_Int(&w, p->n);
+      PW_Append(&w, "\n", 1);
+      if (PW_Ok(&w)) { hs->len += w.len; } }                 // Absurd value that does not fit: left out
+  return true;
+}
+
+static int64_t History_Query_Int(const char *query, const char *key, int64_t dflt) {
+  char val[24];
+  if (httpd_query_key_value(query, key, val, sizeof(val)) != ESP_OK || val[0] == '\0') { return dflt; }
+  return strtoll(val, NULL, 10);
+}
+
+static esp_err_t Handle_WebServer_History_GET(httpd_req_t *req) {
+    //-----------------------------------------------
+    // Parameters
+    //-----------------------------------------------
+    char query[160] = "", reg[32] = "", fmt[8] = "csv";
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK ||
+        httpd_query_key_value(query, "reg", reg, sizeof(reg)) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "reg=<topic name> missing"); return ESP_FAIL; }
+    httpd_query_key_value(query, "fmt", fmt, sizeof(fmt));
+    int meter = (int)History_Query_Int(query, "meter", -1);
+    int cid = -1;
+    for (int i = 0; i < powermeter_NumCids && cid < 0; i++) {
+        if (strcmp(powermeter_Regs[i]->topicName, reg) == 0 && (meter < 0 || powermeter_RegDevice[i] == meter)) { cid = i; } }
+    if (cid < 0 || powermeter_History == NULL) { httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "No history of this register"); return ESP_FAIL; }
+    //-----------------------------------------------
+    // Time range: output in epoch ms (ms since boot without NTP time), the store holds ms since boot
+    //-----------------------------------------------
+    int64_t now_ms    = esp_timer_get_time() / 1000;
+    int64_t epoch_ms  = getEpochMs_of_Timer(now_ms * 1000);
+    int64_t offset_ms = epoch_ms ? epoch_ms - now_ms : 0;
+    int64_t from_ms   = History_Query_Int(query, "from", INT64_MIN);
+    int64_t to_ms     = History_Query_Int(query, "to",   INT64_MAX);
+    if ((from_ms != INT64_MIN && from_ms < -PRM_HISTORY_MAX_BACK_S) || to_ms < -PRM_HISTORY_MAX_BACK_S) { // *1000 must not overflow
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "from/to: max. 10 years back"); return ESP_FAIL; }
+    if (from_ms != INT64_MIN) { from_ms = (from_ms <= 0) ? now_ms + from_ms * 1000 : from_ms - offset_ms; }
+    if (to_ms   != INT64_MAX) { to_ms   = (to_ms   <= 0) ? now_ms + to_ms   * 1000 : to_ms   - offset_ms; }
+    int64_t step_ms   = History_Query_Int(query, "step", 0);
+    if (step_ms < 0 || step_ms > UINT32_MAX || to_ms < from_ms) { httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Bad from/to/step"); return ESP_FAIL; }
+    if (from_ms == INT64_MIN) {                                 // Buckets & binary time base need a start: the oldest value
+        ts_store_info_t info;
+        from_ms = (TS_Store_Get_Info(powermeter_History, cid, &info) == ESP_OK) ? info.first_t_ms : 0; }
+    //-----------------------------------------------
+    // Stream: header, then the points as the store iterator hands them over
+    //-----------------------------------------------
+    powermeter_history_stream_t *hs = malloc(sizeof(powermeter_history_stream_t)); // Too big for the stack of the httpd task
+    if (hs == NULL) { httpd_resp_send_500(req); return ESP_FAIL; }
+    memset(hs, 0, offsetof(powermeter_history_stream_t, buf));
+    hs->req       = req;
+    hs->bin       = (strcmp(fmt, "bin") == 0);
+    hs->digits    = powermeter_Regs[cid]->digits;
+    hs->offset_ms = offset_ms;
+    hs->t0_ms     = from_ms + offset_ms;
+    if (hs->bin) {
+        struct { char magic[4]; uint16_t cols; uint16_t flags; int64_t t0_ms; } hdr = { {'P', 'R', 'H', '1'}, 4, epoch_ms ? 1 : 0, hs->t0_ms };
+        memcpy(hs->buf, &hdr, sizeof(hdr));
+        hs->len = sizeof(hdr);
+        httpd_resp_set_type(req, "application/octet-stream");
+    } else {
+        hs->len = snprintf(hs->buf, sizeof(hs->buf), "%s,value,min,max,n\n", epoch_ms ? "t_ms" : "t_boot_ms");
+        httpd_resp_set_type(req, "text/csv"); }
+    size_t points = TS_Store_Query(powermeter_History, cid, from_ms, to_ms, (uint32_t)step_ms, History_Stream_Point, hs);
+    if (History_Stream_Send(hs)) { httpd_resp_send_chunk(req, NULL, 0); } // End response
+    ESP_LOGD(TAG_WS, "--  History of '%s': %u points (%s)%s", reg, (unsigned)points, hs->bin ? "bin" : "csv", hs->failed ? ", client gone" : "");
+    bool failed = hs->failed;
+    free(hs);
+    return failed ? ESP_FAIL : ESP_OK;
+}
+#endif
+
 /*================================================================================
   Handle_WebServer_Logging_Index_GET(): Serve the Starting HTML page
       * Handles the GET request for the root URL ("/webserial").
@@ -1102,7 +3813,7 @@ esp_err_t Handle_WebServer_Logging_Index_GET(httpd_req_t *req) {
     //-----------------------------------------------
     // Open File from LittleFS
     //-----------------------------------------------
-    FILE *f = fopen("/rt_files/webserial.html", "r"); // Read the WebPage from LittleFS-Drive
+    FILE *f = fopen(RT_FILES_PATH "/webserial.html", "r"); // Read the WebPage from LittleFS-Drive
     if (!f) {  // Check if the file was opened successfully
       ESP_LOGE(TAG_WS, "--  ❌ Failed to read 'webserial.html' from LittleFS."); 
       httpd_resp_send_404(req); return ESP_FAIL; }
@@ -1199,7 +3910,8 @@ static esp_err_t Handle_WebServer_Logging_ServerSentEvents_GET(httpd_req_t *req)
   used by: start_logwebserver() 
 =================================================================================*/
 esp_err_t Handle_WebServer_ESP_Reboot_GET(httpd_req_t *req) {
-    vTaskDelete(modbus_poll_task_handle); // Delete the Modbus Polling Task to stop it
+    for (int bus = 0; bus < MB_NUM_BUSES; bus++) {
+        vTaskDelete(modbus_poll_task_handle[bus]); } // Delete the Modbus Polling Tasks to stop them
     vTaskDelete(mqtt_publish_task_handle_PRM); // Delete the MQTT Publish Task to stop it
     //--------------------------------------
     // Store the lastBootReason to NVS
@@ -1258,7 +3970,7 @@ static esp_err_t Handle_WebServer_Icon_GET(httpd_req_t *req) {
     //-----------------------------------------------
     // Open File from LittleFS
     //-----------------------------------------------
-    FILE *f = fopen("/rt_files/favicon.ico", "rb"); // Read the WebPage from LittleFS-Drive
+    FILE *f = fopen(RT_FILES_PATH "/favicon.ico", "rb"); // Read the WebPage from LittleFS-Drive
     if (!f) {  // Check if the file was opened successfully
       ESP_LOGE(TAG_WS, "--  ❌ Failed to read 'favicon.ico' from LittleFS"); 
       httpd_resp_send_404(req); return ESP_FAIL; }
@@ -1290,7 +4002,7 @@ static httpd_handle_t start_PowerMeter_WebServer(void) {
                                               least recent used connection to free up resources for new connections.
                                               This helps keep the server responsive and prevents it from getting stuck when all sockets are occupied.*/
     config.max_open_sockets = 20; // This is the maxium allowed open sockets
-    config.max_uri_handlers = 10; // Maximum number of URI handlers
+    config.max_uri_handlers = 12; // Maximum number of URI handlers
     config.recv_wait_timeout = 2; // Timeout s receiving data on a socket of HTTP server.
     config.send_wait_timeout = 1; // Timeout s for sending data
     config.open_fn = &report_open_web_socket_fn; // Pointer to a function that will be called when a new socket is opened
@@ -1334,6 +4046,26 @@ static httpd_handle_t start_PowerMeter_WebServer(void) {
     err = httpd_register_uri_handler(handle_to_WebServer, &xml_put_uri);
     if (err != ESP_OK) { ESP_LOGE(TAG_WS, "!! ⚠️ Error registering XLM update handler: %s",xml_put_uri.uri); return NULL; }
     else { ESP_LOGI(TAG_WS, "--     * Registered handler for URI:     %s", xml_put_uri.uri);}
+#if CONFIG_PRM_STATS_ENABLE
+    //----------------------------------------------------------------
+    // Register handler for the window statistics (JSON)     "/stats"
+    //----------------------------------------------------------------
+    const httpd_uri_t stats_uri = {
+        .uri  = "/stats",    .method = HTTP_GET, .handler = Handle_WebServer_Stats_GET};
+    err = httpd_register_uri_handler(handle_to_WebServer, &stats_uri);
+    if (err != ESP_OK) { ESP_LOGE(TAG_WS, "!! ⚠️ Error registering statistics handler: %s",stats_uri.uri); return NULL; }
+    else { ESP_LOGI(TAG_WS, "--     * Registered handler for URI:     %s", stats_uri.uri);}
+#endif
+#if CONFIG_PRM_HISTORY_ENABLE
+    //----------------------------------------------------------------
+    // Register handler for the history of a register  "/api/history"
+    //----------------------------------------------------------------
+    const httpd_uri_t history_uri = {
+        .uri  = "/api/history", .method = HTTP_GET, .handler = Handle_WebServer_History_GET};
+    err = httpd_register_uri_handler(handle_to_WebServer, &history_uri);
+    if (err != ESP_OK) { ESP_LOGE(TAG_WS, "!! ⚠️ Error registering history handler: %s",history_uri.uri); return NULL; }
+    else { ESP_LOGI(TAG_WS, "--     * Registered handler for URI:     %s", history_uri.uri);}
+#endif
     //----------------------------------------------------------------
     // Register handler for the Logging-Index-Page         "/webserial"
     //----------------------------------------------------------------
@@ -1428,6 +4160,7 @@ void Task_ping_gateway_fail_reboot(void *arg) {
   TCPIP   ETHERNET   TCPIP   ETHERNET   TCPIP   ETHERNET   TCPIP   ETHERNETTCPIP   ETHERNET   TCPIP   ETHERNET   TCPIP   ETHERNET
 ##################################################################################################################################*/
 
+#if !CONFIG_IDF_TARGET_LINUX // HOST: no connect / disconnect events
 /*================================================================================
   Handle_TCPIP_Disconnect: Handler when connection GOES DOWN
             Stops WebServer when 'Lost-TCPIP'-Event happens.
@@ -1453,6 +4186,7 @@ static void Handle_TCPIP_Connect(void* handle_of_TCPIP, esp_event_base_t event_b
         handle_to_WebServer = start_PowerMeter_WebServer();
     }
 }
+#endif // !CONFIG_IDF_TARGET_LINUX
 
 /*#################################################################################################################################
      MAIN   MAIN   MAIN   MAIN   MAIN   MAIN   MAIN   MAIN   MAIN   MAIN   MAIN   MAIN   MAIN   MAIN   MAIN   MAIN   MAIN   MAIN
@@ -1512,9 +4246,12 @@ void app_main(void)
     /*--------------------------------------------------------------------------
       2. Init LittleFS (at Flash) to store the HTML pages 
     ---------------------------------------------------------------------------*/
+#if CONFIG_IDF_TARGET_LINUX
+                        ESP_LOGI(TAG, "--  2. Host target: Runtime files are read from directory '%s'", RT_FILES_PATH);
+#else
                         ESP_LOGI(TAG, "--  2. Mount LittleFS Partition to use files at runtime...");    
     esp_vfs_littlefs_conf_t runtimeFS_config = {
-        .base_path =        "/rt_files",  // Root-Path in FS = Mounting point
+        .base_path =        RT_FILES_PATH,// Root-Path in FS = Mounting point
         .partition_label =  "storage",    // Partition label
         .format_if_mount_failed = false  // NO formating when mount fails
     };
@@ -1530,6 +4267,25 @@ void app_main(void)
                         ESP_LOGI(TAG, "--     ✅ storage.bin is mounted, ready for file access. (Uses %d of %dkByte).",  (int)(used / 1024), (int)(total / 1024));
       } else {          ESP_LOGE(TAG, "!!     ❌ Mounted, BUT failed to get LittleFS-Infos. Error= (%s)", esp_err_to_name(err));}
     } 
+#endif
+    // NVS: needed by the energy checkpoint (step 6) & the last boot reason (step 8), ONLY the WiFi of step 3 would init it
+                        ESP_LOGI(TAG, "--  2. Initialize NVS (energy checkpoint, last boot reason)...");
+    err = nvs_flash_init(); // Initialize NVS Flash
+    if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+      ESP_LOGW(TAG, "--     ⚠️ NVS has no free pages or a new version: erased (%s)", esp_err_to_name(err));
+      ESP_ERROR_CHECK(nvs_flash_erase()); // Erase NVS if no free pages or new version found
+      err = nvs_flash_init();
+    }
+    if (err != ESP_OK) {
+      ESP_LOGE(TAG, "--     ❌ NVS Flash initialization failed: %s", esp_err_to_name(err));
+      isNVSready = false; // Set the flag to indicate NVS is not ready
+    } else {
+      isNVSready = true; // Set the flag to indicate NVS is ready
+    }
+#if CONFIG_PRM_REGISTER_MAP_FILE
+                        ESP_LOGI(TAG, "--     Load the register map of the meters...");
+    PowerMeter_Load_RegisterMap();                       // Before the WebServer & Modbus use the register sets
+#endif
     /*--------------------------------------------------------------------------
       3. Establish connection to LAN with Ethernet
     ---------------------------------------------------------------------------*/  
@@ -1559,6 +4315,7 @@ void app_main(void)
     esp_log_level_set("httpd",      CONFIG_PRM_HTTPDAEMON_LOG_LEVEL);  //  httpd:     Log-Level for ESP-IDF HTTPD
     esp_log_level_set("httpd_sess", CONFIG_PRM_HTTPDAEMON_LOG_LEVEL);  //  httpd:     Log-Level for ESP-IDF HTTPD
     start_async_req_workers(); // Start the async request workers needed for one part the WebServer   
+#if !CONFIG_IDF_TARGET_LINUX // HOST: network of the host is always up, no events
     /* Register event handlers to stop the server when Wi-Fi or Ethernet is disconnected, and re-start it upon connection. */
     /* WebServer will be started & stopped with the following Ethenet handler
        >> Register event handler for 'esp_event_loop_create_default'
@@ -1573,6 +4330,7 @@ void app_main(void)
                       ETHERNET_EVENT_DISCONNECTED, // Default-Event: Ethenet dissconnected
                       &Handle_TCPIP_Disconnect,    // The handler that will be called 
                       handle_to_WebServer)); // Stop webserver when ethernet is disconnected
+#endif
     // 'Got IP' event if allready over to start the WebServer manually if needed
     if ( handle_to_WebServer==NULL && is_lan_connected() ) {
         handle_to_WebServer = start_PowerMeter_WebServer();
@@ -1587,11 +4345,41 @@ void app_main(void)
     err= Start_Modbus_RTU_Workers(
                 &handle_to_Modbus_MasterController,      // If Start was successful, the Handle to Modbus-Controller is RETURNED
                 powermeter_param_descriptors,            // Pointer to the SDM Device Register >> Parameter DESCRIPTOR Table
-                MBREG                                    // Number of descriptors in the table
+                powermeter_NumCids                       // Number of descriptors in the table (all meters)
     );           
     ESP_ERROR_CHECK(err); // Check for errors
-    // Create the FreeRTOS task to poll the SDM registers
-    xTaskCreate(Task_Modbus_SDM_Poll_RegisterValues, "Task_Modbus_SDM_Poll_RegisterValues", 4096, NULL, 4, &modbus_poll_task_handle);
+    powermeter_CycleMutex = xSemaphoreCreateMutex();    // Shared by the poll tasks of all buses (& writers of the snapshot)
+    xSemaphoreTake(powermeter_CycleMutex, portMAX_DELAY);
+    PowerMeter_Snapshot_Poll_Results();                  // Initial snapshot for the WebServer
+    PowerMeter_Snapshot_Publish_Results();
+    xSemaphoreGive(powermeter_CycleMutex);
+#if CONFIG_PRM_STATS_ENABLE
+    PowerMeter_Stats_Setup();                            // Min/max/mean/sd per register & window
+#endif
+#if CONFIG_PRM_HISTORY_ENABLE
+    if (TS_Store_Create(powermeter_NumCids, &powermeter_History) != ESP_OK) { powermeter_History = NULL; } // History of the values (NO history without memory)
+#endif
+#if CONFIG_PRM_ENERGY_ENABLE
+    PowerMeter_Energy_Setup();                           // Import & export energy of the power registers (NVS checkpoint)
+#endif
+#if CONFIG_PRM_FLASH_LOG_ENABLE
+    PowerMeter_FlashLog_Setup();                         // Window statistics to flash (LittleFS, recovered after a crash)
+#endif
+#if CONFIG_PRM_SNF_ENABLE
+    PowerMeter_SnF_Setup();                              // Buffer for values while the broker is NOT reachable
+#endif
+#if CONFIG_PRM_FASTPATH_ENABLE
+    PowerMeter_FastPath_Setup();                         // Registers polled back-to-back for load-following control
+#endif
+    // Create the FreeRTOS tasks to poll the SDM registers: ONE per bus
+    for (int bus = 0; bus < MB_NUM_BUSES; bus++) {
+        Modbus_Build_ReadPlan_PowerMeter(bus, 0);        // Log how ALL registers are grouped to block reads
+        char task_name[configMAX_TASK_NAME_LEN];
+        snprintf(task_name, sizeof(task_name), "MB_Poll_Bus%d", bus);
+        int core = Modbus_Get_Bus_Config(bus)->core;     // Core affinity from menuconfig (-1 = none)
+        xTaskCreatePinnedToCore(Task_Modbus_SDM_Poll_RegisterValues, task_name, 4096, (void *)(uintptr_t)bus, 4, 
+                                &modbus_poll_task_handle[bus], (core < 0) ? tskNO_AFFINITY : core);
+    }
     /*--------------------------------------------------------------------------
       7. OTA - Enable Over-The-Air Update (!after IP connection ist established) 
     ---------------------------------------------------------------------------*/
@@ -1601,16 +4389,11 @@ void app_main(void)
         start_ota_task(); // Start the OTA task
     }
     /*--------------------------------------------------------------------------
-      8. Initialize NVS to store the last boot reason
+      8. Get the last boot reason from NVS (initialized at step 2)
     ---------------------------------------------------------------------------*/
-    ESP_LOGI(TAG, "--  8. Initialize NVS & get last boot reason");
-    err = nvs_flash_init(); // Initialize NVS Flash
+    ESP_LOGI(TAG, "--  8. Get last boot reason from NVS");
     char *string_lastBootReason = NULL; // Variable to hold the last boot reason
-    if (err != ESP_OK) {
-      ESP_LOGE(TAG, "--     ❌ NVS Flash initialization failed: %s", esp_err_to_name(err));
-      isNVSready = false; // Set the flag to indicate NVS is not ready
-    } else {
-      isNVSready = true; // Set the flag to indicate NVS is ready
+    if (isNVSready) {
       /*--------------------------------------------------------------------
        Get the Last-Boot-Reason from NVS to be send to MQTT in next Section
       ---------------------------------------------------------------------*/
@@ -1629,7 +4412,11 @@ void app_main(void)
         } else {          ESP_LOGE(TAG, "!!     ⚠️ Failed to connect: Turn Logging on 'esp_log_level_set()' to see more details");  }
       ESP_ERROR_CHECK(err); // Check for errors
       // Create the FreeRTOS task to publish the MQTT messages grabbed from Modbus Powermeter
-      xTaskCreate(Task_MQTT_PowerMeter_Publish, "Task_MQTT_PowerMeter_Publish", 4096, NULL, 5, &mqtt_publish_task_handle_PRM);
+      xTaskCreate(Task_MQTT_PowerMeter_Publish, "Task_MQTT_PowerMeter_Publish", PRM_PUBLISH_STACK_BYTES, NULL, 5, &mqtt_publish_task_handle_PRM);
+#if CONFIG_PRM_FASTPATH_ENABLE
+      // Create the FreeRTOS task to publish the samples of the fast path at once (higher prio: low latency)
+      if (powermeter_FastNum) { xTaskCreate(Task_MQTT_FastPath_Publish, "Task_MQTT_FastPath_Publish", 3072, NULL, 6, NULL); }
+#endif
       // Create the FreeRTOS task to publish ESP's free heap frequently as MQTT messages. HINT: It appears like Powermeter-value
       xTaskCreate(Task_MQTT_publish_ESP_freeHeap, "Task_MQTT_publish_ESP_freeHeap", 3072, NULL, 6, NULL);
       if (is_mqtt_connected()) // Only if MQTT-Broker is connected
@@ -1645,8 +4432,13 @@ void app_main(void)
         MQTT_publish_Common_infos(MQTT_ESP_SUB_TOPIC,"mDNS-URL", url_with_hostname);          // ESP's mDNS URL
         MQTT_publish_Common_infos(MQTT_ESP_SUB_TOPIC,"IP-Address", get_lan_ip_info());        // ESP's IP-Address
         MQTT_publish_Common_infos(MQTT_ESP_SUB_TOPIC,"OTA-URL", get_ota_url());               // ESP's OTA URL
-        // Publish the Powermeter name to MQTT
-        MQTT_publish_Common_infos(MQTT_PRM_SUB_TOPIC,"Powermeter-Device", PRM_Name);          // Powermeter-name
+        // Publish the Powermeter names to MQTT
+        for (int d = 0; d < PRM_NUM_DEVICES; d++) {
+            char info_name[64];                                                               // 'Powermeter-Device' or 'Powermeter-Device-Meter-2'
+            snprintf(info_name, sizeof(info_name), "Powermeter-Device%s%s", 
+                     (powermeter_Devices[d].subTopic[0] ? "-" : ""), powermeter_Devices[d].subTopic);
+            MQTT_publish_Common_infos(MQTT_PRM_SUB_TOPIC, info_name, powermeter_Devices[d].model); // Powermeter-name
+        }
         //-------------------------------------------------------
         // Publish Infos from Not volatile storage (NVS) to MQTT 
         // (when read successful)
@@ -0,0 +1,48 @@
+/*############################################################################
+  energy_test: HOST test of PowerMeter_Energy_Trapezoid() (PowerMeter_Energy.h)
+  ----------------------------------------------------------------------------
+  Same sign, sign changes both ways and the cases with 0 W at one end:
+  import & export must match the expected Wh and must NEVER go down.
+  Exit code 0 = all passed.
+#############################################################################*/
+#include <stdio.h>
+#include <stdbool.h>
+#include <math.h>
+#include "PowerMeter_Energy.h"
+
+typedef struct {
+    float  p0, p1;              // W at the start & end of the step
+    double dt_s;                // Length of the step
+    double importWh, exportWh;  // Expected
+} energy_case_t;
+
+static const energy_case_t energy_Cases[] = {
+    {  3600,  3600, 3600, 3600.0,    0.0 },   // Constant import
+    { -3600, -3600, 3600,    0.0, 3600.0 },   // Constant export
+    {     0,  3600, 3600, 1800.0,    0.0 },   // 0 >> import
+    {  3600,     0, 3600, 1800.0,    0.0 },   // Import >> 0
+    {     0, -3600, 3600,    0.0, 1800.0 },   // 0 >> export (p0 == 0 with p1 < 0)
+    { -3600,     0, 3600,    0.0, 1800.0 },   // Export >> 0
+    {     0,     0, 3600,    0.0,    0.0 },   // Nothing
+    {  3600, -3600, 3600,  900.0,  900.0 },   // Import >> export, crossing in the middle
+    { -3600,  3600, 3600,  900.0,  900.0 },   // Export >> import, crossing in the middle
+    {  1200, -3600,    4,  1200.0 * 1 / 2 / 3600, 3600.0 * 3 / 2 / 3600 },   // Crossing after 1 of 4 s
+    { -1200,  3600,    4,  3600.0 * 3 / 2 / 3600, 1200.0 * 1 / 2 / 3600 },
+    { -0.0f, -3600, 3600,    0.0, 1800.0 },   // -0 counts as 0
+};
+
+int main(void)
+{ int bad = 0;
+  int num = sizeof(energy_Cases) / sizeof(energy_Cases[0]);
+  for (int k = 0; k < num; k++) {
+      const energy_case_t *c = &energy_Cases[k];
+      double imp = 1000.0, expo = 2000.0;           // Counters with a history: must not go down
+      PowerMeter_Energy_Trapezoid(c->p0, c->p1, c->dt_s, &imp, &expo);
+      imp -= 1000.0; expo -= 2000.0;
+      bool ok = imp >= 0 && expo >= 0 && fabs(imp - c->importWh) < 1e-9 && fabs(expo - c->exportWh) < 1e-9;
+      if (!ok) { bad++; }
+      printf("%s p0 %8.1f W  p1 %8.1f W  %6.0f s >> import %10.6f Wh (%10.6f)  export %10.6f Wh (%10.6f)\n",
+             ok ? "ok  " : "FAIL", c->p0, c->p1, c->dt_s, imp, c->importWh, expo, c->exportWh); }
+  printf("%d of %d cases passed\n", num - bad, num);
+  return bad ? 1 : 0;
+}
@@ -0,0 +1,353 @@
+/*############################################################################
+  sdm_sim: Eastron SDM630 Modbus RTU SLAVE simulator for the host (Linux)
+  ----------------------------------------------------------------------------
+  Opens a pseudo-terminal and answers like one or more SDM630 meters on a
+  RS485-bus: FC04 'Read Input Registers' of the registers listed in
+  'EASTRON_SDM.h', floats in CDAB order (high word first), like the meter.
+
+  For performance tests the answers can be disturbed in a repeatable way
+  (fixed seed): response latency + jitter, CRC errors and dropouts.
+
+  Usage:  sdm_sim [options]
+    -p <path>     Symlink to the slave side of the pty   (default /tmp/ttySDM0)
+    -a <id,..>    Slave address(es) to answer for        (default 1)
+    -b <baud>     Emulate the transmission time of both frames at this baudrate
+                  (pty itself has none), 0 = off          (default 9600)
+    -l <ms>       Response latency of the meter          (default 20)
+    -j <ms>       Additional random jitter 0..ms         (default 5)
+    -c <%>        Answers with a wrong CRC               (default 0)
+    -d <%>        Dropouts = no answer at all            (default 0)
+    -m <regs>     Max. registers with ONE request, more >> exception 03 (default 80)
+    -s <seed>     Seed of the random numbers             (default 1)
+    -v            Log every request
+  Statistics are printed every 10 s and on exit (Ctrl-C).
+
+  Connect the firmware (linux target) or any Modbus master to the symlink.
+#############################################################################*/
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <math.h>
+#include <time.h>
+#include <termios.h>
+#include "EASTRON_SDM.h"            // Register map of the meter
+
+/*------------------
+   CONSTANTS
+------------------*/
+#define SIM_MAX_SLAVES      (8)     // Max. number of simulated meters on the bus
+#define SIM_FRAME_GAP_MS    (2)     // Silence that ends a request frame (pty has no t3.5 of its own)
+#define SIM_REG_LIMIT       (0x0600)// Registers above = illegal data address (last SDM register is 0x0502)
+#define SIM_STATS_EVERY_S   (10)    // Print statistics every .. seconds
+#define MB_FC_READ_INPUT    (0x04)  // Modbus function code: Read Input Registers
+#define MB_EX_ILLEGAL_FC    (0x01)  // Modbus exception: Illegal function
+#define MB_EX_ILLEGAL_ADDR  (0x02)  // Modbus exception: Illegal data address
+#define MB_EX_ILLEGAL_VALUE (0x03)  // Modbus exception: Illegal data value
+
+/*------------------
+   SETTINGS (from the command line)
+------------------*/
+static const char *opt_path    = "/tmp/ttySDM0";
+static uint8_t     opt_slaves[SIM_MAX_SLAVES] = { 1 };
+static int         opt_num_slaves = 1;
+static int         opt_baud    = 9600;
+static int         opt_lat_ms  = 20;
+static int         opt_jit_ms  = 5;
+static int         opt_crc_pct = 0;
+static int         opt_drop_pct= 0;
+static int         opt_max_regs= 80;
+static unsigned    opt_seed    = 1;
+static bool        opt_verbose = false;
+
+/*------------------
+   STATISTICS
+------------------*/
+static volatile sig_atomic_t stop_requested = 0;
+static struct {
+  unsigned long requests;           // Frames with a valid CRC
+  unsigned long bad_frames;         // Frames with a wrong CRC or too short
+  unsigned long other_slaves;       // Frames for slaves NOT simulated
+  unsigned long answers;            // Normal answers
+  unsigned long exceptions;         // Exception answers
+  unsigned long crc_errors;         // Answers sent with a wrong CRC (on purpose)
+  unsigned long dropouts;           // Requests not answered (on purpose)
+  unsigned long regs;               // Registers answered
+} stats;
+
+/*--------------------------------
+  Register map of the simulated meter
+  used by: Sim_Register_Value
+----------------------------------*/
+typedef enum { Q_VOLT, Q_CURR, Q_POWER, Q_APPARENT, Q_REACTIVE, Q_PF, Q_FREQ, Q_ENERGY,
+               Q_LL_VOLT, Q_SUM_CURR, Q_TOT_POWER, Q_TOT_APPARENT, Q_TOT_REACTIVE, Q_TOT_PF,
+               Q_AVG_VOLT, Q_AVG_CURR, Q_NEUTRAL, Q_ZERO } sim_quantity_t;
+typedef struct {
+  uint16_t       reg;               // Register address from EASTRON_SDM.h
+  sim_quantity_t qty;               // What the register shows
+  int            phase;             // Phase 0..2 (if any)
+} sim_register_t;
+
+static const sim_register_t sim_Registers[] = {
+  { SDM_PHASE_1_VOLTAGE,             Q_VOLT,     0 }, { SDM_PHASE_2_VOLTAGE,        Q_VOLT,     1 }, { SDM_PHASE_3_VOLTAGE,        Q_VOLT,     2 },
+  { SDM_PHASE_1_CURRENT,             Q_CURR,     0 }, { SDM_PHASE_2_CURRENT,        Q_CURR,     1 }, { SDM_PHASE_3_CURRENT,        Q_CURR,     2 },
+  { SDM_PHASE_1_POWER,               Q_POWER,    0 }, { SDM_PHASE_2_POWER,          Q_POWER,    1 }, { SDM_PHASE_3_POWER,          Q_POWER,    2 },
+  { SDM_PHASE_1_APPARENT_POWER,      Q_APPARENT, 0 }, { SDM_PHASE_2_APPARENT_POWER, Q_APPARENT, 1 }, { SDM_PHASE_3_APPARENT_POWER, Q_APPARENT, 2 },
+  { SDM_PHASE_1_REACTIVE_POWER,      Q_REACTIVE, 0 }, { SDM_PHASE_2_REACTIVE_POWER, Q_REACTIVE, 1 }, { SDM_PHASE_3_REACTIVE_POWER, Q_REACTIVE, 2 },
+  { SDM_PHASE_1_POWER_FACTOR,        Q_PF,       0 }, { SDM_PHASE_2_POWER_FACTOR,   Q_PF,       1 }, { SDM_PHASE_3_POWER_FACTOR,   Q_PF,       2 },
+  { SDM_AVERAGE_L_TO_N_VOLTS,        Q_AVG_VOLT, 0 },
+  { SDM_AVERAGE_LINE_CURRENT,        Q_AVG_CURR, 0 },
+  { SDM_SUM_LINE_CURRENT,            Q_SUM_CURR, 0 },
+  { SDM_TOTAL_SYSTEM_POWER,          Q_TOT_POWER,0 },
+  { SDM_TOTAL_SYSTEM_APPARENT_POWER, Q_TOT_APPARENT, 0 },
+  { SDM_TOTAL_SYSTEM_REACTIVE_POWER, Q_TOT_REACTIVE, 0 },
+  { SDM_TOTAL_SYSTEM_POWER_FACTOR,   Q_TOT_PF,   0 },
+  { SDM_FREQUENCY,                   Q_FREQ,     0 },
+  { SDM_IMPORT_ACTIVE_ENERGY,        Q_ENERGY,   0 },
+  { SDM_EXPORT_ACTIVE_ENERGY,        Q_ZERO,     0 },
+  { SDM_LINE_1_TO_LINE_2_VOLTS,      Q_LL_VOLT,  0 }, { SDM_LINE_2_TO_LINE_3_VOLTS, Q_LL_VOLT,  1 }, { SDM_LINE_3_TO_LINE_1_VOLTS, Q_LL_VOLT,  2 },
+  { SDM_AVERAGE_LINE_TO_LINE_VOLTS,  Q_LL_VOLT,  0 },
+  { SDM_NEUTRAL_CURRENT,             Q_NEUTRAL,  0 },
+  { SDM_TOTAL_ACTIVE_ENERGY,         Q_ENERGY,   0 },
+  { SDM_TOTAL_REACTIVE_ENERGY,       Q_ZERO,     0 },
+};
+#define SIM_NUM_REGS (sizeof(sim_Registers)/sizeof(sim_Registers[0]))
+
+/*############################################################################
+  Helpers
+#############################################################################*/
+static double Now_s(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void Sleep_us(long us) {
+  if (us <= 0) { return; }
+  struct timespec ts = { .tv_sec = us / 1000000, .tv_nsec = (us % 1000000) * 1000 };
+  while (nanosleep(&ts, &ts) != 0 && errno == EINTR && !stop_requested) { }
+}
+
+static bool Chance_pct(int pct) { return pct > 0 && (rand() % 100) < pct; }
+
+static long Frame_Time_us(int bytes) {              // 11 bits per byte (start, 8 data, parity/stop, stop)
+  return opt_baud > 0 ? (long)bytes * 11 * 1000000L / opt_baud : 0;
+}
+
+/*--------------------------------
+  Modbus CRC16 (poly 0xA001, init 0xFFFF, sent LOW byte first)
+----------------------------------*/
+static uint16_t Modbus_CRC16(const uint8_t *buf, size_t len) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < len; i++) {
+      crc ^= buf[i];
+      for (int b = 0; b < 8; b++) { crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1; } }
+  return crc;
+}
+
+/*--------------------------------
+  Sim_Register_Value: Value of a register of a meter at time t
+  * Slowly varying load, so the 'significant change' logic of the firmware has work to do
+  * Every meter (slave) has its own phase of the load curve
+----------------------------------*/
+static float Sim_Register_Value(const sim_register_t *r, int slave_idx, double t) {
+  double ph   = slave_idx * 1.3;
+  double volt[3], curr[3], pf[3];
+  for (int p = 0; p < 3; p++) {
+      volt[p] = 230.0 + 3.0 * sin(t / 17.0 + ph + p);
+      curr[p] = 4.0 + 3.0 * sin(t / 11.0 + ph + 2.1 * p) + 0.05 * sin(t * 3.0 + p);
+      pf[p]   = 0.93 + 0.05 * sin(t / 23.0 + p); }
+  double pow_tot = 0, app_tot = 0;
+  for (int p = 0; p < 3; p++) { pow_tot += volt[p] * curr[p] * pf[p]; app_tot += volt[p] * curr[p]; }
+  int p = r->phase;
+  switch (r->qty) {
+      case Q_VOLT:         return volt[p];
+      case Q_CURR:         return curr[p];
+      case Q_POWER:        return volt[p] * curr[p] * pf[p];
+      case Q_APPARENT:     return volt[p] * curr[p];
+      case Q_REACTIVE:     return volt[p] * curr[p] * sqrt(1.0 - pf[p] * pf[p]);
+      case Q_PF:           return pf[p];
+      case Q_FREQ:         return 50.0 + 0.02 * sin(t / 5.0 + ph);
+      case Q_ENERGY:       return 12345.0 + slave_idx * 1000.0 + t * 1.5 / 3600.0;   // ~1.5 kW average
+      case Q_LL_VOLT:      return 1.732 * volt[p];
+      case Q_SUM_CURR:     return curr[0] + curr[1] + curr[2];
+      case Q_TOT_POWER:    return pow_tot;
+      case Q_TOT_APPARENT: return app_tot;
+      case Q_TOT_REACTIVE: return sqrt(app_tot * app_tot - pow_tot * pow_tot);
+      case Q_TOT_PF:       return pow_tot / app_tot;
+      case Q_AVG_VOLT:     return (volt[0] + volt[1] + volt[2]) / 3.0;
+      case Q_AVG_CURR:     return (curr[0] + curr[1] + curr[2]) / 3.0;
+      case Q_NEUTRAL:      return fabs(curr[0] - curr[1]) * 0.5;
+      default:             return 0.0f;
+  }
+}
+
+/*--------------------------------
+  Sim_Fill_Registers: Build the register image of 'count' registers from 'start'
+  * Registers without a meaning (gaps between the floats) answer 0, like the meter
+----------------------------------*/
+static void Sim_Fill_Registers(int slave_idx, uint16_t start, uint16_t count, uint8_t *out) {
+  double t = Now_s();
+  memset(out, 0, (size_t)count * 2);
+  for (size_t k = 0; k < SIM_NUM_REGS; k++) {
+      const sim_register_t *r = &sim_Registers[k];
+      union { float f; uint32_t u; } conv = { .f = Sim_Register_Value(r, slave_idx, t) };
+      uint16_t words[2] = { (uint16_t)(conv.u >> 16), (uint16_t)(conv.u & 0xFFFF) }; // CDAB: high word at LOWER address
+      for (int w = 0; w < 2; w++) {
+          int reg = r->reg + w;
+          if (reg < start || reg >= start + count) { continue; }
+          out[(reg - start) * 2]     = words[w] >> 8;   // Big endian within the register
+          out[(reg - start) * 2 + 1] = words[w] & 0xFF; } }
+}
+
+/*--------------------------------
+  Sim_Send: Emulate bus timing & faults, then write the answer (CRC appended here)
+----------------------------------*/
+static void Sim_Send(int fd, uint8_t *frame, size_t len, size_t req_len) {
+  uint16_t crc = Modbus_CRC16(frame, len);
+  frame[len]     = crc & 0xFF;
+  frame[len + 1] = crc >> 8;
+  len += 2;
+  long delay_us = Frame_Time_us((int)req_len) + opt_lat_ms * 1000L + (opt_jit_ms > 0 ? rand() % (opt_jit_ms * 1000) : 0)
+                + Frame_Time_us((int)len);       // Request on the wire, meter thinks, answer on the wire
+  Sleep_us(delay_us);
+  if (Chance_pct(opt_crc_pct)) { frame[len - 1] ^= 0x5A; stats.crc_errors++; }
+  if (write(fd, frame, len) != (ssize_t)len) { perror("write"); }
+}
+
+/*--------------------------------
+  Sim_Handle_Request: Answer ONE complete request frame (CRC already checked)
+----------------------------------*/
+static void Sim_Handle_Request(int fd, const uint8_t *req, size_t len) {
+  int slave_idx = -1;
+  for (int s = 0; s < opt_num_slaves; s++) { if (opt_slaves[s] == req[0]) { slave_idx = s; } }
+  if (slave_idx < 0) { stats.other_slaves++; return; }   // Not one of ours (or broadcast) >> stay silent
+  stats.requests++;
+  if (Chance_pct(opt_drop_pct)) { stats.dropouts++; if (opt_verbose) { printf("   slave %d: dropout\n", req[0]); } return; }
+  uint8_t ans[3 + 2 * 125 + 2];
+  ans[0] = req[0];
+  uint8_t ex = 0;
+  if (req[1] != MB_FC_READ_INPUT || len != 8)  { ex = MB_EX_ILLEGAL_FC; }
+  else {
+      uint16_t start = (req[2] << 8) | req[3];
+      uint16_t count = (req[4] << 8) | req[5];
+      if (count == 0 || count > 125 || count > opt_max_regs) { ex = MB_EX_ILLEGAL_VALUE; }
+      else if (start + count > SIM_REG_LIMIT)                { ex = MB_EX_ILLEGAL_ADDR; }
+      else {
+          ans[1] = MB_FC_READ_INPUT;
+          ans[2] = (uint8_t)(count * 2);
+          Sim_Fill_Registers(slave_idx, start, count, &ans[3]);
+          if (opt_verbose) { printf("   slave %d: FC04 0x%04X..0x%04X (%d regs)\n", req[0], start, start + count - 1, count); }
+          stats.answers++;
+          stats.regs += count;
+          Sim_Send(fd, ans, 3 + count * 2, len);
+          return; } }
+  ans[1] = req[1] | 0x80;                                 // Exception answer
+  ans[2] = ex;
+  if (opt_verbose) { printf("   slave %d: FC%02X >> exception %d\n", req[0], req[1], ex); }
+  stats.exceptions++;
+  Sim_Send(fd, ans, 3, len);
+}
+
+/*--------------------------------
+  Print the statistics
+----------------------------------*/
+static void Print_Stats(void) {
+  printf("-- requests %lu (answers %lu, exceptions %lu, dropouts %lu, crc-errors sent %lu) | regs %lu | bad frames %lu | other slaves %lu\n",
+         stats.requests, stats.answers, stats.exceptions, stats.dropouts, stats.crc_errors, stats.regs, stats.bad_frames, stats.other_slaves);
+  fflush(stdout);
+}
+
+static void On_Signal(int sig) { (void)sig; stop_requested = 1; }
+
+/*--------------------------------
+  Parse the command line
+----------------------------------*/
+static void Usage(const char *prg) {
+  fprintf(stderr, "Usage: %s [-p path] [-a id,id..] [-b baud] [-l latency_ms] [-j jitter_ms] [-c crc_err_%%] [-d dropout_%%] [-m max_regs] [-s seed] [-v]\n", prg);
+  exit(2);
+}
+
+static void Parse_Args(int argc, char **argv) {
+  int opt;
+  while ((opt = getopt(argc, argv, "p:a:b:l:j:c:d:m:s:vh")) != -1) {
+      switch (opt) {
+          case 'p': opt_path     = optarg; break;
+          case 'b': opt_baud     = atoi(optarg); break;
+          case 'l': opt_lat_ms   = atoi(optarg); break;
+          case 'j': opt_jit_ms   = atoi(optarg); break;
+          case 'c': opt_crc_pct  = atoi(optarg); break;
+          case 'd': opt_drop_pct = atoi(optarg); break;
+          case 'm': opt_max_regs = atoi(optarg); break;
+          case 's': opt_seed     = (unsigned)strtoul(optarg, NULL, 0); break;
+          case 'v': opt_verbose  = true; break;
+          case 'a': {
+              opt_num_slaves = 0;
+              for (char *tok = strtok(optarg, ","); tok && opt_num_slaves < SIM_MAX_SLAVES; tok = strtok(NULL, ",")) {
+                  int id = atoi(tok);
+                  if (id < 1 || id > 247) { fprintf(stderr, "Invalid slave address %s\n", tok); exit(2); }
+                  opt_slaves[opt_num_slaves++] = (uint8_t)id; }
+              if (opt_num_slaves == 0) { Usage(argv[0]); }
+              break; }
+          default: Usage(argv[0]);
+      } }
+}
+
+/*############################################################################
+  main: Open the pty and answer requests until Ctrl-C
+#############################################################################*/
+int main(int argc, char **argv) {
+  Parse_Args(argc, argv);
+  srand(opt_seed);
+  //------------------------------------------
+  // Open pty: the simulator keeps the master side, the firmware opens the slave side
+  //------------------------------------------
+  int fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0) { perror("posix_openpt"); return 1; }
+  const char *slave_name = ptsname(fd);
+  struct termios tio;
+  if (tcgetattr(fd, &tio) == 0) { cfmakeraw(&tio); tcsetattr(fd, TCSANOW, &tio); } // Binary, no echo
+  int keep = open(slave_name, O_RDWR | O_NOCTTY);          // Keep the slave side open >> no EIO when the master closes it
+  if (keep >= 0 && tcgetattr(keep, &tio) == 0) { cfmakeraw(&tio); tcsetattr(keep, TCSANOW, &tio); }
+  unlink(opt_path);
+  if (symlink(slave_name, opt_path) != 0) { perror("symlink"); return 1; }
+  printf("-- SDM630 simulator on %s (-> %s), slaves:", opt_path, slave_name);
+  for (int s = 0; s < opt_num_slaves; s++) { printf(" %d", opt_slaves[s]); }
+  printf(" | baud %d, latency %d+0..%d ms, crc-errors %d%%, dropouts %d%%, max %d regs, seed %u\n",
+         opt_baud, opt_lat_ms, opt_jit_ms, opt_crc_pct, opt_drop_pct, opt_max_regs, opt_seed);
+  fflush(stdout);
+  signal(SIGINT, On_Signal);
+  signal(SIGTERM, On_Signal);
+  //------------------------------------------
+  // Receive loop: a frame ends with SIM_FRAME_GAP_MS of silence
+  //------------------------------------------
+  uint8_t frame[256];
+  size_t  len = 0;
+  double  next_stats = Now_s() + SIM_STATS_EVERY_S;
+  while (!stop_requested) {
+      struct pollfd pfd = { .fd = fd, .events = POLLIN };
+      int rc = poll(&pfd, 1, len ? SIM_FRAME_GAP_MS : 500);
+      if (rc < 0 && errno != EINTR) { perror("poll"); break; }
+      if (rc > 0 && (pfd.revents & POLLIN)) {
+          ssize_t n = read(fd, frame + len, sizeof(frame) - len);
+          if (n > 0) { len += (size_t)n; }
+          if (len < sizeof(frame)) { continue; } }          // Wait for the end of the frame
+      if (len > 0) {                                        // Silence (or buffer full) >> frame complete
+          if (len < 4 || Modbus_CRC16(frame, len - 2) != (frame[len - 2] | (frame[len - 1] << 8))) { stats.bad_frames++; }
+          else { Sim_Handle_Request(fd, frame, len); }
+          len = 0; }
+      if (Now_s() >= next_stats) { Print_Stats(); next_stats += SIM_STATS_EVERY_S; }
+  }
+  Print_Stats();
+  unlink(opt_path);
+  if (keep >= 0) { close(keep); }
+  close(fd);
+  return 0;
+}
@@ -0,0 +1,6 @@
+/* HOST stand-in of esp_err.h (ts_store_test) */
+#pragma once
+typedef int esp_err_t;
+#define ESP_OK               0
+#define ESP_ERR_NO_MEM       0x101
+#define ESP_ERR_INVALID_ARG  0x102
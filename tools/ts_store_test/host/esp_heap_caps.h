@@ -0,0 +1,7 @@
+/* HOST stand-in of esp_heap_caps.h (ts_store_test): plain malloc, no PSRAM */
+#pragma once
+#include <stdlib.h>
+#define MALLOC_CAP_8BIT    (1 << 2)
+#define MALLOC_CAP_SPIRAM  (1 << 10)
+#define heap_caps_malloc(size, caps)  malloc(size)
+#define heap_caps_free(ptr)           free(ptr)
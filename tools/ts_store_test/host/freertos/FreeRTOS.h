@@ -0,0 +1,6 @@
+/* HOST stand-in of FreeRTOS.h (ts_store_test) */
+#pragma once
+#include <stdint.h>
+typedef uint32_t TickType_t;
+#define portMAX_DELAY  ((TickType_t)0xFFFFFFFF)
+#define pdTRUE         (1)
@@ -0,0 +1,12 @@
+/* HOST stand-in of semphr.h (ts_store_test): mutex = pthread mutex */
+#pragma once
+#include <pthread.h>
+#include <stdlib.h>
+typedef pthread_mutex_t *SemaphoreHandle_t;
+static inline SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{ SemaphoreHandle_t m = malloc(sizeof(*m));
+  if (m) { pthread_mutex_init(m, NULL); }
+  return m;
+}
+static inline int xSemaphoreTake(SemaphoreHandle_t m, TickType_t ticks) { (void)ticks; return pthread_mutex_lock(m) == 0; }
+static inline int xSemaphoreGive(SemaphoreHandle_t m)                   { return pthread_mutex_unlock(m) == 0; }
@@ -0,0 +1,5 @@
+/* HOST stand-in of the ESP-IDF sdkconfig.h: menuconfig of TimeSeries_Store for ts_store_test */
+#pragma once
+#define CONFIG_TS_STORE_RAM_KB       256
+#define CONFIG_TS_STORE_PSRAM_KB     0
+#define CONFIG_TS_STORE_BLOCK_BYTES  250    /* NOT a multiple of 8: the store rounds it up */
@@ -0,0 +1,164 @@
+/*############################################################################
+  ts_store_test: HOST round trip of the time-series store (TimeSeries_Store.c)
+  ----------------------------------------------------------------------------
+  (1) 20000 meter-like samples (grid with jitter, gaps, a clock going back,
+      repeated & changing values, NaN, -0): every sample must come back with
+      the same time and the same float bits.
+  (2) Time range & downsampled query: count, min, max & mean per bucket
+      like computed from the samples appended.
+  (3) Ring overflow: random values until old blocks are dropped: the query
+      gives exactly the newest samples held, the counters add up.
+  (4) A callback that stops the query.
+  Exit code 0 = all passed.
+#############################################################################*/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include "TimeSeries_Store.h"
+
+#define TEST_SAMPLES   (20000)          // Samples of the round trip (series 0)
+#define TEST_RANDOM    (60000)          // Samples of the ring overflow (series 1): more than fit
+#define TEST_STEP_MS   (60000)          // Bucket of the downsampled query
+
+typedef struct { int64_t t_ms; float value; } test_sample_t;
+
+static test_sample_t test_Ref[TEST_RANDOM];     // Samples as the store has to give them back
+static test_sample_t test_Got[TEST_RANDOM];     // Points of a query (step 0)
+static ts_point_t    test_Buckets[TEST_SAMPLES];
+static size_t        test_NumGot, test_NumBuckets;
+static int           test_Bad;
+
+static uint32_t test_Seed = 4711;
+static uint32_t Test_Rand(void) { test_Seed = test_Seed * 1664525u + 1013904223u; return test_Seed >> 8; }
+
+static uint32_t Test_Bits(float v) { uint32_t b; memcpy(&b, &v, sizeof(b)); return b; }
+
+static void Test_Check(bool ok, const char *what)
+{ printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+  if (!ok) { test_Bad++; }
+}
+
+static bool Test_Collect(void *ctx, const ts_point_t *p)
+{ (void)ctx;
+  if (p->n != 1 || Test_Bits(p->min) != Test_Bits(p->max)) { test_Bad++; } // Step 0: every point is ONE sample
+  test_Got[test_NumGot].t_ms  = p->t_ms;
+  test_Got[test_NumGot].value = p->value;
+  test_NumGot++;
+  return true;
+}
+
+static bool Test_Collect_Bucket(void *ctx, const ts_point_t *p)
+{ (void)ctx;
+  test_Buckets[test_NumBuckets++] = *p;
+  return true;
+}
+
+static bool Test_Stop_After(void *ctx, const ts_point_t *p)
+{ (void)p;
+  size_t *left = ctx;
+  return --(*left) > 0;
+}
+
+/*--------------------------------
+  Query [from, to] with step 0 & compare with test_Ref[first .. first+num)
+----------------------------------*/
+static bool Test_Query_Equals(ts_store_handle_t st, size_t series, int64_t from, int64_t to, size_t first, size_t num)
+{ test_NumGot = 0;
+  size_t n = TS_Store_Query(st, series, from, to, 0, Test_Collect, NULL);
+  if (n != num || test_NumGot != num) { printf("     %zu points, expected %zu\n", test_NumGot, num); return false; }
+  for (size_t k = 0; k < num; k++) {
+      const test_sample_t *r = &test_Ref[first + k], *g = &test_Got[k];
+      if (g->t_ms != r->t_ms || Test_Bits(g->value) != Test_Bits(r->value)) {
+          printf("     point %zu: %lld ms %g, expected %lld ms %g\n", k, (long long)g->t_ms, g->value, (long long)r->t_ms, r->value);
+          return false; } }
+  return true;
+}
+
+int main(void)
+{ ts_store_handle_t st;
+  ts_store_info_t info;
+  if (TS_Store_Create(2, &st) != ESP_OK) { printf("FAIL store not created\n"); return 1; }
+  //-------------------------------------------------
+  // (1) Round trip of meter-like samples
+  //-------------------------------------------------
+  int64_t t = 1700000000000LL;                  // Epoch ms: large times like the firmware
+  float   v = 230.0f;
+  for (int k = 0; k < TEST_SAMPLES; k++) {
+      uint32_t r = Test_Rand();
+      if      (r % 97 == 0)  { t += 1000 + (int64_t)(r % 5000); }          // Gap
+      else if (r % 13 == 0)  { t += 1000 + (int64_t)(r % 40) - 20; }       // Jitter
+      else                   { t += 1000; }                                 // Grid
+      int64_t t_in = (k == 5000) ? t - 3000 : t;                          // Clock goes back: stored as the last time
+      if      (r % 7 == 0)   { v = roundf((v + ((int)(r % 201) - 100) / 10.0f) * 10.0f) / 10.0f; } // Changed, 1 digit
+      else if (r % 501 == 0) { v = (r & 1) ? NAN : -0.0f; }                // Special values
+      else if (isnan(v))     { v = 229.5f; }
+      TS_Store_Append(st, 0, t_in, v);
+      test_Ref[k].t_ms  = (k == 5000) ? test_Ref[k - 1].t_ms : t_in;      // Never backwards
+      test_Ref[k].value = v;
+      if (k == 5000) { t = test_Ref[k].t_ms; } }
+  TS_Store_Get_Info(st, 0, &info);
+  printf("     %u samples in %zu bytes (%.2f bytes/sample)\n", (unsigned)info.samples, info.bytes_used, (double)info.bytes_used / info.samples);
+  Test_Check(info.samples == TEST_SAMPLES && info.appended == TEST_SAMPLES, "round trip: all samples held");
+  Test_Check(info.first_t_ms == test_Ref[0].t_ms && info.last_t_ms == test_Ref[TEST_SAMPLES - 1].t_ms, "round trip: first & last time");
+  Test_Check(Test_Query_Equals(st, 0, INT64_MIN, INT64_MAX, 0, TEST_SAMPLES), "round trip: every time & value bit-exact");
+  //-------------------------------------------------
+  // (2) Time range & downsampling
+  //-------------------------------------------------
+  size_t a = 7000, b = 12345;                   // Range of the reference samples
+  Test_Check(Test_Query_Equals(st, 0, test_Ref[a].t_ms, test_Ref[b].t_ms, a, b - a + 1), "time range: only the samples within");
+  int64_t from = test_Ref[a].t_ms - 123;
+  test_NumBuckets = 0;
+  TS_Store_Query(st, 0, from, test_Ref[b].t_ms, TEST_STEP_MS, Test_Collect_Bucket, NULL);
+  bool ok = true;
+  size_t k = a, num_buckets = 0;
+  while (k <= b && ok) {                        // Rebuild the buckets from the reference
+      int64_t start = from + (test_Ref[k].t_ms - from) / TEST_STEP_MS * TEST_STEP_MS;
+      uint32_t n = 0;
+      double sum = 0;
+      float mn = test_Ref[k].value, mx = mn;
+      for (; k <= b && test_Ref[k].t_ms < start + TEST_STEP_MS; k++, n++) {
+          float x = test_Ref[k].value;
+          if (x < mn) { mn = x; }
+          if (x > mx) { mx = x; }
+          sum += x; }
+      const ts_point_t *p = &test_Buckets[num_buckets++];
+      float mean = (float)(sum / n);
+      ok = num_buckets <= test_NumBuckets && p->t_ms == start && p->n == n &&
+           Test_Bits(p->min) == Test_Bits(mn) && Test_Bits(p->max) == Test_Bits(mx) &&
+           (Test_Bits(p->value) == Test_Bits(mean) || fabsf(p->value - mean) <= 1e-4f * fabsf(mean));
+      if (!ok) { printf("     bucket %zu: %lld ms n %u, expected %lld ms n %u\n", num_buckets - 1, (long long)p->t_ms, (unsigned)p->n, (long long)start, (unsigned)n); } }
+  Test_Check(ok && num_buckets == test_NumBuckets, "downsampled: count, min, max & mean of every bucket");
+  //-------------------------------------------------
+  // (3) Ring overflow
+  //-------------------------------------------------
+  t = 1000;
+  for (int j = 0; j < TEST_RANDOM; j++) {
+      uint32_t r = Test_Rand();
+      float x;
+      uint32_t bits = r * 2654435761u;
+      memcpy(&x, &bits, sizeof(x));             // ANY float bits: the worst case of the compression
+      t += 1 + (r % 3000);
+      TS_Store_Append(st, 1, t, x);
+      test_Ref[j].t_ms  = t;
+      test_Ref[j].value = x; }
+  TS_Store_Get_Info(st, 1, &info);
+  printf("     %u of %u samples held in %zu bytes\n", (unsigned)info.samples, (unsigned)info.appended, info.bytes_total);
+  Test_Check(info.appended == TEST_RANDOM && info.samples > 0 && info.samples < TEST_RANDOM, "ring overflow: oldest blocks dropped");
+  Test_Check(info.bytes_used <= info.bytes_total, "ring overflow: within the memory of the series");
+  size_t held = info.samples;
+  Test_Check(Test_Query_Equals(st, 1, INT64_MIN, INT64_MAX, TEST_RANDOM - held, held), "ring overflow: the newest samples bit-exact");
+  Test_Check(info.first_t_ms == test_Ref[TEST_RANDOM - held].t_ms, "ring overflow: first time = oldest sample held");
+  TS_Store_Get_Info(st, 0, &info);
+  Test_Check(info.samples == TEST_SAMPLES, "ring overflow: other series untouched");
+  //-------------------------------------------------
+  // (4) Callback stops the query
+  //-------------------------------------------------
+  size_t left = 10;
+  Test_Check(TS_Store_Query(st, 0, INT64_MIN, INT64_MAX, 0, Test_Stop_After, &left) == 10, "callback stops after 10 points");
+  Test_Check(TS_Store_Append(st, 2, 0, 0) == ESP_ERR_INVALID_ARG, "unknown series refused");
+
+  printf("%s\n", test_Bad ? "FAILED" : "all passed");
+  return test_Bad ? 1 : 0;
+}